@@ -0,0 +1,113 @@
+/**
+ * @file ArenaBench.cpp
+ * @brief Contention benchmark of ffGraph::MemoryManagement::LinearAllocator against a single mutex bump
+ * allocator, from 1 to 64 threads.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "LinearAlloc.h"
+
+namespace ffGraph {
+namespace MemoryManagement {
+LinearAllocator *GAlloc = nullptr;
+}    // namespace MemoryManagement
+}    // namespace ffGraph
+
+using namespace ffGraph::MemoryManagement;
+
+/**
+ * @brief Previous LinearAllocator design : one bump pointer behind a global mutex.
+ */
+class MutexBumpAllocator {
+   public:
+    explicit MutexBumpAllocator(ChunkPool& pPool) : Pool(pPool) {}
+    ~MutexBumpAllocator( ) {
+        for (auto& c : Chunks) Pool.Recycle(c);
+    }
+
+    void *Allocate(size_t size, size_t alignment) {
+        std::lock_guard<std::mutex> Guard(Lock);
+        size_t Address = (Current + alignment - 1) / alignment * alignment;
+        if (Current == 0 || Address + size > End) {
+            MemoryChunk c = Pool.Acquire(Pool.GetChunkSize( ));
+            Chunks.push_back(c);
+            Current = (size_t)c.Memory;
+            End = Current + c.Size;
+            Address = (Current + alignment - 1) / alignment * alignment;
+        }
+        Current = Address + size;
+        return (void *)Address;
+    }
+
+   private:
+    ChunkPool& Pool;
+    std::vector<MemoryChunk> Chunks;
+    size_t Current = 0;
+    size_t End = 0;
+    std::mutex Lock;
+};
+
+/**
+ * @brief Allocation sizes look like the import : small index/label arrays and a few bigger vertex arrays.
+ */
+static size_t NextSize(uint32_t& State) {
+    State = State * 1664525u + 1013904223u;
+    return ((State >> 24) < 8) ? 4096 + (State & 0x3fff) : 16 + ((State >> 8) & 0x1ff);
+}
+
+template <typename Allocator>
+static double Run(Allocator& Alloc, size_t ThreadCount, size_t AllocationsPerThread) {
+    std::vector<std::thread> Threads;
+    auto Start = std::chrono::steady_clock::now( );
+
+    for (size_t t = 0; t < ThreadCount; ++t) {
+        Threads.emplace_back([&Alloc, t, AllocationsPerThread]( ) {
+            uint32_t State = (uint32_t)t * 7919u + 1u;
+            for (size_t i = 0; i < AllocationsPerThread; ++i) {
+                size_t Size = NextSize(State);
+                char *p = (char *)Alloc.Allocate(Size, sizeof(float));
+                // Touch the memory so cache-line sharing between threads shows up in the timings.
+                p[0] = (char)i;
+                p[Size - 1] = (char)i;
+            }
+        });
+    }
+    for (auto& t : Threads) t.join( );
+    std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now( ) - Start;
+    return (double)(ThreadCount * AllocationsPerThread) / Elapsed.count( );
+}
+
+int main(int ac, char **av) {
+    size_t AllocationsPerThread = 200000;
+    size_t MaxThreads = 64;
+
+    for (int i = 1; i < ac; ++i) {
+        if (strcmp(av[i], "-Allocations") == 0 && i + 1 < ac)
+            AllocationsPerThread = (size_t)atol(av[i + 1]);
+        else if (strcmp(av[i], "-MaxThreads") == 0 && i + 1 < ac)
+            MaxThreads = (size_t)atol(av[i + 1]);
+    }
+    ChunkPool Pool;
+
+    printf("%8s %16s %16s %8s\n", "Threads", "Mutex (M/s)", "Arena (M/s)", "Speedup");
+    for (size_t ThreadCount = 1; ThreadCount <= MaxThreads; ThreadCount *= 2) {
+        double MutexRate, ArenaRate;
+        {
+            MutexBumpAllocator Alloc(Pool);
+            MutexRate = Run(Alloc, ThreadCount, AllocationsPerThread);
+        }
+        {
+            LinearAllocator Alloc(Pool);
+            ArenaRate = Run(Alloc, ThreadCount, AllocationsPerThread);
+        }
+        printf("%8zu %16.2f %16.2f %7.2fx\n", ThreadCount, MutexRate / 1e6, ArenaRate / 1e6, ArenaRate / MutexRate);
+    }
+    ChunkPoolStats Stats = Pool.GetStats( );
+    printf("Pool : %zu chunks, peak reserved %zu MB\n", Stats.ChunkCount, Stats.PeakReserved >> 20);
+    return 0;
+}
@@ -4,15 +4,16 @@
 
 layout(location = 0) in vec2 position;
 layout(location = 1) in vec4 colorIn;
+layout(location = 2) in vec4 colorPrevious;
 layout(location = 0) out vec4 colorOut;
 
 layout(push_constant) uniform PushConstant {
 	mat4 ViewProj;
-	mat4 Model;
+	float ColorBlend;
 } PushConst;
 
 void main()
 {
-	colorOut = colorIn;
-	gl_Position = PushConst.ViewProj * PushConst.Model * vec4(position, 0.0, 1.0);
+	colorOut = mix(colorIn, colorPrevious, PushConst.ColorBlend);
+	gl_Position = PushConst.ViewProj * vec4(position, 0.0, 1.0);
 }
\ No newline at end of file
@@ -4,16 +4,17 @@
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec4 colorIn;
+layout(location = 2) in vec4 colorPrevious;
 
 layout(location = 0) out vec4 colorOut;
 
 layout(push_constant) uniform PushConstant {
 	mat4 ViewProj;
-	mat4 Model;
+	float ColorBlend;
 } PushConst;
 
 void main()
 {
-	colorOut = colorIn;
-	gl_Position = PushConst.ViewProj * PushConst.Model * vec4(position, 1.0);
+	colorOut = mix(colorIn, colorPrevious, PushConst.ColorBlend);
+	gl_Position = PushConst.ViewProj * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -4,19 +4,20 @@
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec4 colorIn;
+layout(location = 2) in vec4 colorPrevious;
 
 layout(location = 0) out vec4 colorOut;
 
 layout(push_constant) uniform PushConstant {
 	mat4 ViewProj;
-	mat4 Model;
+	float ColorBlend;
 } PushConst;
 
 void main()
 {
-	colorOut = colorIn;
+	colorOut = mix(colorIn, colorPrevious, PushConst.ColorBlend);
     float scale = 1000.0f;
 
     vec4 ScaledPosition = vec4(position, 1.0) * scale;
-	gl_Position = PushConst.ViewProj * PushConst.Model * ScaledPosition;
+	gl_Position = PushConst.ViewProj * ScaledPosition;
 }
\ No newline at end of file
@@ -6,6 +6,9 @@
 #include "ffClient.h"
 #include "Vulkan/Instance.h"
 #include "JSON/ThreadQueue.h"
+#include "JSON/Payload.h"
+#include "JSON/HostResidency.h"
+#include "util/ChunkPool.h"
 namespace ffGraph {
 
 struct ffAppCreateInfos {
@@ -13,19 +16,43 @@ struct ffAppCreateInfos {
     std::string Port;
     uint32_t width;
     uint32_t height;
+    bool OptimizeMesh;
+    float ClipPercentile;
+    JSON::SpillSettings Spill;
+    std::string File;
+    JSON::HostResidencySettings Residency;
+    MemoryManagement::ChunkBackend Arena;
+    // @brief Bytes of chunks touched in the background at startup, 0 disables prefaulting.
+    size_t Prefault;
+    // @brief Memory counters are written to this JSON file at exit, when not empty.
+    std::string MemoryDump;
+    // @brief Plot replacements replayed from File, see ffGraph::Vulkan::SoakTest.
+    Vulkan::SoakSettings Soak;
+    // @brief Number of plots kept on screen, the least recently updated ones are removed first. 0 keeps them all.
+    uint32_t KeepPlots;
+    // @brief Bytes of geometry kept in VRAM, hidden and least recently viewed plots leave it first. 0 means no limit.
+    size_t VramBudget;
+    // @brief Bytes of the staging ring uploads are written to, see ffGraph::Vulkan::StagingRing.
+    size_t StagingSize;
+    // @brief Fragmentation of the geometry heap starting its compaction, see ffGraph::Vulkan::HeapCompaction.
+    float CompactionThreshold;
+    // @brief Time steps kept in VRAM for playback, and the bytes they may take, see ffGraph::Vulkan::TimeSeries.
+    uint32_t TimeSteps;
+    size_t TimeBudget;
 };
 
 struct ffApp {
-    std::shared_ptr<std::deque<std::string>> SharedQueue;
+    std::shared_ptr<JSON::PayloadQueue> SharedQueue;
     JSON::ThreadSafeQueue GeometryQueue;
     std::thread ClientThread;
+    std::thread LoaderThread;
     uint16_t GeometryInternID = 0;
     Vulkan::Instance vkInstance;
 };
 
 ffAppCreateInfos ffGetAppCreateInfos(int ac, char** av);
 
-bool ffAppInitialize(ffAppCreateInfos pCreateInfos, std::shared_ptr<std::deque<std::string>>& SharedQueue, ffApp& App);
+bool ffAppInitialize(ffAppCreateInfos pCreateInfos, std::shared_ptr<JSON::PayloadQueue>& SharedQueue, ffApp& App);
 
 }    // namespace ffGraph
 
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include "ContentCache.h"
+
+namespace ffGraph {
+namespace JSON {
+
+ContentCache GContentCache;
+
+bool ContentCache::Find(const Hash128& Hash, ConstructedGeometry& g)
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    for (const auto& e : Entries) {
+        if (e.Hash != Hash)
+            continue;
+        std::shared_ptr<MemoryManagement::LinearAllocator> Arena = e.Arena.lock( );
+        if (!Arena)
+            break;
+        g.Geo = e.Geo;
+        g.Arena = std::move(Arena);
+        g.ContentHash = Hash;
+        g.PositionHash = e.PositionHash;
+        Stats.Hits++;
+        return true;
+    }
+    Stats.Misses++;
+    return false;
+}
+
+void ContentCache::Remember(const ConstructedGeometry& g)
+{
+    if (g.ContentHash.Empty( ) || !g.Arena || g.Geo.Data.Data == nullptr)
+        return;
+    std::lock_guard<std::mutex> Guard(Lock);
+    Entries.erase(std::remove_if(Entries.begin( ), Entries.end( ),
+                                 [&g](const Entry& e) { return e.Arena.expired( ) || e.Hash == g.ContentHash; }),
+                  Entries.end( ));
+    if (Entries.size( ) >= MaxEntries)
+        Entries.erase(Entries.begin( ));
+    Entry e;
+    e.Hash = g.ContentHash;
+    e.PositionHash = g.PositionHash;
+    e.Geo = g.Geo;
+    e.Arena = g.Arena;
+    Entries.push_back(e);
+}
+
+ContentCacheStats ContentCache::GetStats( )
+{
+    std::lock_guard<std::mutex> Guard(Lock);
+    ContentCacheStats s = Stats;
+    s.Entries = Entries.size( );
+    return s;
+}
+
+}    // namespace JSON
+}    // namespace ffGraph
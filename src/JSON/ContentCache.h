@@ -0,0 +1,66 @@
+/**
+ * @file ContentCache.h
+ * @brief Geometries already constructed, found back by the hash of the arrays they were built from so a
+ * resent mesh skips its construction.
+ */
+#ifndef CONTENT_CACHE_H_
+#define CONTENT_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Geometry.h"
+#include "Hash.h"
+
+namespace ffGraph {
+namespace JSON {
+
+struct ContentCacheStats {
+    // @brief Geometries whose construction was skipped, and the ones constructed.
+    size_t Hits = 0;
+    size_t Misses = 0;
+    size_t Entries = 0;
+};
+
+/**
+ * @brief Constructed geometries by content hash. Entries don't keep their arena alive : once every geometry
+ * built from a message is gone (or its host copy dropped, see HostResidency.h) its entries stop matching.
+ */
+class ContentCache {
+   public:
+    static constexpr size_t MaxEntries = 256;
+
+    /**
+     * @brief Fill g with the constructed data of Hash, sharing its arena.
+     *
+     * @return bool - false if Hash isn't known or its arena was released, g must then be constructed.
+     */
+    bool Find(const Hash128& Hash, ConstructedGeometry& g);
+    /**
+     * @brief Remember a geometry which was just constructed, the oldest entry goes over MaxEntries.
+     */
+    void Remember(const ConstructedGeometry& g);
+    ContentCacheStats GetStats( );
+
+   private:
+    struct Entry {
+        Hash128 Hash;
+        Hash128 PositionHash;
+        Geometry Geo;
+        std::weak_ptr<MemoryManagement::LinearAllocator> Arena;
+    };
+
+    std::mutex Lock;
+    // @brief Oldest first.
+    std::vector<Entry> Entries;
+    ContentCacheStats Stats;
+};
+
+extern ContentCache GContentCache;
+
+}    // namespace JSON
+}    // namespace ffGraph
+
+#endif    // CONTENT_CACHE_H_
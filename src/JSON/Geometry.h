@@ -1,10 +1,16 @@
 #ifndef GEOMETRY_H_
 #define GEOMETRY_H_
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <vulkan/vulkan.h>
+#include <memory>
 #include <string>
+#include <vector>
 #include "Array.h"
+#include "Hash.h"
 #include "../ffTypes.h"
 
 namespace ffGraph
@@ -15,6 +21,34 @@ struct Vertex {
     float r, g, b, a;
 };
 
+/**
+ * @brief Attributes of a Vertex, each one is uploaded to its own range of the geometry heap and bound to
+ * its own vertex binding, so a geometry only differing by its colours reuses the positions already there.
+ */
+enum GeometryStream : uint8_t {
+    GEO_STREAM_POSITION,
+    GEO_STREAM_COLOR,
+    GEO_STREAM_COUNT
+};
+
+inline size_t StreamAttributeOffset(uint8_t Stream) {
+    return (Stream == GEO_STREAM_POSITION) ? offsetof(Vertex, x) : offsetof(Vertex, r);
+}
+
+inline size_t StreamStride(uint8_t Stream) {
+    return (Stream == GEO_STREAM_POSITION) ? sizeof(float) * 3 : sizeof(float) * 4;
+}
+
+// @brief Vertex binding of the colour stream blended in during time series playback, see
+// ffGraph::Vulkan::TimeSeries.
+constexpr uint32_t GEO_BINDING_NEXT_COLOR = GEO_STREAM_COUNT;
+
+// @brief Block and offset of a stream in the geometry heap.
+struct StreamRange {
+    uint32_t Block = 0;
+    VkDeviceSize Offset = 0;
+};
+
 enum GeometryPrimitiveTopology : uint16_t {
     GEO_PRIMITIVE_TOPOLOGY_POINT_LIST = VK_PRIMITIVE_TOPOLOGY_POINT_LIST,
     GEO_PRIMITIVE_TOPOLOGY_LINE_LIST = VK_PRIMITIVE_TOPOLOGY_LINE_LIST,
@@ -41,19 +75,108 @@ struct Geometry {
     Array Data;
 
     GeometryDescriptor Description;
-    VkDeviceSize BufferOffset;
+    // @brief Where each attribute of the vertices is in the geometry heap, see GeometryStream.
+    StreamRange Streams[GEO_STREAM_COUNT];
 
     inline size_t count() { return Data.ElementCount; }
     inline size_t size() { return Data.ElementCount * Data.ElementSize; }
+    inline size_t streamSize(uint8_t Stream) const { return Data.ElementCount * StreamStride(Stream); }
+};
+
+/**
+ * @brief Hash of the positions of a geometry's vertices, taken on the import thread right after its
+ * construction, see ffGraph::ConstructedGeometry::PositionHash.
+ */
+inline Hash128 HashPositions(const Geometry& Geo) {
+    ContentHasher h;
+    h.AddStrided((const uint8_t *)Geo.Data.Data + StreamAttributeOffset(GEO_STREAM_POSITION), Geo.Data.ElementCount,
+                 StreamStride(GEO_STREAM_POSITION), Geo.Data.ElementSize);
+    return h.Finish( );
+}
+
+/**
+ * @brief Where the host copy of a geometry lives once it is uploaded (see HostResidency.h).
+ */
+enum HostResidencyState : uint8_t {
+    HOST_STATE_RESIDENT,
+    HOST_STATE_COMPRESSED,
+    HOST_STATE_RELEASED
+};
+
+/**
+ * @brief Axis aligned box of the vertices, kept when the host copy is dropped.
+ */
+struct GeometryBounds {
+    float Min[3] = {0.f, 0.f, 0.f};
+    float Max[3] = {0.f, 0.f, 0.f};
 };
 
+/**
+ * @brief Generation shared by every geometry built from a new message or file.
+ */
+inline uint32_t NewGeometryGeneration( ) {
+    static std::atomic<uint32_t> Next(1);
+    return Next++;
+}
+
 struct ConstructedGeometry {
     uint16_t PlotID;
     std::string Name;
     uint16_t MeshID;
+    // @brief Message the geometry was built from : a newer generation replaces the same (PlotID, MeshID).
+    uint32_t Generation = 0;
+    // @brief 0 for the mesh and its border, n for the n-th field of IsoArray drawn on it, see
+    // ffGraph::Vulkan::MeshFields.
+    uint16_t FieldID = 0;
 
+    ConstructedGeometry( ) : PlotID(0), MeshID(0) {}
     ConstructedGeometry(uint16_t pID, uint16_t mID) : PlotID(pID), MeshID(mID) {}
+
+    // Geometries are moved from the import to the queue and then to the graph, never copied.
+    ConstructedGeometry(ConstructedGeometry&&) = default;
+    ConstructedGeometry& operator=(ConstructedGeometry&&) = default;
+    ConstructedGeometry(const ConstructedGeometry&) = delete;
+    ConstructedGeometry& operator=(const ConstructedGeometry&) = delete;
+
     Geometry Geo;
+    // @brief Arena holding Geo.Data, shared by the geometries of a message and released with the last one.
+    std::shared_ptr<MemoryManagement::LinearAllocator> Arena;
+
+    uint8_t HostState = HOST_STATE_RESIDENT;
+    GeometryBounds Bounds;
+    // @brief Shuffled and LZ compressed Geo.Data when HostState is HOST_STATE_COMPRESSED.
+    std::vector<uint8_t> Compressed;
+
+    // @brief Whether the geometry is in the geometry heap, see ffGraph::Vulkan::UpdateGpuResidency.
+    bool GpuResident = true;
+    // @brief Whether its plot is shown, hidden geometries are skipped by the draws.
+    bool Visible = true;
+    // @brief Decompressed Geo.Data waiting for its upload to the geometry heap.
+    std::vector<uint8_t> Staged;
+    // @brief Transfer batch copying it to the geometry heap, it is drawn once the batch is done.
+    uint64_t UploadID = 0;
+    // @brief Copy back from the geometry heap in flight, see ffGraph::Vulkan::StartReadBack. 0 when none.
+    uint64_t ReadBackID = 0;
+    // @brief Hash of its positions, computed on the import thread (see ffGraph::HashPositions). A generation of
+    // the same plot and mesh with the same hash and vertex count shares their stream instead of uploading it
+    // again. Empty when it wasn't computed, which never matches.
+    Hash128 PositionHash;
+    // @brief Hash of the arrays it was built from, see ffGraph::JSON::ContentCache. A geometry in the geometry
+    // heap with the same content shares its streams instead of uploading them again.
+    Hash128 ContentHash;
+
+    // @brief Second range of each stream, written by an in place update while Geo.Streams is drawn, see
+    // ffGraph::Vulkan::UpdateGeometry. BackSlots has a bit per stream having one.
+    StreamRange BackStreams[GEO_STREAM_COUNT];
+    uint8_t BackSlots = 0;
+    // @brief Streams being written to their back range by the batch FlipID, swapped with the front ones once
+    // it is done.
+    uint8_t FlipStreams = 0;
+    uint64_t FlipID = 0;
+    // @brief Frame of the last swap, the previous front ranges are read until FramesInFlight frames later.
+    uint64_t FlipFrame = 0;
+    // @brief Colour streams of the previous updates in place, newest first, see ffGraph::Vulkan::TimeSeries.
+    std::deque<StreamRange> ColorHistory;
 };
 
 } // namespace ffGraph
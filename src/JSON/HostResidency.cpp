@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include "Compress.h"
+#include "CopyCounter.h"
+#include "HostResidency.h"
+#include "Logger.h"
+#include "Parallel.h"
+
+namespace ffGraph {
+namespace JSON {
+
+HostResidencySettings GHostResidency;
+
+bool ParseHostResidencyPolicy(const char *Name, HostResidencyPolicy& Policy)
+{
+    if (strcmp(Name, "keep") == 0)
+        Policy = HOST_RESIDENCY_KEEP;
+    else if (strcmp(Name, "release") == 0)
+        Policy = HOST_RESIDENCY_RELEASE;
+    else if (strcmp(Name, "compressed") == 0)
+        Policy = HOST_RESIDENCY_COMPRESSED;
+    else
+        return false;
+    return true;
+}
+
+void ComputeBounds(ConstructedGeometry& g)
+{
+    const Array& a = g.Geo.Data;
+    if (a.Data == nullptr || a.ElementCount == 0 || a.ElementSize < 3 * sizeof(float))
+        return;
+    GeometryBounds b;
+    for (int k = 0; k < 3; ++k) {
+        b.Min[k] = FLT_MAX;
+        b.Max[k] = -FLT_MAX;
+    }
+    const char *Base = (const char *)a.Data;
+    for (size_t i = 0; i < a.ElementCount; ++i) {
+        const float *p = (const float *)(Base + i * a.ElementSize);
+        for (int k = 0; k < 3; ++k) {
+            b.Min[k] = std::min(b.Min[k], p[k]);
+            b.Max[k] = std::max(b.Max[k], p[k]);
+        }
+    }
+    g.Bounds = b;
+}
+
+static void CompressGeometry(ConstructedGeometry& g)
+{
+    if (g.HostState != HOST_STATE_RESIDENT || g.Geo.Data.Data == nullptr)
+        return;
+    Compression::CompressShuffled(g.Geo.Data.Data, g.Geo.size( ), g.Geo.Data.ElementSize, g.Compressed);
+    g.HostState = HOST_STATE_COMPRESSED;
+}
+
+static void ReleaseGeometry(ConstructedGeometry& g)
+{
+    std::vector<uint8_t>( ).swap(g.Compressed);
+    g.HostState = HOST_STATE_RELEASED;
+}
+
+/**
+ * @brief The uncompressed data isn't reachable anymore once no geometry of the arena is resident.
+ */
+static void DropArenas(std::vector<ConstructedGeometry>& Geometries)
+{
+    for (auto& g : Geometries) {
+        if (g.HostState != HOST_STATE_RESIDENT) {
+            g.Geo.Data.Data = nullptr;
+            g.Arena.reset( );
+        }
+    }
+}
+
+/**
+ * @brief Apply Func to every geometry of the oldest group of geometries (same arena) in state From.
+ *
+ * @return size_t - Number of geometries changed, 0 when no geometry is in state From.
+ */
+template <typename Func>
+static size_t DegradeOldestGroup(std::vector<ConstructedGeometry>& Geometries, uint8_t From, Func&& f)
+{
+    // Compressed copies are the only copy left of the geometries out of the geometry heap.
+    auto Degradable = [From](const ConstructedGeometry& g) {
+        return g.HostState == From && (From != HOST_STATE_COMPRESSED || g.GpuResident);
+    };
+    auto Oldest = std::find_if(Geometries.begin( ), Geometries.end( ), Degradable);
+    if (Oldest == Geometries.end( ))
+        return 0;
+    std::shared_ptr<MemoryManagement::LinearAllocator> Arena = Oldest->Arena;
+    size_t Changed = 0;
+    for (auto& g : Geometries) {
+        if (Degradable(g) && (&g == &*Oldest || (Arena && g.Arena == Arena))) {
+            f(g);
+            Changed += 1;
+        }
+    }
+    return Changed;
+}
+
+static void UpdateStats(const std::vector<ConstructedGeometry>& Geometries, HostMemoryStats& Stats)
+{
+    Stats.Resident = Stats.Compressed = Stats.CompressedRaw = Stats.GpuOnly = 0;
+    for (auto& g : Geometries) {
+        size_t Size = g.Geo.Data.ElementCount * g.Geo.Data.ElementSize;
+        if (g.HostState == HOST_STATE_RESIDENT) {
+            Stats.Resident += Size;
+        } else if (g.HostState == HOST_STATE_COMPRESSED) {
+            Stats.Compressed += g.Compressed.size( );
+            Stats.CompressedRaw += Size;
+        } else {
+            Stats.GpuOnly += Size;
+        }
+    }
+}
+
+void ApplyHostResidency(std::vector<ConstructedGeometry>& Geometries, HostMemoryStats& Stats)
+{
+    if (GHostResidency.Policy == HOST_RESIDENCY_RELEASE) {
+        for (auto& g : Geometries)
+            if (g.GpuResident) ReleaseGeometry(g);
+    } else if (GHostResidency.Policy == HOST_RESIDENCY_COMPRESSED) {
+        std::vector<ConstructedGeometry *> Pending;
+        for (auto& g : Geometries)
+            if (g.HostState == HOST_STATE_RESIDENT) Pending.push_back(&g);
+        ParallelFor(Pending.size( ), [&Pending](size_t Begin, size_t End) {
+            for (size_t i = Begin; i < End; ++i) CompressGeometry(*Pending[i]);
+        }, 1);
+    }
+    UpdateStats(Geometries, Stats);
+
+    // Over budget : compress the oldest resident copies first, then release the oldest compressed ones.
+    while (GHostResidency.Budget != 0 && Stats.Total( ) > GHostResidency.Budget) {
+        size_t Changed = DegradeOldestGroup(Geometries, HOST_STATE_RESIDENT, CompressGeometry);
+        if (Changed == 0)
+            Changed = DegradeOldestGroup(Geometries, HOST_STATE_COMPRESSED, ReleaseGeometry);
+        if (Changed == 0)
+            break;
+        Stats.Evictions += Changed;
+        UpdateStats(Geometries, Stats);
+    }
+    DropArenas(Geometries);
+}
+
+bool KeepCompressedCopy(ConstructedGeometry& g, const void *GpuCopy)
+{
+    if (g.HostState == HOST_STATE_COMPRESSED)
+        return true;
+    if (g.HostState == HOST_STATE_RESIDENT && g.Geo.Data.Data != nullptr) {
+        CompressGeometry(g);
+        return true;
+    }
+    if (GpuCopy == nullptr)
+        return false;
+    Compression::CompressShuffled(GpuCopy, g.Geo.size( ), g.Geo.Data.ElementSize, g.Compressed);
+    g.HostState = HOST_STATE_COMPRESSED;
+    return true;
+}
+
+const uint8_t *PeekGeometryData(const ConstructedGeometry& g)
+{
+    if (!g.Staged.empty( ))
+        return g.Staged.data( );
+    if (g.HostState == HOST_STATE_RESIDENT && g.Geo.Data.Data != nullptr)
+        return (const uint8_t *)g.Geo.Data.Data;
+    return nullptr;
+}
+
+bool ReadGeometryData(const ConstructedGeometry& g, void *Dst)
+{
+    CountCopy(COPY_STAGE_UPLOAD, g.Geo.Data.ElementCount * g.Geo.Data.ElementSize);
+    if (!g.Staged.empty( )) {
+        memcpy(Dst, g.Staged.data( ), g.Staged.size( ));
+        return true;
+    }
+    if (g.HostState == HOST_STATE_RESIDENT && g.Geo.Data.Data != nullptr) {
+        memcpy(Dst, g.Geo.Data.Data, g.Geo.Data.ElementCount * g.Geo.Data.ElementSize);
+        return true;
+    }
+    if (g.HostState == HOST_STATE_COMPRESSED) {
+        if (Compression::DecompressShuffled(g.Compressed, Dst, g.Geo.Data.ElementCount * g.Geo.Data.ElementSize, g.Geo.Data.ElementSize))
+            return true;
+        LogWarning("ReadGeometryData", "Compressed copy of geometry %s is corrupted.", g.Name.c_str( ));
+    }
+    return false;
+}
+
+}    // namespace JSON
+}    // namespace ffGraph
@@ -0,0 +1,103 @@
+/**
+ * @file HostResidency.h
+ * @brief What happens to the host copy of a geometry once it is uploaded to the geometry heap.
+ */
+#ifndef HOST_RESIDENCY_H_
+#define HOST_RESIDENCY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Geometry.h"
+
+namespace ffGraph {
+namespace JSON {
+
+enum HostResidencyPolicy : uint8_t {
+    // @brief Host copies stay as they are, the budget is enforced by compressing then releasing the oldest ones.
+    HOST_RESIDENCY_KEEP,
+    // @brief Host copies are dropped after upload, the geometry heap keeps the only copy.
+    HOST_RESIDENCY_RELEASE,
+    // @brief Host copies are replaced by a compressed copy after upload.
+    HOST_RESIDENCY_COMPRESSED
+};
+
+struct HostResidencySettings {
+    HostResidencyPolicy Policy = HOST_RESIDENCY_KEEP;
+    // @brief Bytes of host copies (resident and compressed) allowed, 0 means no limit.
+    size_t Budget = 0;
+};
+
+/**
+ * @brief Accounting of the host copies of the uploaded geometries.
+ */
+struct HostMemoryStats {
+    // @brief Bytes of uncompressed host copies.
+    size_t Resident = 0;
+    // @brief Bytes of compressed copies, and what they decompress to.
+    size_t Compressed = 0;
+    size_t CompressedRaw = 0;
+    // @brief Bytes of geometries only stored in the geometry heap.
+    size_t GpuOnly = 0;
+    // @brief Geometries compressed or released to respect the budget since startup.
+    size_t Evictions = 0;
+
+    inline size_t Total( ) const { return Resident + Compressed; }
+};
+
+extern HostResidencySettings GHostResidency;
+
+/**
+ * @brief Parse the value of -HostResidency : "keep", "release" or "compressed".
+ *
+ * @return bool - false if Name isn't a policy, Policy is left untouched.
+ */
+bool ParseHostResidencyPolicy(const char *Name, HostResidencyPolicy& Policy);
+
+/**
+ * @brief Compute ffGraph::ConstructedGeometry::Bounds from the host copy, which must still be resident.
+ */
+void ComputeBounds(ConstructedGeometry& g);
+
+/**
+ * @brief Apply ffGraph::JSON::GHostResidency to geometries which were just uploaded, then degrade the oldest
+ * host copies until the budget is respected. Geometries sharing an arena are handled together so the
+ * arena is actually released. The host copy of a geometry out of the geometry heap is never released.
+ *
+ * @param Geometries [in/out] - Uploaded geometries, oldest first.
+ * @param Stats [in/out] - Recomputed accounting, Evictions is accumulated.
+ */
+void ApplyHostResidency(std::vector<ConstructedGeometry>& Geometries, HostMemoryStats& Stats);
+
+/**
+ * @brief Make sure a geometry leaving the geometry heap keeps a compressed host copy, built from its resident
+ * host copy or, once that one was released, from its copy in the geometry heap.
+ *
+ * @param g [in/out] - Geometry, left in HOST_STATE_COMPRESSED.
+ * @param GpuCopy [in] - Geometry heap range of the geometry read back to the host, may be null when g has a
+ * host copy.
+ *
+ * @return bool - false if neither copy was available, the geometry must then stay in the geometry heap.
+ */
+bool KeepCompressedCopy(ConstructedGeometry& g, const void *GpuCopy);
+
+/**
+ * @brief Write the vertex data of a geometry from its host copy, staged, resident or compressed.
+ *
+ * @param g [in] - Geometry.
+ * @param Dst [out] - Destination of g.Geo.size() bytes.
+ *
+ * @return bool - false if the host copy was released (or is corrupted), Dst must then be filled from the GPU.
+ */
+bool ReadGeometryData(const ConstructedGeometry& g, void *Dst);
+/**
+ * @brief Vertex data of a geometry readable in place, staged or resident, without copying it.
+ *
+ * @return const uint8_t * - nullptr if the host copy is compressed or released, see ReadGeometryData.
+ */
+const uint8_t *PeekGeometryData(const ConstructedGeometry& g);
+
+}    // namespace JSON
+}    // namespace ffGraph
+
+#endif    // HOST_RESIDENCY_H_
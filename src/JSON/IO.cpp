@@ -1,7 +1,13 @@
+#include <cstdio>
+#include <cstdlib>
 #include "IO.h"
+#include "Logger.h"
 
 #ifdef __linux__
+    #include <fcntl.h>
     #include <stdio.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
     #include <unistd.h>
 #endif
 
@@ -20,10 +26,136 @@ std::string GetTmpFile(int ID)
     n.append(std::to_string(ID));
 
     return n;
+#else
+    std::string n("ffGraph-");
+    n.append(std::to_string(ID));
+
+    return n;
+#endif
+
+}
+
+static bool WriteBytes(const std::string& Path, const void *Data, size_t Size, const char *Mode)
+{
+    FILE *f = fopen(Path.c_str(), Mode);
+    if (f == nullptr) {
+        LogWarning("IO", "Failed to open %s.", Path.c_str());
+        return false;
+    }
+    bool Success = fwrite(Data, 1, Size, f) == Size;
+    Success = (fclose(f) == 0) && Success;
+    if (!Success)
+        LogWarning("IO", "Failed to write %lu bytes to %s.", (unsigned long)Size, Path.c_str());
+    return Success;
+}
+
+bool WriteFile(const std::string& Path, const void *Data, size_t Size)
+{
+    return WriteBytes(Path, Data, Size, "wb");
+}
+
+bool OpenOutputFile(const std::string& Path, OutputFile& File)
+{
+    File.Handle = fopen(Path.c_str(), "wb");
+    File.Path = Path;
+    if (File.Handle == nullptr) {
+        LogWarning("IO", "Failed to open %s.", Path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool WriteOutputFile(OutputFile& File, const void *Data, size_t Size)
+{
+    if (File.Handle == nullptr || fwrite(Data, 1, Size, File.Handle) != Size) {
+        LogWarning("IO", "Failed to write %lu bytes to %s.", (unsigned long)Size, File.Path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CloseOutputFile(OutputFile& File)
+{
+    if (File.Handle == nullptr)
+        return true;
+    bool Success = fclose(File.Handle) == 0;
+    if (!Success)
+        LogWarning("IO", "Failed to write %s.", File.Path.c_str());
+    File.Handle = nullptr;
+    return Success;
+}
+
+bool MapFile(const std::string& Path, MappedFile& File)
+{
+    File = MappedFile();
+#ifdef __linux__
+    int fd = open(Path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LogWarning("IO", "Failed to open %s.", Path.c_str());
+        return false;
+    }
+    struct stat Infos;
+    if (fstat(fd, &Infos) != 0) {
+        close(fd);
+        return false;
+    }
+    File.Size = (size_t)Infos.st_size;
+    if (File.Size == 0) {
+        close(fd);
+        return true;
+    }
+    void *ptr = mmap(nullptr, File.Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference on the file.
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        LogWarning("IO", "Failed to map %s.", Path.c_str());
+        File = MappedFile();
+        return false;
+    }
+    madvise(ptr, File.Size, MADV_SEQUENTIAL);
+    File.Data = (const uint8_t *)ptr;
+    File.Mapped = true;
+    return true;
+#else
+    FILE *f = fopen(Path.c_str(), "rb");
+    if (f == nullptr) {
+        LogWarning("IO", "Failed to open %s.", Path.c_str());
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long Size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *Buffer = (Size > 0) ? (uint8_t *)malloc((size_t)Size) : nullptr;
+    if (Size > 0 && (Buffer == nullptr || fread(Buffer, 1, (size_t)Size, f) != (size_t)Size)) {
+        free(Buffer);
+        fclose(f);
+        LogWarning("IO", "Failed to read %s.", Path.c_str());
+        return false;
+    }
+    fclose(f);
+    File.Data = Buffer;
+    File.Size = (Size > 0) ? (size_t)Size : 0;
+    return true;
 #endif
+}
+
+void UnmapFile(MappedFile& File)
+{
+    if (File.Data != nullptr) {
+#ifdef __linux__
+        munmap((void *)File.Data, File.Size);
+#else
+        free((void *)File.Data);
+#endif
+    }
+    File = MappedFile();
+}
 
+void RemoveFile(const std::string& Path)
+{
+    remove(Path.c_str());
 }
 
 }
 }
-}
\ No newline at end of file
+}
@@ -1,6 +1,9 @@
 #ifndef IO_H_
 #define IO_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
 #include <string>
 
@@ -10,8 +13,80 @@ namespace IO {
 
 std::string GetTmpFile(int ID);
 
+/**
+ * @brief Read only view of a whole file. Memory mapped when the platform allows it, read in a heap buffer
+ * otherwise.
+ */
+struct MappedFile {
+    const uint8_t *Data = nullptr;
+    size_t Size = 0;
+    bool Mapped = false;
+};
+
+/**
+ * @brief Create (or truncate) a file and write Size bytes to it.
+ *
+ * @param Path [in] - File path, usually from ffGraph::JSON::IO::GetTmpFile.
+ * @param Data [in] - Bytes to write.
+ * @param Size [in] - Number of bytes.
+ *
+ * @return bool - false if the file couldn't be written.
+ */
+bool WriteFile(const std::string& Path, const void *Data, size_t Size);
+
+/**
+ * @brief File kept open while a message is written to it piece by piece.
+ */
+struct OutputFile {
+    FILE *Handle = nullptr;
+    std::string Path;
+
+    inline bool IsOpen( ) const { return Handle != nullptr; }
+};
+
+/**
+ * @brief Create (or truncate) a file and keep it open for ffGraph::JSON::IO::WriteOutputFile.
+ *
+ * @return bool - false if the file couldn't be created.
+ */
+bool OpenOutputFile(const std::string& Path, OutputFile& File);
+
+/**
+ * @brief Write Size bytes at the end of an open file.
+ *
+ * @return bool - false if the file couldn't be written.
+ */
+bool WriteOutputFile(OutputFile& File, const void *Data, size_t Size);
+
+/**
+ * @brief Flush and close a file opened by ffGraph::JSON::IO::OpenOutputFile.
+ *
+ * @return bool - false if the buffered bytes couldn't be written.
+ */
+bool CloseOutputFile(OutputFile& File);
+
+/**
+ * @brief Map a whole file read only.
+ *
+ * @param Path [in] - File to open.
+ * @param File [out] - View on the file content, to release with ffGraph::JSON::IO::UnmapFile.
+ *
+ * @return bool - false if the file couldn't be opened.
+ */
+bool MapFile(const std::string& Path, MappedFile& File);
+
+/**
+ * @brief Release a view created by ffGraph::JSON::IO::MapFile.
+ */
+void UnmapFile(MappedFile& File);
+
+/**
+ * @brief Delete a file, errors are ignored.
+ */
+void RemoveFile(const std::string& Path);
+
 }
 }
 }
 
-#endif // IO_H_
\ No newline at end of file
+#endif // IO_H_
@@ -4,12 +4,20 @@
 #include <future>
 #include <glm/glm.hpp>
 #include "Logger.h"
+#include "utils.h"
 #include "Import.h"
+#include "ContentCache.h"
+#include "Hash.h"
+#include "MeshOptimizer.h"
+#include "Reduce.h"
 #include "IO.h"
+#include "CopyCounter.h"
 
 namespace ffGraph {
 namespace JSON {
 
+ImportSettings GImportSettings;
+
 static GeometryPrimitiveTopology GetMainPrimitiveTopology(std::string& j)
 {
     if (j.compare("Curve2D") == 0 || j.compare("Curve3D") == 0)
@@ -28,7 +36,7 @@ static GeometryPrimitiveTopology GetBorderPrimitiveTopology(std::string& j)
     return GeometryPrimitiveTopology::GEO_PRIMITIVE_TOPOLOGY_COUNT;
 }
 
-Geometry ConstructGeometry(std::vector<float> Vertices, std::vector<uint32_t> Indices, std::vector<int> Labels, LabelTable& Table)
+Geometry ConstructGeometry(const std::vector<float>& Vertices, const std::vector<uint32_t>& Indices, const std::vector<int>& Labels, LabelTable& Table)
 {
     Geometry n;
 
@@ -37,24 +45,24 @@ Geometry ConstructGeometry(std::vector<float> Vertices, std::vector<uint32_t> In
     }
     GenerateColorFromLabels(Table);
 
-    n.Data = ffNewArray(Indices.size(), sizeof(Vertex));
-
-    size_t size = Indices.size();
-    Vertex *ptr = (Vertex *)n.Data.Data;
-    for (size_t i = 0; i < size; ++i) {
-
-        ptr[i].x = Vertices[Indices[i] * 3 + 0];
-        ptr[i].y = Vertices[Indices[i] * 3 + 1];
-        ptr[i].z = Vertices[Indices[i] * 3 + 2];
-        ptr[i].r = 0.f;
-        ptr[i].g = 0.f;
-        ptr[i].b = 0.f;
-        ptr[i].a = 1.f;
-    }
+    TypedArray<Vertex> Out = ffNewTypedArray<Vertex>(Indices.size());
+    n.Data = Out.Untyped();
+    if (Out.Data == nullptr)
+        return n;
+
+    ParallelForEach(Out.View(), [&](Vertex& v, size_t i) {
+        v.x = Vertices[Indices[i] * 3 + 0];
+        v.y = Vertices[Indices[i] * 3 + 1];
+        v.z = Vertices[Indices[i] * 3 + 2];
+        v.r = 0.f;
+        v.g = 0.f;
+        v.b = 0.f;
+        v.a = 1.f;
+    });
     return n;
 }
 
-Geometry ConstructBorder(std::vector<float> Vertices, std::vector<uint32_t> Indices, std::vector<int> Labels, LabelTable& Table)
+Geometry ConstructBorder(const std::vector<float>& Vertices, const std::vector<uint32_t>& Indices, const std::vector<int>& Labels, LabelTable& Table)
 {
     Geometry n;
 
@@ -63,24 +71,34 @@ Geometry ConstructBorder(std::vector<float> Vertices, std::vector<uint32_t> Indi
     }
     GenerateColorFromLabels(Table);
 
-    n.Data = ffNewArray(Indices.size(), sizeof(Vertex));
-
-    size_t size = Indices.size();
-    Vertex *ptr = (Vertex *)n.Data.Data;
-    for (size_t i = 0; i < size; ++i) {
+    TypedArray<Vertex> Out = ffNewTypedArray<Vertex>(Indices.size());
+    n.Data = Out.Untyped();
+    if (Out.Data == nullptr)
+        return n;
 
-        ptr[i].x = Vertices[Indices[i] * 3 + 0];
-        ptr[i].y = Vertices[Indices[i] * 3 + 1];
-        ptr[i].z = Vertices[Indices[i] * 3 + 2];
+    ParallelForEach(Out.View(), [&](Vertex& v, size_t i) {
+        v.x = Vertices[Indices[i] * 3 + 0];
+        v.y = Vertices[Indices[i] * 3 + 1];
+        v.z = Vertices[Indices[i] * 3 + 2];
         const Color& c = GetColor(Table, Labels[i]);
-        ptr[i].r = c.r;
-        ptr[i].g = c.g;
-        ptr[i].b = c.b;
-        ptr[i].a = c.a;
-    }
+        v.r = c.r;
+        v.g = c.g;
+        v.b = c.b;
+        v.a = c.a;
+    });
     return n;
 }
 
+/**
+ * @brief Percentiles the colour range is clipped to, computed exactly by the field reductions.
+ */
+static std::vector<float> ClipRanks()
+{
+    if (GImportSettings.ClipPercentile <= 0.f)
+        return std::vector<float>();
+    return {GImportSettings.ClipPercentile, 1.f - GImportSettings.ClipPercentile};
+}
+
 static glm::vec2 IsoValue(glm::vec2 T[3], glm::vec2 BarycentricPoint)
 {
     glm::mat2 mat(glm::vec2(T[1].x - T[0].x, T[1].y - T[0].y), glm::vec2(T[2].x - T[0].x, T[2].y - T[0].y));
@@ -88,193 +106,430 @@ static glm::vec2 IsoValue(glm::vec2 T[3], glm::vec2 BarycentricPoint)
     return mat * BarycentricPoint + T[0];
 }
 
-Geometry ConstructIsoScalar(std::vector<float>& Vertices, std::vector<uint32_t>& Indices, std::vector<float> Values, std::vector<float>& RefTriangle, std::vector<float>& KSub, float min, float max) {
+Geometry ConstructIsoScalar(const std::vector<float>& Vertices, const std::vector<uint32_t>& Indices, const std::vector<float>& Values, const std::vector<float>& RefTriangle, const std::vector<float>& KSub, float min, float max, const std::vector<uint32_t>& ElementOrder) {
+    MemoryManagement::MemoryTagScope Tag(MemoryManagement::MEMORY_TAG_ISO);
     size_t nsubT = KSub.size() / 3;
     size_t nsubV = RefTriangle.size() / 2;
-    size_t nK = Values.size() / (Indices.size() / 3);
-    std::vector<glm::vec2> Pn(nsubV);
-    size_t count = 0;
-    int o = 0;
+    size_t nT = Indices.size() / 3;
+    size_t nK = Values.size() / nT;
 
     Geometry n;
-    n.Data = ffNewArray((Indices.size() / 3) * nsubT * 3, sizeof(Vertex));
-
-    Vertex *ptr = (Vertex *)n.Data.Data;
-
-    for (size_t i = 0; i < (Indices.size() / 3); ++i) {
-        glm::vec2 triangle[3] = {
-            glm::vec2(Vertices[Indices[i * 3] * 3 + 0], Vertices[Indices[i * 3] * 3 + 1]),
-            glm::vec2(Vertices[Indices[i * 3 + 1] * 3 + 0], Vertices[Indices[i * 3 + 1] * 3 + 1]),
-            glm::vec2(Vertices[Indices[i * 3 + 2] * 3 + 0], Vertices[Indices[i * 3 + 2] * 3 + 1])
-        };
-        for (size_t j = 0; j < nsubV; ++j) {
-            Pn[j] = IsoValue(triangle, glm::vec2(RefTriangle[j * 2], RefTriangle[j * 2 + 1]));
-        }
-        for (size_t sk = 0; sk < nsubT; ++sk) {
-            int i0 = KSub[sk * 3 + 0];
-            int i1 = KSub[sk * 3 + 1];
-            int i2 = KSub[sk * 3 + 2];
-
-            glm::vec3 ff = glm::vec3(Values[o + i0], Values[o + i1], Values[o + i2]);
-            glm::vec2 Pt[3] = {
-                Pn[i0], Pn[i1], Pn[i2]
+    TypedArray<Vertex> Out = ffNewTypedArray<Vertex>(nT * nsubT * 3);
+    n.Data = Out.Untyped();
+    if (Out.Data == nullptr)
+        return n;
+    ArrayView<Vertex> ptr = Out.View();
+
+    // Each triangle writes its own nsubT * 3 vertices, ranges of triangles are independent.
+    ParallelFor(nT, [&](size_t Begin, size_t End) {
+        std::vector<glm::vec2> Pn(nsubV);
+
+        for (size_t i = Begin; i < End; ++i) {
+            size_t e = (ElementOrder.empty()) ? i : ElementOrder[i];
+            size_t o = e * nK;
+            size_t count = i * nsubT * 3;
+            glm::vec2 triangle[3] = {
+                glm::vec2(Vertices[Indices[e * 3] * 3 + 0], Vertices[Indices[e * 3] * 3 + 1]),
+                glm::vec2(Vertices[Indices[e * 3 + 1] * 3 + 0], Vertices[Indices[e * 3 + 1] * 3 + 1]),
+                glm::vec2(Vertices[Indices[e * 3 + 2] * 3 + 0], Vertices[Indices[e * 3 + 2] * 3 + 1])
             };
-
-            for (size_t k = 0; k < 3; ++k) {
-                ptr[count].x = Pt[k].x;
-                ptr[count].y = Pt[k].y;
-                ptr[count].z = 0.f;
-                ptr[count].r = 0.5f;
-                ptr[count].g = (ff[k] - min) / (max - min);
-                ptr[count].b = 0.5f;
-                ptr[count].a = 1.0f;
-                count += 1;
+            for (size_t j = 0; j < nsubV; ++j) {
+                Pn[j] = IsoValue(triangle, glm::vec2(RefTriangle[j * 2], RefTriangle[j * 2 + 1]));
+            }
+            for (size_t sk = 0; sk < nsubT; ++sk) {
+                int i0 = KSub[sk * 3 + 0];
+                int i1 = KSub[sk * 3 + 1];
+                int i2 = KSub[sk * 3 + 2];
+
+                glm::vec3 ff = glm::vec3(Values[o + i0], Values[o + i1], Values[o + i2]);
+                glm::vec2 Pt[3] = {
+                    Pn[i0], Pn[i1], Pn[i2]
+                };
+
+                for (size_t k = 0; k < 3; ++k) {
+                    ptr[count].x = Pt[k].x;
+                    ptr[count].y = Pt[k].y;
+                    ptr[count].z = 0.f;
+                    ptr[count].r = 0.5f;
+                    ptr[count].g = (ff[k] - min) / (max - min);
+                    ptr[count].b = 0.5f;
+                    ptr[count].a = 1.0f;
+                    count += 1;
+                }
             }
         }
-        o += nK;
-    }
+    }, 1024);
     return n;
 }
 
-Geometry ConstructIsoVector(std::vector<float>& Vertices, std::vector<uint32_t>& Indices, std::vector<float> Values, std::vector<float>& RefTriangle, std::vector<float>& KSub, float min, float max) {
-    size_t nsubT = KSub.size() / 3;
+Geometry ConstructIsoVector(const std::vector<float>& Vertices, const std::vector<uint32_t>& Indices, const std::vector<float>& Values, const std::vector<float>& RefTriangle, UNUSED_PARAM(const std::vector<float>& KSub), float min, float max, const std::vector<uint32_t>& ElementOrder) {
+    MemoryManagement::MemoryTagScope Tag(MemoryManagement::MEMORY_TAG_ISO);
     size_t nsubV = RefTriangle.size() / 2;
-    size_t nK = Values.size() / (Indices.size() / 3);
-    std::vector<glm::vec2> Pn(nsubV);
-    size_t count = 0;
-    int o = 0;
-
-    Geometry n;
-    n.Data = ffNewArray(Vertices.size() * nsubT * 2, sizeof(Vertex));
+    size_t nT = Indices.size() / 3;
+    size_t nK = Values.size() / nT;
 
-    for (size_t i = 0; i < Values.size() / 2; ++i) {
-        min = std::min(min, sqrtf(Values[i * 2] * Values[i * 2] + Values[i * 2 + 1] * Values[i * 2 + 1]));
-        max = std::max(max, sqrtf(Values[i * 2] * Values[i * 2] + Values[i * 2 + 1] * Values[i * 2 + 1]));
+    FieldStats Stats = ReduceVectorMagnitude(Values.data(), Values.size() / 2, 2, 0, ClipRanks());
+    if (GImportSettings.ClipPercentile > 0.f) {
+        min = Stats.Percentile(GImportSettings.ClipPercentile);
+        max = Stats.Percentile(1.f - GImportSettings.ClipPercentile);
+    } else {
+        min = std::min(min, Stats.Min);
+        max = std::max(max, Stats.Max);
     }
 
-    Vertex *ptr = (Vertex *)n.Data.Data;
-    for (size_t i = 0; i < (Indices.size() / 3); ++i) {
-        for (size_t j = 0; j < nsubV; ++j) {
+    Geometry n;
+    // Two vertices (origin and tip) per sub-vertex of every triangle.
+    TypedArray<Vertex> Out = ffNewTypedArray<Vertex>(nT * nsubV * 2);
+    n.Data = Out.Untyped();
+    if (Out.Data == nullptr)
+        return n;
+    ArrayView<Vertex> ptr = Out.View();
+
+    ParallelFor(nT, [&](size_t Begin, size_t End) {
+        std::vector<glm::vec2> Pn(nsubV);
+
+        for (size_t i = Begin; i < End; ++i) {
+            size_t e = (ElementOrder.empty()) ? i : ElementOrder[i];
+            size_t o = e * nK;
+            size_t count = i * nsubV * 2;
             glm::vec2 triangle[3] = {
-                glm::vec2(Vertices[Indices[i * 3] * 3 + 0], Vertices[Indices[i * 3] * 3 + 1]),
-                glm::vec2(Vertices[Indices[i * 3 + 1] * 3 + 0], Vertices[Indices[i * 3 + 1] * 3 + 1]),
-                glm::vec2(Vertices[Indices[i * 3 + 2] * 3 + 0], Vertices[Indices[i * 3 + 2] * 3 + 1])
+                glm::vec2(Vertices[Indices[e * 3] * 3 + 0], Vertices[Indices[e * 3] * 3 + 1]),
+                glm::vec2(Vertices[Indices[e * 3 + 1] * 3 + 0], Vertices[Indices[e * 3 + 1] * 3 + 1]),
+                glm::vec2(Vertices[Indices[e * 3 + 2] * 3 + 0], Vertices[Indices[e * 3 + 2] * 3 + 1])
             };
-            Pn[j] = IsoValue(triangle, glm::vec2(RefTriangle[j * 2], RefTriangle[j * 2 + 1]));
-        }
-        for (size_t k = 0, l = 0; k < nsubV; ++k) {
-            glm::vec2 P = Pn[k];
-            glm::vec2 uv(Values[o + l], Values[o + l + 1]);
-            float tmp = (sqrtf(uv.x * uv.x + uv.y * uv.y) - min) / (max - min);
-            l += 2;
-
-            ptr[count].x = P.x;
-            ptr[count].y = P.y;
-            ptr[count].z = 0.f;
-            ptr[count].r = 1.0f;
-            ptr[count].g = tmp;
-            ptr[count].b = 0.5f;
-            ptr[count].a = 0.5f;
-            count += 1;
-
-            ptr[count].x = P.x + (uv.x / max) * (max - min);
-            ptr[count].y = P.y + (uv.y / max) * (max - min);
-            ptr[count].z = 0.f;
-            ptr[count].r = 1.0f;
-            ptr[count].g = tmp;
-            ptr[count].b = 0.5f;
-            ptr[count].a = 0.5f;
-            count += 1;
+            for (size_t j = 0; j < nsubV; ++j) {
+                Pn[j] = IsoValue(triangle, glm::vec2(RefTriangle[j * 2], RefTriangle[j * 2 + 1]));
+            }
+            for (size_t k = 0, l = 0; k < nsubV; ++k) {
+                glm::vec2 P = Pn[k];
+                glm::vec2 uv(Values[o + l], Values[o + l + 1]);
+                float tmp = std::min(std::max((sqrtf(uv.x * uv.x + uv.y * uv.y) - min) / (max - min), 0.f), 1.f);
+                l += 2;
+
+                ptr[count].x = P.x;
+                ptr[count].y = P.y;
+                ptr[count].z = 0.f;
+                ptr[count].r = 1.0f;
+                ptr[count].g = tmp;
+                ptr[count].b = 0.5f;
+                ptr[count].a = 0.5f;
+                count += 1;
+
+                ptr[count].x = P.x + (uv.x / max) * (max - min);
+                ptr[count].y = P.y + (uv.y / max) * (max - min);
+                ptr[count].z = 0.f;
+                ptr[count].r = 1.0f;
+                ptr[count].g = tmp;
+                ptr[count].b = 0.5f;
+                ptr[count].a = 0.5f;
+                count += 1;
+            }
         }
-        o += nK;
-    }
+    }, 1024);
     return n;
 }
 
-void ImportGeometry(json GeoJSON, ThreadSafeQueue *Queue, uint16_t PlotID)
+void ResolveScalarRange(const std::vector<float>& Values, float& min, float& max)
+{
+    if (GImportSettings.ClipPercentile <= 0.f && min < max)
+        return;
+    FieldStats Stats = ReduceScalarField(Values.data(), Values.size(), 0, ClipRanks());
+    if (Stats.Count == 0)
+        return;
+    if (GImportSettings.ClipPercentile > 0.f) {
+        min = Stats.Percentile(GImportSettings.ClipPercentile);
+        max = Stats.Percentile(1.f - GImportSettings.ClipPercentile);
+    } else {
+        min = Stats.Min;
+        max = Stats.Max;
+    }
+}
+
+/**
+ * @brief Copy an array out of the decoded document. The document is decoded to json values first, so every
+ * array is copied once more here : decoding straight into the arrays needs a SAX decoder of its own.
+ */
+template <typename T>
+static std::vector<T> Extract(const json& j)
+{
+    std::vector<T> v = j.get<std::vector<T>>();
+    CountCopy(COPY_STAGE_EXTRACT, v.size() * sizeof(T));
+    return v;
+}
+
+/**
+ * @brief What a geometry is built from, told apart in its content hash.
+ */
+enum ContentKind : uint8_t {
+    CONTENT_MESH,
+    CONTENT_ISO,
+    CONTENT_BORDER
+};
+
+/**
+ * @brief Arrays of an entry of IsoArray. They are decoded before the mesh is optimized, which is skipped
+ * when every geometry of the mesh is found in the content cache.
+ */
+struct IsoInput {
+    std::vector<float> Values;
+    std::vector<float> KSub;
+    std::vector<float> RefTriangle;
+    bool AsVector = false;
+    float Min = 0.f;
+    float Max = 0.f;
+};
+
+void ImportGeometry(const json& GeoJSON, ThreadSafeQueue *Queue, uint16_t PlotID, uint32_t Generation,
+                    std::shared_ptr<MemoryManagement::LinearAllocator> Arena)
 {
     LabelTable Table;
 
     std::string GeoType = GeoJSON["Type"].get<std::string>();
     uint16_t MeshID = GeoJSON["Id"].get<uint16_t>();
     ConstructedGeometry Data(PlotID, MeshID);
+    Data.Generation = Generation;
+    Data.Arena = Arena;
 
-    std::vector<float> Vertices = GeoJSON["Vertices"].get<std::vector<float>>();
-    std::vector<uint32_t> Indices = GeoJSON["MeshIndices"].get<std::vector<uint32_t>>();
-    std::vector<int> Labels = GeoJSON["MeshLabels"].get<std::vector<int>>();
-
-    Data.Geo = ConstructGeometry(Vertices, Indices, Labels, Table);
-    if (Data.Geo.Data.Data == 0) {
-        LogWarning("AsyncImport", "Failed to import mesh.");
-    } else {
-        Data.Geo.Description.PrimitiveTopology = GetMainPrimitiveTopology(GeoType);
-        Data.Geo.Description.PolygonMode = GEO_POLYGON_MODE_LINE;
-        Data.Geo.Type = GetTypeValue(GeoType.c_str());
-        Queue->push(Data);
+    std::vector<float> Vertices = Extract<float>(GeoJSON["Vertices"]);
+    std::vector<uint32_t> Indices = Extract<uint32_t>(GeoJSON["MeshIndices"]);
+    std::vector<int> Labels = Extract<int>(GeoJSON["MeshLabels"]);
+    bool AsBorder = GeoJSON["Borders"].get<bool>();
+    std::vector<uint32_t> BorderIndices;
+    std::vector<int> BorderLabels;
+    if (AsBorder) {
+        BorderIndices = Extract<uint32_t>(GeoJSON["BorderIndices"]);
+        BorderLabels = Extract<int>(GeoJSON["BorderLabels"]);
     }
-
     bool AsIsoValues = GeoJSON["IsoValues"].get<bool>();
+    std::vector<IsoInput> Isos;
     if (AsIsoValues) {
-        for (auto& Isos : GeoJSON["IsoArray"]) {
-            ConstructedGeometry IsoValues(PlotID, MeshID);
-
-            std::vector<float> values = Isos["IsoV1"].get<std::vector<float>>();
-            std::vector<float> ksub = Isos["IsoKSub"].get<std::vector<float>>();
-            std::vector<float> referencetriangle = Isos["IsoPSub"].get<std::vector<float>>();
-            bool IsoAsVector = Isos["IsoVector"].get<bool>();
-
-            if (IsoAsVector) {
-                std::cout << "\tVectors.\n";
-                IsoValues.Geo = ConstructIsoVector(Vertices, Indices, values, referencetriangle, ksub, Isos["IsoMin"].get<float>(), Isos["IsoMax"].get<float>());
-                IsoValues.Geo.Type = GetTypeValue("Vector2D");
-                IsoValues.Geo.Description.PrimitiveTopology = GeometryPrimitiveTopology::GEO_PRIMITIVE_TOPOLOGY_LINE_LIST;
-            } else {
-                std::cout << "\tScalars.\n";
-                IsoValues.Geo = ConstructIsoLines(Vertices, Indices, values, referencetriangle, ksub, Isos["IsoMin"].get<float>(), Isos["IsoMax"].get<float>());
-                IsoValues.Geo.Description.PrimitiveTopology = GeometryPrimitiveTopology::GEO_PRIMITIVE_TOPOLOGY_LINE_LIST;
-                IsoValues.Geo.Type = GetTypeValue("Curve2D");
-            }
-            IsoValues.Geo.Description.PolygonMode = GEO_POLYGON_MODE_LINE;
-            Queue->push(IsoValues);
-            values.clear();
+        for (auto& IsoJSON : GeoJSON["IsoArray"]) {
+            IsoInput Iso;
+            Iso.Values = Extract<float>(IsoJSON["IsoV1"]);
+            Iso.KSub = Extract<float>(IsoJSON["IsoKSub"]);
+            Iso.RefTriangle = Extract<float>(IsoJSON["IsoPSub"]);
+            Iso.AsVector = IsoJSON["IsoVector"].get<bool>();
+            Iso.Min = IsoJSON["IsoMin"].get<float>();
+            Iso.Max = IsoJSON["IsoMax"].get<float>();
+            Isos.push_back(std::move(Iso));
         }
     }
 
-    bool AsBorder = GeoJSON["Borders"].get<bool>();
+    // Hashed right after their extraction from the decoded document, before anything is built from them,
+    // with the settings changing what is built : a resent mesh finds its geometries in the content cache.
+    ContentHasher MeshHash;
+    MeshHash.Add(GeoType);
+    MeshHash.AddValue(GImportSettings.OptimizeMeshes);
+    MeshHash.Add(HashContent(Vertices));
+    MeshHash.Add(HashContent(Indices));
+    MeshHash.Add(HashContent(Labels));
+
+    ContentHasher MainHash = MeshHash;
+    MainHash.AddValue(CONTENT_MESH);
+    Data.ContentHash = MainHash.Finish();
+    bool Construct = !GContentCache.Find(Data.ContentHash, Data);
+
+    std::vector<ConstructedGeometry> IsoValues;
+    for (const auto& Iso : Isos) {
+        IsoValues.push_back(ConstructedGeometry(PlotID, MeshID));
+        ConstructedGeometry& g = IsoValues.back();
+        g.Generation = Generation;
+        g.FieldID = (uint16_t)IsoValues.size();
+        g.Arena = Arena;
+        ContentHasher IsoHash = MeshHash;
+        IsoHash.AddValue(CONTENT_ISO);
+        IsoHash.Add(Iso.Values);
+        IsoHash.Add(Iso.KSub);
+        IsoHash.Add(Iso.RefTriangle);
+        IsoHash.AddValue(Iso.AsVector);
+        IsoHash.AddValue(Iso.Min);
+        IsoHash.AddValue(Iso.Max);
+        IsoHash.AddValue(GImportSettings.ClipPercentile);
+        g.ContentHash = IsoHash.Finish();
+        Construct |= !GContentCache.Find(g.ContentHash, g);
+    }
+
+    ConstructedGeometry Border(PlotID, MeshID);
+    Border.Generation = Generation;
+    Border.Arena = Arena;
     if (AsBorder) {
-        std::cout << "Import border.\n";
-        ConstructedGeometry Border(PlotID, MeshID);
+        ContentHasher BorderHash = MeshHash;
+        BorderHash.AddValue(CONTENT_BORDER);
+        BorderHash.Add(BorderIndices);
+        BorderHash.Add(BorderLabels);
+        Border.ContentHash = BorderHash.Finish();
+        Construct |= !GContentCache.Find(Border.ContentHash, Border);
+    }
 
-        Indices.clear();
-        Labels.clear();
+    // Iso values are stored per element in the server's order. When the mesh is optimized the iso kernels
+    // keep their own copy of the element list and only change the traversal order, otherwise they read the
+    // mesh indices.
+    std::vector<uint32_t> IsoIndices;
+    std::vector<uint32_t> IsoOrder;
+
+    std::vector<uint32_t> RenderIndices;
+    bool Optimize = Construct && GImportSettings.OptimizeMeshes && GetMainPrimitiveTopology(GeoType) == GEO_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    if (Optimize) {
+        if (AsIsoValues) {
+            IsoIndices = Indices;
+            CountCopy(COPY_STAGE_IMPORT, IsoIndices.size() * sizeof(uint32_t));
+        }
+        RenderIndices = std::move(Indices);
+        std::vector<std::vector<uint32_t> *> Others = {&IsoIndices, &BorderIndices};
+        MeshOptimizeStats Stats = OptimizeMesh(Vertices, RenderIndices, Others);
+        LogInfo("ImportGeometry", "Mesh %u : %zu -> %zu vertices.", MeshID, Stats.VertexCountBefore, Stats.VertexCountAfter);
+        if (AsIsoValues)
+            IsoOrder = ComputeMortonElementOrder(Vertices, IsoIndices, 3);
+    }
 
-        std::vector<uint32_t> Indices = GeoJSON["BorderIndices"].get<std::vector<uint32_t>>();
-        std::vector<int> Labels = GeoJSON["BorderLabels"].get<std::vector<int>>();
+    const std::vector<uint32_t>& IsoElements = (Optimize) ? IsoIndices : Indices;
 
-        Border.Geo = ConstructBorder(Vertices, Indices, Labels, Table);
+    if (Data.Geo.Data.Data != 0) {
+        // The border colours are picked from the labels of the mesh and of the border.
+        for (const auto& lab : Labels)
+            AddLabelToTable(Table, lab);
+        Queue->push(std::move(Data));
+    } else {
+        Data.Geo = ConstructGeometry(Vertices, (Optimize) ? RenderIndices : Indices, Labels, Table);
+        if (Data.Geo.Data.Data == 0) {
+            LogWarning("AsyncImport", "Failed to import mesh.");
+        } else {
+            Data.Geo.Description.PrimitiveTopology = GetMainPrimitiveTopology(GeoType);
+            Data.Geo.Description.PolygonMode = GEO_POLYGON_MODE_LINE;
+            Data.Geo.Type = GetTypeValue(GeoType.c_str());
+            Data.PositionHash = HashPositions(Data.Geo);
+            GContentCache.Remember(Data);
+            Queue->push(std::move(Data));
+        }
+    }
 
-        if (Border.Geo.Data.Data == 0) {
-            LogWarning("AsyncImport", "Failed to import border.");
+    for (size_t i = 0; i < Isos.size(); ++i) {
+        const IsoInput& Iso = Isos[i];
+        ConstructedGeometry& g = IsoValues[i];
+        if (g.Geo.Data.Data != 0) {
+            Queue->push(std::move(g));
+            continue;
+        }
+
+        if (Iso.AsVector) {
+            std::cout << "\tVectors.\n";
+            g.Geo = ConstructIsoVector(Vertices, IsoElements, Iso.Values, Iso.RefTriangle, Iso.KSub, Iso.Min, Iso.Max, IsoOrder);
+            g.Geo.Type = GetTypeValue("Vector2D");
+            g.Geo.Description.PrimitiveTopology = GeometryPrimitiveTopology::GEO_PRIMITIVE_TOPOLOGY_LINE_LIST;
         } else {
-            Border.Geo.Description.PrimitiveTopology = GetBorderPrimitiveTopology(GeoType);
-            Border.Geo.Description.PolygonMode = GEO_POLYGON_MODE_LINE;
-            Border.Geo.Type = GetTypeValue(((Border.Geo.Description.PrimitiveTopology == GEO_PRIMITIVE_TOPOLOGY_LINE_LIST) ? "Curve2D" : "Mesh3D"));
-            Queue->push(Border);
+            std::cout << "\tScalars.\n";
+            float IsoMin = Iso.Min;
+            float IsoMax = Iso.Max;
+            ResolveScalarRange(Iso.Values, IsoMin, IsoMax);
+            g.Geo = ConstructIsoLines(Vertices, IsoElements, Iso.Values, Iso.RefTriangle, Iso.KSub, IsoMin, IsoMax, IsoOrder);
+            g.Geo.Description.PrimitiveTopology = GeometryPrimitiveTopology::GEO_PRIMITIVE_TOPOLOGY_LINE_LIST;
+            g.Geo.Type = GetTypeValue("Curve2D");
+        }
+        g.Geo.Description.PolygonMode = GEO_POLYGON_MODE_LINE;
+        g.PositionHash = HashPositions(g.Geo);
+        GContentCache.Remember(g);
+        Queue->push(std::move(g));
+    }
+    Isos.clear();
+
+    if (AsBorder) {
+        std::cout << "Import border.\n";
+        if (Border.Geo.Data.Data != 0) {
+            Queue->push(std::move(Border));
+        } else {
+            Indices.clear();
+            Labels.clear();
+
+            Border.Geo = ConstructBorder(Vertices, BorderIndices, BorderLabels, Table);
+
+            if (Border.Geo.Data.Data == 0) {
+                LogWarning("AsyncImport", "Failed to import border.");
+            } else {
+                Border.Geo.Description.PrimitiveTopology = GetBorderPrimitiveTopology(GeoType);
+                Border.Geo.Description.PolygonMode = GEO_POLYGON_MODE_LINE;
+                Border.Geo.Type = GetTypeValue(((Border.Geo.Description.PrimitiveTopology == GEO_PRIMITIVE_TOPOLOGY_LINE_LIST) ? "Curve2D" : "Mesh3D"));
+                Border.PositionHash = HashPositions(Border.Geo);
+                GContentCache.Remember(Border);
+                Queue->push(std::move(Border));
+            }
         }
     }
     std::cout << "Finished importing data.\n";
 }
 
-void AsyncImport(std::string CompressedJSON, ThreadSafeQueue& Queue)
+/**
+ * @brief Decoded size of a document per byte of CBOR : a 5 bytes float becomes a 16 bytes json value, the
+ * other items don't weigh as much.
+ */
+constexpr size_t DecodedBytesPerPayloadByte = 3;
+
+#ifdef _DEBUG
+/**
+ * @brief Bytes of the numbers of a decoded document once extracted, every one of them into 4 bytes.
+ */
+static uint64_t ExtractedBytes(const json& j)
 {
-    json j = json::from_cbor(CompressedJSON);
+    if (j.is_number())
+        return 4;
+    uint64_t Bytes = 0;
+    if (j.is_structured())
+        for (const auto& Item : j) Bytes += ExtractedBytes(Item);
+    return Bytes;
+}
+
+/**
+ * @brief Copy budget of a plot, in the payload bytes of its message : copied at most once into the payload
+ * and decoded once, each number extracted at most once, and the import kernels copying at most what was
+ * extracted (the element list the iso kernels keep when the mesh is optimized).
+ */
+static void CheckCopyBudget(const Payload& CompressedJSON, const CopyTally& Tally, uint64_t Extractable, uint16_t PlotID)
+{
+    uint64_t Size = CompressedJSON.Size();
+    if (CompressedJSON.CopiedBytes() > Size || Tally.Bytes[COPY_STAGE_DECODE] > Size ||
+        Tally.Bytes[COPY_STAGE_EXTRACT] > Extractable || Tally.Bytes[COPY_STAGE_IMPORT] > Tally.Bytes[COPY_STAGE_EXTRACT])
+        LogError("AsyncImport", "Plot %u is over its copy budget : %llu payload bytes, %zu copied into the payload, %llu decoded, %llu of %llu extracted, %llu copied by the import.",
+                 PlotID, (unsigned long long)Size, CompressedJSON.CopiedBytes(),
+                 (unsigned long long)Tally.Bytes[COPY_STAGE_DECODE], (unsigned long long)Tally.Bytes[COPY_STAGE_EXTRACT],
+                 (unsigned long long)Extractable, (unsigned long long)Tally.Bytes[COPY_STAGE_IMPORT]);
+}
+#endif
+
+void AsyncImport(Payload& CompressedJSON, ThreadSafeQueue& Queue)
+{
+    const uint8_t *Bytes = CompressedJSON.Map();
+    if (Bytes == nullptr) {
+        LogWarning("AsyncImport", "Failed to read a %lu bytes spilled message.", (unsigned long)CompressedJSON.Size());
+        return;
+    }
+#ifdef _DEBUG
+    // Only the copies of this thread count against the plot, the render loop uploads meanwhile.
+    CopyTally Tally;
+    CopyTallyScope TallyScope(Tally);
+#endif
+    json j = json::from_cbor(Bytes, Bytes + CompressedJSON.Size());
+    CountCopy(COPY_STAGE_DECODE, CompressedJSON.Size());
+    CompressedJSON.Unmap();
+    size_t DocumentBytes = CompressedJSON.Size() * DecodedBytesPerPayloadByte;
+    MemoryManagement::GetMemoryTracker().Add(MemoryManagement::MEMORY_TAG_CBOR, DocumentBytes);
     uint16_t PlotID = j["Plot"].get<uint16_t>();
 
+    // Everything built from this message lives in its own arena, given back when its last geometry is destroyed.
+    std::shared_ptr<MemoryManagement::LinearAllocator> Arena = std::make_shared<MemoryManagement::LinearAllocator>();
+    MemoryManagement::ArenaScope Scope(Arena.get());
+
     std::cout << "Importing data from " << PlotID << "\n";
-    for (auto & Geometry : j["Geometry"]) {
-        ImportGeometry(Geometry, &Queue, PlotID);
+    uint32_t Generation = NewGeometryGeneration();
+    for (const auto& Geometry : j["Geometry"]) {
+        ImportGeometry(Geometry, &Queue, PlotID, Generation, Arena);
         //std::async(std::launch::async, ImportGeometry, Geometry, &Queue, PlotID);
     }
+    MemoryManagement::GetMemoryTracker().Remove(MemoryManagement::MEMORY_TAG_CBOR, DocumentBytes);
+#ifdef _DEBUG
+    LogInfo("AsyncImport", "Plot %u : %zu payload bytes, %zu copied into the payload, %llu decoded, %llu extracted, %llu copied by the import.",
+            PlotID, CompressedJSON.Size(), CompressedJSON.CopiedBytes(), (unsigned long long)Tally.Bytes[COPY_STAGE_DECODE],
+            (unsigned long long)Tally.Bytes[COPY_STAGE_EXTRACT], (unsigned long long)Tally.Bytes[COPY_STAGE_IMPORT]);
+    CheckCopyBudget(CompressedJSON, Tally, ExtractedBytes(j), PlotID);
+#endif
 }
 
 }    // namespace JSON
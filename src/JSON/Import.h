@@ -5,6 +5,7 @@
 #include <vector>
 #include "LabelTable.h"
 #include "ThreadQueue.h"
+#include "Payload.h"
 #include "Array.h"
 
 namespace ffGraph {
@@ -12,11 +13,32 @@ namespace JSON {
 
 using json = nlohmann::json;
 
+/**
+ * @brief Options applied to every imported geometry.
+ */
+struct ImportSettings {
+    // @brief Weld and Morton order the meshes (see MeshOptimizer.h).
+    bool OptimizeMeshes = false;
+    // @brief Fraction of the samples ignored at each end of the colour range of iso values, 0 keeps the full range.
+    float ClipPercentile = 0.f;
+};
+
+extern ImportSettings GImportSettings;
+
 //Geometry ConstructGeometry(std::vector<float> Vertices, std::vector<uint32_t> Indices, std::vector<int> Labels);
 //void ImportGeometry(json GeoJSON, ThreadSafeQueue& Queue, uint16_t PlotID);
-void AsyncImport(std::string CompressedJSON, ThreadSafeQueue& Queue);
+void AsyncImport(Payload& CompressedJSON, ThreadSafeQueue& Queue);
+
+/**
+ * @brief Range used to draw a scalar field : [min, max] as given, computed from Values when it is empty or
+ * when outliers are clipped (see ffGraph::JSON::ImportSettings::ClipPercentile).
+ */
+void ResolveScalarRange(const std::vector<float>& Values, float& min, float& max);
 
-Geometry ConstructIsoLines(std::vector<float>& Vertices, std::vector<uint32_t>& Indices, std::vector<float> Values, std::vector<float>& RefTriangle, std::vector<float>& KSub, float min, float max);
+Geometry ConstructGeometry(const std::vector<float>& Vertices, const std::vector<uint32_t>& Indices, const std::vector<int>& Labels, LabelTable& Table);
+Geometry ConstructBorder(const std::vector<float>& Vertices, const std::vector<uint32_t>& Indices, const std::vector<int>& Labels, LabelTable& Table);
+Geometry ConstructIsoVector(const std::vector<float>& Vertices, const std::vector<uint32_t>& Indices, const std::vector<float>& Values, const std::vector<float>& RefTriangle, const std::vector<float>& KSub, float min, float max, const std::vector<uint32_t>& ElementOrder);
+Geometry ConstructIsoLines(const std::vector<float>& Vertices, const std::vector<uint32_t>& Indices, const std::vector<float>& Values, const std::vector<float>& RefTriangle, const std::vector<float>& KSub, float min, float max, const std::vector<uint32_t>& ElementOrder);
 
 }    // namespace JSON
 }    // namespace ffGraph
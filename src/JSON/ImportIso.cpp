@@ -22,7 +22,8 @@ static float norme2(glm::vec2 a, glm::vec2 b)
     return a.x * b.x + a.y * b.y;
 }
 
-Geometry ConstructIsoLines(std::vector<float>& Vertices, std::vector<uint32_t>& Indices, std::vector<float> Values, std::vector<float>& RefTriangle, std::vector<float>& KSub, float min, float max) {
+Geometry ConstructIsoLines(const std::vector<float>& Vertices, const std::vector<uint32_t>& Indices, const std::vector<float>& Values, const std::vector<float>& RefTriangle, const std::vector<float>& KSub, float min, float max, const std::vector<uint32_t>& ElementOrder) {
+    MemoryManagement::MemoryTagScope Tag(MemoryManagement::MEMORY_TAG_ISO);
     size_t nsubT = KSub.size() / 3;
     size_t nsubV = RefTriangle.size() / 2;
     size_t nK = Values.size() / (Indices.size() / 3);
@@ -34,7 +35,9 @@ Geometry ConstructIsoLines(std::vector<float>& Vertices, std::vector<uint32_t>&
     n.Data = ffNewArray(ISOLINE_NBR * (Indices.size() / 3) * nsubT * 2, sizeof(Vertex));
     std::cout << ISOLINE_NBR * (Indices.size() / 3) * 2 << "\n";
 
-    Vertex *ptr = (Vertex *)n.Data.Data;
+    if (n.Data.Data == nullptr)
+        return n;
+    ArrayView<Vertex> ptr = ffArrayView<Vertex>(n.Data);
     std::vector<float> Viso(ISOLINE_NBR);
 
     for (size_t i = 0; i < ISOLINE_NBR; ++i) {
@@ -43,10 +46,12 @@ Geometry ConstructIsoLines(std::vector<float>& Vertices, std::vector<uint32_t>&
     }
 
     for (size_t i = 0; i < (Indices.size() / 3); ++i) {
+        size_t e = (ElementOrder.empty()) ? i : ElementOrder[i];
+        o = (int)(e * nK);
         glm::vec2 triangle[3] = {
-            glm::vec2(Vertices[Indices[i * 3] * 3 + 0], Vertices[Indices[i * 3] * 3 + 1]),
-            glm::vec2(Vertices[Indices[i * 3 + 1] * 3 + 0], Vertices[Indices[i * 3 + 1] * 3 + 1]),
-            glm::vec2(Vertices[Indices[i * 3 + 2] * 3 + 0], Vertices[Indices[i * 3 + 2] * 3 + 1])
+            glm::vec2(Vertices[Indices[e * 3] * 3 + 0], Vertices[Indices[e * 3] * 3 + 1]),
+            glm::vec2(Vertices[Indices[e * 3 + 1] * 3 + 0], Vertices[Indices[e * 3 + 1] * 3 + 1]),
+            glm::vec2(Vertices[Indices[e * 3 + 2] * 3 + 0], Vertices[Indices[e * 3 + 2] * 3 + 1])
         };
         for (size_t j = 0; j < nsubV; ++j) {
             Pn[j] = IsoValue(triangle, glm::vec2(RefTriangle[j * 2], RefTriangle[j * 2 + 1]));
@@ -123,7 +128,6 @@ Geometry ConstructIsoLines(std::vector<float>& Vertices, std::vector<uint32_t>&
                 }
             }
         }
-        o += nK;
     }
     return n;
 }
@@ -0,0 +1,824 @@
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "IO.h"
+#include "Import.h"
+#include "Logger.h"
+#include "MeditLoader.h"
+#include "Parallel.h"
+
+namespace ffGraph {
+namespace JSON {
+
+/**
+ * @brief Keyword codes of the Medit binary format (see libMeshb).
+ */
+enum MeditKeyword : int32_t {
+    MEDIT_KW_DIMENSION = 3,
+    MEDIT_KW_VERTICES = 4,
+    MEDIT_KW_EDGES = 5,
+    MEDIT_KW_TRIANGLES = 6,
+    MEDIT_KW_TETRAHEDRA = 8,
+    MEDIT_KW_END = 54,
+    MEDIT_KW_SOL_AT_VERTICES = 62
+};
+
+// ASCII sections are split in chunks of this size, counted then parsed in parallel.
+static constexpr size_t TextChunkSize = 1 << 22;
+static constexpr size_t BinaryRecordGrain = 1 << 16;
+
+static const double Pow10Table[23] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/*
+ * ASCII parsing.
+ */
+
+struct TextStream {
+    const char *p;
+    const char *End;
+};
+
+static inline bool IsSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f'; }
+
+static inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+static inline bool IsKeywordStart(char c) { return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '#'; }
+
+static inline void SkipSpaces(const char *& p, const char *End)
+{
+    while (p < End && IsSpace(*p)) ++p;
+}
+
+static void SkipSpacesAndComments(TextStream& s)
+{
+    SkipSpaces(s.p, s.End);
+    while (s.p < s.End && *s.p == '#') {
+        while (s.p < s.End && *s.p != '\n') ++s.p;
+        SkipSpaces(s.p, s.End);
+    }
+}
+
+/**
+ * @brief Decimal to double without locale nor strtod, exact for up to 15 significant digits and |exponent| <= 22.
+ * Fortran style exponents (1.0D+00) are accepted.
+ */
+static inline bool ParseReal(const char *& p, const char *End, double& Value)
+{
+    bool Negative = false;
+    if (p < End && (*p == '-' || *p == '+')) {
+        Negative = (*p == '-');
+        ++p;
+    }
+    uint64_t Mantissa = 0;
+    int Exponent = 0;
+    int Digits = 0;
+    bool Any = false;
+
+    for (; p < End && IsDigit(*p); ++p, Any = true) {
+        if (Digits < 19) {
+            Mantissa = Mantissa * 10 + (uint64_t)(*p - '0');
+            Digits += (Mantissa != 0);
+        } else {
+            Exponent += 1;
+        }
+    }
+    if (p < End && *p == '.') {
+        for (++p; p < End && IsDigit(*p); ++p, Any = true) {
+            if (Digits < 19) {
+                Mantissa = Mantissa * 10 + (uint64_t)(*p - '0');
+                Digits += (Mantissa != 0);
+                Exponent -= 1;
+            }
+        }
+    }
+    if (!Any)
+        return false;
+    if (p < End && (*p == 'e' || *p == 'E' || *p == 'd' || *p == 'D')) {
+        const char *q = p + 1;
+        bool NegativeExponent = false;
+        if (q < End && (*q == '-' || *q == '+')) {
+            NegativeExponent = (*q == '-');
+            ++q;
+        }
+        if (q < End && IsDigit(*q)) {
+            int e = 0;
+            for (; q < End && IsDigit(*q); ++q)
+                if (e < 100000) e = e * 10 + (*q - '0');
+            Exponent += (NegativeExponent) ? -e : e;
+            p = q;
+        }
+    }
+    double v = (double)Mantissa;
+    if (Exponent < 0)
+        v = (-Exponent <= 22) ? v / Pow10Table[-Exponent] : v * std::pow(10.0, Exponent);
+    else if (Exponent > 0)
+        v = (Exponent <= 22) ? v * Pow10Table[Exponent] : v * std::pow(10.0, Exponent);
+    Value = (Negative) ? -v : v;
+    return true;
+}
+
+static inline bool ParseInteger(const char *& p, const char *End, int64_t& Value)
+{
+    bool Negative = false;
+    if (p < End && (*p == '-' || *p == '+')) {
+        Negative = (*p == '-');
+        ++p;
+    }
+    if (p >= End || !IsDigit(*p))
+        return false;
+    int64_t v = 0;
+    for (; p < End && IsDigit(*p); ++p) v = v * 10 + (*p - '0');
+    Value = (Negative) ? -v : v;
+    return true;
+}
+
+static bool NextWord(TextStream& s, std::string& Word)
+{
+    SkipSpacesAndComments(s);
+    const char *Begin = s.p;
+    while (s.p < s.End && !IsSpace(*s.p)) ++s.p;
+    Word.assign(Begin, s.p);
+    return !Word.empty( );
+}
+
+static bool NextInteger(TextStream& s, int64_t& Value)
+{
+    SkipSpacesAndComments(s);
+    return ParseInteger(s.p, s.End, Value);
+}
+
+/**
+ * @brief Skip the body of a section this loader doesn't use, up to the next keyword.
+ */
+static void SkipTextSection(TextStream& s)
+{
+    while (true) {
+        SkipSpacesAndComments(s);
+        if (s.p >= s.End || IsKeywordStart(*s.p)) return;
+        while (s.p < s.End && !IsSpace(*s.p)) ++s.p;
+    }
+}
+
+/**
+ * @brief Count the tokens starting in chunk Chunk of [Begin, End), stopping at the first keyword.
+ */
+static void CountChunkTokens(const char *Begin, const char *End, size_t Chunk, size_t& Count, char& Stopped)
+{
+    const char *p = Begin + Chunk * TextChunkSize;
+    const char *ChunkEnd = std::min(End, p + TextChunkSize);
+    bool PreviousSpace = (p == Begin) || IsSpace(p[-1]);
+    size_t n = 0;
+
+    for (; p < ChunkEnd; ++p) {
+        bool Space = IsSpace(*p);
+        if (!Space && PreviousSpace) {
+            if (IsKeywordStart(*p)) {
+                Stopped = 1;
+                break;
+            }
+            n += 1;
+        }
+        PreviousSpace = Space;
+    }
+    Count = n;
+}
+
+/**
+ * @brief Parse TokenCount numbers from the stream. The remaining text is cut in fixed size chunks : the
+ * tokens of each chunk are counted in parallel (wave by wave, stopping as soon as enough tokens were seen),
+ * a prefix sum gives the index of the first token of every chunk, then chunks are parsed in parallel.
+ *
+ * @param s [in/out] - Stream, moved after the last token.
+ * @param TokenCount [in] - Number of tokens of the section.
+ * @param StoreToken [in] - bool(size_t Token, const char *&p, const char *End), parses one token.
+ *
+ * @return bool - false if the section is truncated or a token is malformed.
+ */
+template <typename Func>
+static bool ParseNumberSection(TextStream& s, size_t TokenCount, Func&& StoreToken)
+{
+    if (TokenCount == 0)
+        return true;
+    SkipSpacesAndComments(s);
+    const char *Begin = s.p;
+    const char *End = s.End;
+    size_t ChunkCount = ((size_t)(End - Begin) + TextChunkSize - 1) / TextChunkSize;
+    size_t Workers = GetParallelWorkerCount( );
+    std::vector<size_t> Counts;
+    size_t Total = 0;
+    bool Stopped = false;
+
+    for (size_t Wave = 0; Wave < ChunkCount && Total < TokenCount && !Stopped; Wave += Workers) {
+        size_t WaveSize = std::min(ChunkCount - Wave, Workers);
+        std::vector<size_t> WaveCounts(WaveSize, 0);
+        std::vector<char> WaveStops(WaveSize, 0);
+
+        ParallelFor(WaveSize, [&](size_t b, size_t e) {
+            for (size_t c = b; c < e; ++c) CountChunkTokens(Begin, End, Wave + c, WaveCounts[c], WaveStops[c]);
+        }, 1);
+        for (size_t c = 0; c < WaveSize && Total < TokenCount; ++c) {
+            Counts.push_back(WaveCounts[c]);
+            Total += WaveCounts[c];
+            if (WaveStops[c]) {
+                Stopped = true;
+                break;
+            }
+        }
+    }
+    if (Total < TokenCount) {
+        LogWarning("MeditLoader", "Section truncated, %lu values expected, %lu found.", (unsigned long)TokenCount, (unsigned long)Total);
+        return false;
+    }
+
+    std::vector<size_t> FirstToken(Counts.size( ), 0);
+    for (size_t c = 1; c < Counts.size( ); ++c) FirstToken[c] = FirstToken[c - 1] + Counts[c - 1];
+
+    std::atomic<bool> Failed(false);
+    const char *SectionEnd = End;
+    ParallelFor(Counts.size( ), [&](size_t b, size_t e) {
+        for (size_t c = b; c < e && !Failed; ++c) {
+            if (Counts[c] == 0 || FirstToken[c] >= TokenCount) continue;
+            const char *p = Begin + c * TextChunkSize;
+            // A token crossing the chunk start belongs to the previous chunk.
+            if (c > 0 && !IsSpace(p[-1]))
+                while (p < End && !IsSpace(*p)) ++p;
+
+            size_t Last = std::min(TokenCount, FirstToken[c] + Counts[c]);
+            for (size_t t = FirstToken[c]; t < Last; ++t) {
+                SkipSpaces(p, End);
+                if (!StoreToken(t, p, End) || (p < End && !IsSpace(*p))) {
+                    Failed = true;
+                    break;
+                }
+            }
+            if (Last == TokenCount) SectionEnd = p;
+        }
+    }, 1);
+
+    if (Failed) {
+        LogWarning("MeditLoader", "Malformed value in section.");
+        return false;
+    }
+    s.p = SectionEnd;
+    return true;
+}
+
+static bool ReadTextVertices(TextStream& s, MeditMesh& Mesh)
+{
+    int64_t n;
+    if (!NextInteger(s, n) || n < 0) return false;
+    size_t Dim = (size_t)Mesh.Dimension;
+    size_t k = Dim + 1;
+
+    Mesh.Vertices.assign((size_t)n * 3, 0.f);
+    Mesh.VertexLabels.assign((size_t)n, 0);
+    return ParseNumberSection(s, (size_t)n * k, [&](size_t t, const char *& p, const char *End) {
+        size_t r = t / k;
+        size_t f = t % k;
+        if (f < Dim) {
+            double v;
+            if (!ParseReal(p, End, v)) return false;
+            Mesh.Vertices[r * 3 + f] = (float)v;
+        } else {
+            int64_t l;
+            if (!ParseInteger(p, End, l)) return false;
+            Mesh.VertexLabels[r] = (int)l;
+        }
+        return true;
+    });
+}
+
+static bool ReadTextElements(TextStream& s, size_t Nodes, std::vector<uint32_t>& Indices, std::vector<int>& Labels)
+{
+    int64_t n;
+    if (!NextInteger(s, n) || n < 0) return false;
+    size_t k = Nodes + 1;
+
+    Indices.assign((size_t)n * Nodes, 0);
+    Labels.assign((size_t)n, 0);
+    return ParseNumberSection(s, (size_t)n * k, [&](size_t t, const char *& p, const char *End) {
+        size_t r = t / k;
+        size_t f = t % k;
+        int64_t v;
+        if (!ParseInteger(p, End, v)) return false;
+        if (f < Nodes) {
+            if (v < 1) return false;
+            Indices[r * Nodes + f] = (uint32_t)(v - 1);
+        } else {
+            Labels[r] = (int)v;
+        }
+        return true;
+    });
+}
+
+static size_t GetSolutionTypeSize(int Type, int Dimension)
+{
+    switch (Type) {
+        case 1: return 1;
+        case 2: return (size_t)Dimension;
+        case 3: return (size_t)(Dimension * (Dimension + 1) / 2);
+        case 4: return (size_t)(Dimension * Dimension);
+        default: return 0;
+    }
+}
+
+static bool ReadTextSolution(TextStream& s, MeditSolution& Solution)
+{
+    int64_t n, TypeCount;
+    if (!NextInteger(s, n) || n < 0 || !NextInteger(s, TypeCount) || TypeCount < 1) return false;
+
+    Solution.Types.clear( );
+    Solution.Stride = 0;
+    for (int64_t i = 0; i < TypeCount; ++i) {
+        int64_t Type;
+        if (!NextInteger(s, Type)) return false;
+        Solution.Types.push_back((int)Type);
+        Solution.Stride += GetSolutionTypeSize((int)Type, Solution.Dimension);
+    }
+    Solution.Values.assign((size_t)n * Solution.Stride, 0.f);
+    return ParseNumberSection(s, Solution.Values.size( ), [&](size_t t, const char *& p, const char *End) {
+        double v;
+        if (!ParseReal(p, End, v)) return false;
+        Solution.Values[t] = (float)v;
+        return true;
+    });
+}
+
+/**
+ * @brief Walk the keywords of an ASCII Medit file. Mesh and Solution may be null.
+ */
+static bool ReadTextFile(const IO::MappedFile& File, MeditMesh *Mesh, MeditSolution *Solution)
+{
+    TextStream s = {(const char *)File.Data, (const char *)File.Data + File.Size};
+    std::string Keyword;
+    int Dimension = 3;
+    bool Success = true;
+
+    while (Success && NextWord(s, Keyword)) {
+        if (Keyword == "End") {
+            break;
+        } else if (Keyword == "MeshVersionFormatted") {
+            int64_t Version;
+            Success = NextInteger(s, Version);
+        } else if (Keyword == "Dimension") {
+            int64_t d;
+            Success = NextInteger(s, d) && (d == 2 || d == 3);
+            Dimension = (int)d;
+            if (Mesh) Mesh->Dimension = Dimension;
+            if (Solution) Solution->Dimension = Dimension;
+        } else if (Mesh && Keyword == "Vertices") {
+            Success = ReadTextVertices(s, *Mesh);
+        } else if (Mesh && Keyword == "Edges") {
+            Success = ReadTextElements(s, 2, Mesh->Edges, Mesh->EdgeLabels);
+        } else if (Mesh && Keyword == "Triangles") {
+            Success = ReadTextElements(s, 3, Mesh->Triangles, Mesh->TriangleLabels);
+        } else if (Mesh && Keyword == "Tetrahedra") {
+            Success = ReadTextElements(s, 4, Mesh->Tetrahedra, Mesh->TetrahedronLabels);
+        } else if (Solution && Keyword == "SolAtVertices") {
+            return ReadTextSolution(s, *Solution);
+        } else {
+            SkipTextSection(s);
+        }
+        if (!Success)
+            LogWarning("MeditLoader", "Failed to read section %s.", Keyword.c_str( ));
+    }
+    return Success && (Mesh != nullptr);
+}
+
+/*
+ * Binary parsing.
+ */
+
+struct BinaryStream {
+    const uint8_t *Begin;
+    const uint8_t *p;
+    const uint8_t *End;
+    // @brief 1 : float reals, 2 : double reals, 3 : 64 bits positions, 4 : 64 bits integers.
+    int Version;
+
+    size_t RealSize( ) const { return (Version == 1) ? 4 : 8; }
+    size_t IntegerSize( ) const { return (Version >= 4) ? 8 : 4; }
+};
+
+static bool ReadBytes(BinaryStream& s, void *Out, size_t Size)
+{
+    if ((size_t)(s.End - s.p) < Size) return false;
+    memcpy(Out, s.p, Size);
+    s.p += Size;
+    return true;
+}
+
+static bool ReadInt32(BinaryStream& s, int32_t& Value) { return ReadBytes(s, &Value, sizeof(int32_t)); }
+
+static bool ReadSized(BinaryStream& s, size_t Size, int64_t& Value)
+{
+    if (Size == 8) return ReadBytes(s, &Value, sizeof(int64_t));
+    int32_t v;
+    if (!ReadBytes(s, &v, sizeof(int32_t))) return false;
+    Value = v;
+    return true;
+}
+
+static inline double LoadReal(const uint8_t *p, size_t Size)
+{
+    if (Size == 4) {
+        float v;
+        memcpy(&v, p, sizeof(float));
+        return v;
+    }
+    double v;
+    memcpy(&v, p, sizeof(double));
+    return v;
+}
+
+static inline int64_t LoadInteger(const uint8_t *p, size_t Size)
+{
+    if (Size == 4) {
+        int32_t v;
+        memcpy(&v, p, sizeof(int32_t));
+        return v;
+    }
+    int64_t v;
+    memcpy(&v, p, sizeof(int64_t));
+    return v;
+}
+
+/**
+ * @brief Decode Count fixed size records in parallel.
+ */
+template <typename Func>
+static bool ReadBinaryRecords(BinaryStream& s, size_t Count, size_t RecordSize, Func&& Record)
+{
+    if (RecordSize == 0 || (size_t)(s.End - s.p) / RecordSize < Count) return false;
+    const uint8_t *Base = s.p;
+
+    ParallelFor(Count, [&](size_t Begin, size_t End) {
+        for (size_t r = Begin; r < End; ++r) Record(r, Base + r * RecordSize);
+    }, BinaryRecordGrain);
+    s.p += Count * RecordSize;
+    return true;
+}
+
+static bool ReadBinaryVertices(BinaryStream& s, MeditMesh& Mesh)
+{
+    int64_t n;
+    if (!ReadSized(s, s.IntegerSize( ), n) || n < 0) return false;
+    size_t Dim = (size_t)Mesh.Dimension;
+    size_t Real = s.RealSize( );
+    size_t Int = s.IntegerSize( );
+
+    Mesh.Vertices.assign((size_t)n * 3, 0.f);
+    Mesh.VertexLabels.assign((size_t)n, 0);
+    return ReadBinaryRecords(s, (size_t)n, Dim * Real + Int, [&](size_t r, const uint8_t *p) {
+        for (size_t k = 0; k < Dim; ++k) Mesh.Vertices[r * 3 + k] = (float)LoadReal(p + k * Real, Real);
+        Mesh.VertexLabels[r] = (int)LoadInteger(p + Dim * Real, Int);
+    });
+}
+
+static bool ReadBinaryElements(BinaryStream& s, size_t Nodes, std::vector<uint32_t>& Indices, std::vector<int>& Labels)
+{
+    int64_t n;
+    if (!ReadSized(s, s.IntegerSize( ), n) || n < 0) return false;
+    size_t Int = s.IntegerSize( );
+
+    Indices.assign((size_t)n * Nodes, 0);
+    Labels.assign((size_t)n, 0);
+    return ReadBinaryRecords(s, (size_t)n, (Nodes + 1) * Int, [&](size_t r, const uint8_t *p) {
+        for (size_t k = 0; k < Nodes; ++k) Indices[r * Nodes + k] = (uint32_t)(LoadInteger(p + k * Int, Int) - 1);
+        Labels[r] = (int)LoadInteger(p + Nodes * Int, Int);
+    });
+}
+
+static bool ReadBinarySolution(BinaryStream& s, MeditSolution& Solution)
+{
+    int64_t n;
+    int32_t TypeCount;
+    if (!ReadSized(s, s.IntegerSize( ), n) || n < 0 || !ReadInt32(s, TypeCount) || TypeCount < 1) return false;
+
+    Solution.Types.clear( );
+    Solution.Stride = 0;
+    for (int32_t i = 0; i < TypeCount; ++i) {
+        int32_t Type;
+        if (!ReadInt32(s, Type)) return false;
+        Solution.Types.push_back(Type);
+        Solution.Stride += GetSolutionTypeSize(Type, Solution.Dimension);
+    }
+    size_t Real = s.RealSize( );
+    size_t Stride = Solution.Stride;
+
+    Solution.Values.assign((size_t)n * Stride, 0.f);
+    return ReadBinaryRecords(s, (size_t)n, Stride * Real, [&](size_t r, const uint8_t *p) {
+        for (size_t k = 0; k < Stride; ++k) Solution.Values[r * Stride + k] = (float)LoadReal(p + k * Real, Real);
+    });
+}
+
+static bool ReadBinaryFile(const IO::MappedFile& File, MeditMesh *Mesh, MeditSolution *Solution)
+{
+    BinaryStream s = {File.Data, File.Data, File.Data + File.Size, 1};
+    int32_t Code, Version;
+
+    if (!ReadInt32(s, Code) || !ReadInt32(s, Version)) return false;
+    if (Code != 1) {
+        LogWarning("MeditLoader", "Binary files written with another byte order are not supported.");
+        return false;
+    }
+    if (Version < 1 || Version > 4) {
+        LogWarning("MeditLoader", "Unknown binary version %d.", Version);
+        return false;
+    }
+    s.Version = Version;
+
+    int32_t Keyword;
+    bool Success = true;
+    while (Success && ReadInt32(s, Keyword) && Keyword != MEDIT_KW_END) {
+        int64_t NextPosition;
+        if (!ReadSized(s, (Version >= 3) ? 8 : 4, NextPosition)) return false;
+
+        switch (Keyword) {
+            case MEDIT_KW_DIMENSION: {
+                int32_t d;
+                Success = ReadInt32(s, d) && (d == 2 || d == 3);
+                if (Mesh) Mesh->Dimension = d;
+                if (Solution) Solution->Dimension = d;
+                break;
+            }
+            case MEDIT_KW_VERTICES:
+                if (Mesh) Success = ReadBinaryVertices(s, *Mesh);
+                break;
+            case MEDIT_KW_EDGES:
+                if (Mesh) Success = ReadBinaryElements(s, 2, Mesh->Edges, Mesh->EdgeLabels);
+                break;
+            case MEDIT_KW_TRIANGLES:
+                if (Mesh) Success = ReadBinaryElements(s, 3, Mesh->Triangles, Mesh->TriangleLabels);
+                break;
+            case MEDIT_KW_TETRAHEDRA:
+                if (Mesh) Success = ReadBinaryElements(s, 4, Mesh->Tetrahedra, Mesh->TetrahedronLabels);
+                break;
+            case MEDIT_KW_SOL_AT_VERTICES:
+                if (Solution) return ReadBinarySolution(s, *Solution);
+                break;
+            default:
+                break;
+        }
+        if (!Success) {
+            LogWarning("MeditLoader", "Failed to read binary keyword %d.", Keyword);
+            return false;
+        }
+        // Every keyword stores the position of the next one, which also skips the unused sections.
+        if (NextPosition <= 0 || (size_t)NextPosition > File.Size) break;
+        s.p = s.Begin + NextPosition;
+    }
+    return Mesh != nullptr;
+}
+
+static bool HasExtension(const std::string& Path, const char *Extension)
+{
+    size_t n = strlen(Extension);
+    return Path.size( ) >= n && Path.compare(Path.size( ) - n, n, Extension) == 0;
+}
+
+static bool ReadMeditFile(const std::string& Path, MeditMesh *Mesh, MeditSolution *Solution)
+{
+    IO::MappedFile File;
+    if (!IO::MapFile(Path, File))
+        return false;
+    bool Binary = HasExtension(Path, ".meshb") || HasExtension(Path, ".solb");
+    bool Success = (Binary) ? ReadBinaryFile(File, Mesh, Solution) : ReadTextFile(File, Mesh, Solution);
+    IO::UnmapFile(File);
+    return Success;
+}
+
+bool ReadMeditMesh(const std::string& Path, MeditMesh& Mesh)
+{
+    Mesh = MeditMesh( );
+    if (!ReadMeditFile(Path, &Mesh, nullptr)) {
+        LogWarning("MeditLoader", "Failed to read mesh %s.", Path.c_str( ));
+        return false;
+    }
+    size_t VertexCount = Mesh.Vertices.size( ) / 3;
+    for (const std::vector<uint32_t> *Indices : {&Mesh.Edges, &Mesh.Triangles, &Mesh.Tetrahedra}) {
+        for (uint32_t i : *Indices) {
+            if (i >= VertexCount) {
+                LogWarning("MeditLoader", "%s references vertex %u out of %lu.", Path.c_str( ), i + 1, (unsigned long)VertexCount);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool ReadMeditSolution(const std::string& Path, MeditSolution& Solution)
+{
+    Solution = MeditSolution( );
+    if (!ReadMeditFile(Path, nullptr, &Solution) || Solution.Types.empty( )) {
+        LogWarning("MeditLoader", "Failed to read solution %s.", Path.c_str( ));
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Geometry construction.
+ */
+
+/**
+ * @brief Faces of a tetrahedral mesh which belong to a single tetrahedron, used when the file has no
+ * boundary triangles.
+ */
+static void ExtractBoundaryFaces(const MeditMesh& Mesh, std::vector<uint32_t>& Faces, std::vector<int>& Labels)
+{
+    static const int TetrahedronFaces[4][3] = {{1, 2, 3}, {0, 3, 2}, {0, 1, 3}, {0, 2, 1}};
+    struct FaceKey {
+        uint32_t v[3];
+        uint32_t Face;
+    };
+    size_t n = Mesh.Tetrahedra.size( ) / 4;
+    std::vector<FaceKey> Keys(n * 4);
+
+    ParallelFor(n, [&](size_t Begin, size_t End) {
+        for (size_t e = Begin; e < End; ++e) {
+            for (int f = 0; f < 4; ++f) {
+                FaceKey& k = Keys[e * 4 + f];
+                for (int j = 0; j < 3; ++j) k.v[j] = Mesh.Tetrahedra[e * 4 + TetrahedronFaces[f][j]];
+                std::sort(k.v, k.v + 3);
+                k.Face = (uint32_t)(e * 4 + f);
+            }
+        }
+    });
+    std::sort(Keys.begin( ), Keys.end( ), [](const FaceKey& a, const FaceKey& b) {
+        if (a.v[0] != b.v[0]) return a.v[0] < b.v[0];
+        if (a.v[1] != b.v[1]) return a.v[1] < b.v[1];
+        return a.v[2] < b.v[2];
+    });
+
+    Faces.clear( );
+    Labels.clear( );
+    for (size_t i = 0; i < Keys.size( );) {
+        size_t j = i + 1;
+        while (j < Keys.size( ) && memcmp(Keys[j].v, Keys[i].v, sizeof(Keys[i].v)) == 0) ++j;
+        if (j - i == 1) {
+            size_t e = Keys[i].Face / 4;
+            int f = Keys[i].Face % 4;
+            for (int k = 0; k < 3; ++k) Faces.push_back(Mesh.Tetrahedra[e * 4 + TetrahedronFaces[f][k]]);
+            Labels.push_back(Mesh.TetrahedronLabels[e]);
+        }
+        i = j;
+    }
+}
+
+/**
+ * @brief One geometry per solution field, built per element like the server sends them, with a P1
+ * reference triangle.
+ */
+static void PushSolutionFields(MeditMesh& Mesh, const MeditSolution& Solution, ThreadSafeQueue& Queue, uint16_t PlotID,
+                               uint32_t Generation, std::shared_ptr<MemoryManagement::LinearAllocator> Arena)
+{
+    size_t VertexCount = Mesh.Vertices.size( ) / 3;
+    if (Solution.Values.size( ) != VertexCount * Solution.Stride) {
+        LogWarning("LoadMeditFile", "Solution has %lu values per field, the mesh %lu vertices.",
+                   (unsigned long)(Solution.Values.size( ) / std::max(Solution.Stride, (size_t)1)), (unsigned long)VertexCount);
+        return;
+    }
+    if (Mesh.Dimension != 2 || Mesh.Triangles.empty( )) {
+        LogWarning("LoadMeditFile", "Solutions are only displayed on 2D triangle meshes.");
+        return;
+    }
+    std::vector<float> RefTriangle = {0.f, 0.f, 1.f, 0.f, 0.f, 1.f};
+    std::vector<float> KSub = {0.f, 1.f, 2.f};
+    std::vector<uint32_t> NoOrder;
+    size_t nC = Mesh.Triangles.size( );
+    size_t Offset = 0;
+    size_t FieldCount = 0;
+
+    for (int Type : Solution.Types) {
+        size_t Size = GetSolutionTypeSize(Type, Solution.Dimension);
+        ConstructedGeometry Field(PlotID, 0);
+        Field.Generation = Generation;
+        Field.Arena = Arena;
+
+        if (Type == 1 || Type == 2) {
+            std::vector<float> Values(nC * Size);
+            ParallelFor(nC, [&](size_t Begin, size_t End) {
+                for (size_t i = Begin; i < End; ++i)
+                    for (size_t c = 0; c < Size; ++c)
+                        Values[i * Size + c] = Solution.Values[Mesh.Triangles[i] * Solution.Stride + Offset + c];
+            });
+            if (Type == 1) {
+                float Min = 0.f, Max = 0.f;
+                ResolveScalarRange(Values, Min, Max);
+                Field.Geo = ConstructIsoLines(Mesh.Vertices, Mesh.Triangles, Values, RefTriangle, KSub, Min, Max, NoOrder);
+                Field.Geo.Type = GetTypeValue("Curve2D");
+            } else {
+                Field.Geo = ConstructIsoVector(Mesh.Vertices, Mesh.Triangles, Values, RefTriangle, KSub, FLT_MAX, -FLT_MAX, NoOrder);
+                Field.Geo.Type = GetTypeValue("Vector2D");
+            }
+            Field.Geo.Description.PrimitiveTopology = GEO_PRIMITIVE_TOPOLOGY_LINE_LIST;
+            Field.Geo.Description.PolygonMode = GEO_POLYGON_MODE_LINE;
+            if (Field.Geo.Data.Data != nullptr) {
+                // Numbered like the iso values of Import.cpp, 0 being the mesh.
+                Field.FieldID = (uint16_t)++FieldCount;
+                Field.PositionHash = HashPositions(Field.Geo);
+                Queue.push(std::move(Field));
+            }
+        } else {
+            LogInfo("LoadMeditFile", "Skipping tensor field of type %d.", Type);
+        }
+        Offset += Size;
+    }
+}
+
+static bool FileExists(const std::string& Path)
+{
+    FILE *f = fopen(Path.c_str( ), "rb");
+    if (f == nullptr) return false;
+    fclose(f);
+    return true;
+}
+
+bool LoadMeditFile(const std::string& Path, ThreadSafeQueue& Queue, uint16_t PlotID)
+{
+    size_t Dot = Path.find_last_of('.');
+    std::string Stem = (Dot == std::string::npos) ? Path : Path.substr(0, Dot);
+    std::string MeshPath = Path;
+    std::string SolutionPath;
+
+    if (HasExtension(Path, ".sol") || HasExtension(Path, ".solb")) {
+        SolutionPath = Path;
+        MeshPath = (FileExists(Stem + ".mesh")) ? Stem + ".mesh" : Stem + ".meshb";
+    } else if (FileExists(Stem + ".sol")) {
+        SolutionPath = Stem + ".sol";
+    } else if (FileExists(Stem + ".solb")) {
+        SolutionPath = Stem + ".solb";
+    }
+
+    MeditMesh Mesh;
+    if (!ReadMeditMesh(MeshPath, Mesh))
+        return false;
+    LogInfo("LoadMeditFile", "%s : %lu vertices, %lu edges, %lu triangles, %lu tetrahedra.", MeshPath.c_str( ),
+            (unsigned long)(Mesh.Vertices.size( ) / 3), (unsigned long)(Mesh.Edges.size( ) / 2),
+            (unsigned long)(Mesh.Triangles.size( ) / 3), (unsigned long)(Mesh.Tetrahedra.size( ) / 4));
+
+    LabelTable Table;
+    bool Is2D = (Mesh.Dimension == 2);
+    uint32_t Generation = NewGeometryGeneration( );
+    std::shared_ptr<MemoryManagement::LinearAllocator> Arena = std::make_shared<MemoryManagement::LinearAllocator>();
+    MemoryManagement::ArenaScope Scope(Arena.get());
+
+    std::vector<uint32_t> Boundary;
+    std::vector<int> BoundaryLabels;
+    if (Mesh.Triangles.empty( ) && !Mesh.Tetrahedra.empty( ))
+        ExtractBoundaryFaces(Mesh, Boundary, BoundaryLabels);
+    const std::vector<uint32_t>& Surface = (Mesh.Triangles.empty( )) ? Boundary : Mesh.Triangles;
+    const std::vector<int>& SurfaceLabels = (Mesh.Triangles.empty( )) ? BoundaryLabels : Mesh.TriangleLabels;
+
+    if (!Surface.empty( )) {
+        ConstructedGeometry Data(PlotID, 0);
+        Data.Generation = Generation;
+        Data.Arena = Arena;
+        Data.Name = MeshPath;
+        Data.Geo = ConstructGeometry(Mesh.Vertices, Surface, SurfaceLabels, Table);
+        if (Data.Geo.Data.Data == nullptr) {
+            LogWarning("LoadMeditFile", "Failed to import mesh.");
+        } else {
+            Data.Geo.Description.PrimitiveTopology = GEO_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+            Data.Geo.Description.PolygonMode = GEO_POLYGON_MODE_LINE;
+            Data.Geo.Type = GetTypeValue((Is2D) ? "Mesh2D" : "Mesh3D");
+            Data.PositionHash = HashPositions(Data.Geo);
+            Queue.push(std::move(Data));
+        }
+    }
+
+    if (!Mesh.Edges.empty( )) {
+        ConstructedGeometry Border(PlotID, 0);
+        Border.Generation = Generation;
+        Border.Arena = Arena;
+        std::vector<int> Labels(Mesh.Edges.size( ));
+        for (size_t i = 0; i < Labels.size( ); ++i) Labels[i] = Mesh.EdgeLabels[i / 2];
+
+        Border.Name = MeshPath;
+        Border.Geo = ConstructBorder(Mesh.Vertices, Mesh.Edges, Labels, Table);
+        if (Border.Geo.Data.Data == nullptr) {
+            LogWarning("LoadMeditFile", "Failed to import border.");
+        } else {
+            Border.Geo.Description.PrimitiveTopology = GEO_PRIMITIVE_TOPOLOGY_LINE_LIST;
+            Border.Geo.Description.PolygonMode = GEO_POLYGON_MODE_LINE;
+            Border.Geo.Type = GetTypeValue((Is2D) ? "Curve2D" : "Curve3D");
+            Border.PositionHash = HashPositions(Border.Geo);
+            Queue.push(std::move(Border));
+        }
+    }
+
+    if (!SolutionPath.empty( )) {
+        MeditSolution Solution;
+        if (ReadMeditSolution(SolutionPath, Solution))
+            PushSolutionFields(Mesh, Solution, Queue, PlotID, Generation, Arena);
+    }
+    return true;
+}
+
+}    // namespace JSON
+}    // namespace ffGraph
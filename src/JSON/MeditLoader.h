@@ -0,0 +1,81 @@
+/**
+ * @file MeditLoader.h
+ * @brief Reads FreeFEM Medit meshes (.mesh/.meshb) and solutions (.sol/.solb) straight from disk.
+ */
+#ifndef MEDIT_LOADER_H_
+#define MEDIT_LOADER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ThreadQueue.h"
+
+namespace ffGraph {
+namespace JSON {
+
+/**
+ * @brief Medit mesh, indices are converted to 0 based.
+ */
+struct MeditMesh {
+    int Dimension = 3;
+    // @brief xyz packed, z is 0 for 2D meshes.
+    std::vector<float> Vertices;
+    std::vector<int> VertexLabels;
+    std::vector<uint32_t> Edges;
+    std::vector<int> EdgeLabels;
+    std::vector<uint32_t> Triangles;
+    std::vector<int> TriangleLabels;
+    std::vector<uint32_t> Tetrahedra;
+    std::vector<int> TetrahedronLabels;
+};
+
+/**
+ * @brief Medit SolAtVertices section.
+ */
+struct MeditSolution {
+    int Dimension = 3;
+    // @brief Medit field types : 1 scalar, 2 vector, 3 symmetric tensor, 4 tensor.
+    std::vector<int> Types;
+    // @brief Number of floats per vertex, sum of the field sizes.
+    size_t Stride = 0;
+    std::vector<float> Values;
+};
+
+/**
+ * @brief Read a Medit mesh, ASCII (.mesh) or binary (.meshb). The file is memory mapped and sections are
+ * parsed in parallel chunks.
+ *
+ * @param Path [in] - Mesh file.
+ * @param Mesh [out] - Parsed mesh.
+ *
+ * @return bool - false if the file couldn't be read or is malformed.
+ */
+bool ReadMeditMesh(const std::string& Path, MeditMesh& Mesh);
+
+/**
+ * @brief Read a Medit solution, ASCII (.sol) or binary (.solb).
+ *
+ * @param Path [in] - Solution file.
+ * @param Solution [out] - Parsed SolAtVertices section.
+ *
+ * @return bool - false if the file couldn't be read, is malformed or has no SolAtVertices section.
+ */
+bool ReadMeditSolution(const std::string& Path, MeditSolution& Solution);
+
+/**
+ * @brief Load a mesh and, when it exists next to it, its solution file, then push the same
+ * ffGraph::ConstructedGeometry the network import produces : the mesh, its border and one geometry per
+ * solution field.
+ *
+ * @param Path [in] - .mesh/.meshb or .sol/.solb file, the other one is looked up with the same stem.
+ * @param Queue [in] - Queue receiving the geometries.
+ * @param PlotID [in] - Plot the geometries belong to.
+ *
+ * @return bool - false if the mesh couldn't be loaded.
+ */
+bool LoadMeditFile(const std::string& Path, ThreadSafeQueue& Queue, uint16_t PlotID);
+
+}    // namespace JSON
+}    // namespace ffGraph
+
+#endif    // MEDIT_LOADER_H_
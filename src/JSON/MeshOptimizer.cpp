@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include "MeshOptimizer.h"
+
+namespace ffGraph {
+namespace JSON {
+
+struct QuantizedKey {
+    int64_t x, y, z;
+};
+
+static uint64_t MixHash(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static size_t NextPowerOfTwo(size_t n)
+{
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+static void ComputeBounds(const std::vector<float>& Vertices, float Min[3], float Max[3])
+{
+    for (int k = 0; k < 3; ++k) {
+        Min[k] = FLT_MAX;
+        Max[k] = -FLT_MAX;
+    }
+    for (size_t i = 0; i < Vertices.size() / 3; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            Min[k] = std::min(Min[k], Vertices[i * 3 + k]);
+            Max[k] = std::max(Max[k], Vertices[i * 3 + k]);
+        }
+    }
+}
+
+size_t WeldVertices(std::vector<float>& Vertices, std::vector<float>* Attributes, size_t AttributeStride,
+                    std::vector<uint32_t>& Remap, float RelativeEpsilon)
+{
+    size_t VertexCount = Vertices.size() / 3;
+    Remap.resize(VertexCount);
+    if (VertexCount == 0)
+        return 0;
+    if (Attributes == nullptr)
+        AttributeStride = 0;
+
+    float Min[3], Max[3];
+    ComputeBounds(Vertices, Min, Max);
+    float Diagonal = sqrtf((Max[0] - Min[0]) * (Max[0] - Min[0]) + (Max[1] - Min[1]) * (Max[1] - Min[1]) +
+                           (Max[2] - Min[2]) * (Max[2] - Min[2]));
+    double InvStep = 1.0 / std::max((double)Diagonal * RelativeEpsilon, (double)FLT_MIN);
+
+    size_t Mask = NextPowerOfTwo(VertexCount * 2) - 1;
+    std::vector<uint32_t> Table(Mask + 1, UINT32_MAX);
+    std::vector<QuantizedKey> Keys(VertexCount);
+    size_t Unique = 0;
+
+    for (size_t v = 0; v < VertexCount; ++v) {
+        QuantizedKey Key = {(int64_t)std::llround((Vertices[v * 3 + 0] - Min[0]) * InvStep),
+                            (int64_t)std::llround((Vertices[v * 3 + 1] - Min[1]) * InvStep),
+                            (int64_t)std::llround((Vertices[v * 3 + 2] - Min[2]) * InvStep)};
+        const float *Attribute = (AttributeStride) ? Attributes->data() + v * AttributeStride : nullptr;
+
+        uint64_t h = MixHash((uint64_t)Key.x * 73856093ULL ^ (uint64_t)Key.y * 19349663ULL ^ (uint64_t)Key.z * 83492791ULL);
+        for (size_t k = 0; k < AttributeStride; ++k) {
+            uint32_t Bits;
+            memcpy(&Bits, Attribute + k, sizeof(uint32_t));
+            h = MixHash(h ^ Bits);
+        }
+
+        size_t Slot = h & Mask;
+        while (true) {
+            uint32_t Candidate = Table[Slot];
+            if (Candidate == UINT32_MAX) {
+                // Unique <= v, compacting in place never overwrites a vertex that is still to be read.
+                Table[Slot] = (uint32_t)Unique;
+                Keys[Unique] = Key;
+                memmove(&Vertices[Unique * 3], &Vertices[v * 3], sizeof(float) * 3);
+                if (AttributeStride)
+                    memmove(Attributes->data() + Unique * AttributeStride, Attribute, sizeof(float) * AttributeStride);
+                Remap[v] = (uint32_t)Unique;
+                Unique += 1;
+                break;
+            }
+            const QuantizedKey& Other = Keys[Candidate];
+            if (Other.x == Key.x && Other.y == Key.y && Other.z == Key.z &&
+                (AttributeStride == 0 ||
+                 memcmp(Attributes->data() + Candidate * AttributeStride, Attribute, sizeof(float) * AttributeStride) == 0)) {
+                Remap[v] = Candidate;
+                break;
+            }
+            Slot = (Slot + 1) & Mask;
+        }
+    }
+    Vertices.resize(Unique * 3);
+    if (AttributeStride)
+        Attributes->resize(Unique * AttributeStride);
+    return Unique;
+}
+
+std::vector<uint32_t> ComputeVertexFetchRemap(const std::vector<uint32_t>& Indices, size_t VertexCount)
+{
+    std::vector<uint32_t> Remap(VertexCount, UINT32_MAX);
+    uint32_t Next = 0;
+
+    for (size_t i = 0; i < Indices.size(); ++i) {
+        if (Remap[Indices[i]] == UINT32_MAX)
+            Remap[Indices[i]] = Next++;
+    }
+    for (size_t v = 0; v < VertexCount; ++v) {
+        if (Remap[v] == UINT32_MAX)
+            Remap[v] = Next++;
+    }
+    return Remap;
+}
+
+void RemapVertexAttribute(std::vector<float>& Data, size_t Stride, const std::vector<uint32_t>& Remap)
+{
+    std::vector<float> Out(Data.size());
+
+    for (size_t v = 0; v < Remap.size(); ++v) {
+        memcpy(&Out[Remap[v] * Stride], &Data[v * Stride], sizeof(float) * Stride);
+    }
+    Data.swap(Out);
+}
+
+void RemapIndices(std::vector<uint32_t>& Indices, const std::vector<uint32_t>& Remap)
+{
+    for (size_t i = 0; i < Indices.size(); ++i) {
+        Indices[i] = Remap[Indices[i]];
+    }
+}
+
+// Spread the 21 low bits of v so that there are two zero bits between each of them.
+static uint64_t SpreadBits3(uint64_t v)
+{
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+std::vector<uint32_t> ComputeMortonElementOrder(const std::vector<float>& Vertices,
+                                                const std::vector<uint32_t>& Indices, size_t VerticesPerElement)
+{
+    size_t ElementCount = Indices.size() / VerticesPerElement;
+    std::vector<std::pair<uint64_t, uint32_t>> Codes(ElementCount);
+    float Min[3], Max[3];
+    ComputeBounds(Vertices, Min, Max);
+
+    float Scale[3];
+    for (int k = 0; k < 3; ++k) {
+        float Extent = Max[k] - Min[k];
+        Scale[k] = (Extent > 0.f) ? (float)0x1fffff / Extent : 0.f;
+    }
+
+    for (size_t e = 0; e < ElementCount; ++e) {
+        float Centroid[3] = {0.f, 0.f, 0.f};
+        for (size_t k = 0; k < VerticesPerElement; ++k) {
+            uint32_t v = Indices[e * VerticesPerElement + k];
+            Centroid[0] += Vertices[v * 3 + 0];
+            Centroid[1] += Vertices[v * 3 + 1];
+            Centroid[2] += Vertices[v * 3 + 2];
+        }
+        uint64_t Code = 0;
+        for (int k = 0; k < 3; ++k) {
+            float c = Centroid[k] / (float)VerticesPerElement;
+            uint64_t q = (uint64_t)std::min(std::max((c - Min[k]) * Scale[k], 0.f), (float)0x1fffff);
+            Code |= SpreadBits3(q) << k;
+        }
+        Codes[e] = std::make_pair(Code, (uint32_t)e);
+    }
+    std::sort(Codes.begin(), Codes.end());
+
+    std::vector<uint32_t> Order(ElementCount);
+    for (size_t e = 0; e < ElementCount; ++e) Order[e] = Codes[e].second;
+    return Order;
+}
+
+MeshOptimizeStats OptimizeMesh(std::vector<float>& Vertices, std::vector<uint32_t>& Indices,
+                               const std::vector<std::vector<uint32_t> *>& OtherIndices)
+{
+    MeshOptimizeStats Stats;
+    size_t VertexCount = Vertices.size() / 3;
+
+    Stats.VertexCountBefore = VertexCount;
+
+    std::vector<uint32_t> Remap;
+    VertexCount = WeldVertices(Vertices, nullptr, 0, Remap);
+    RemapIndices(Indices, Remap);
+    for (size_t i = 0; i < OtherIndices.size(); ++i) RemapIndices(*OtherIndices[i], Remap);
+
+    // Triangles along a Morton curve, consecutive ones then read neighbouring vertices.
+    std::vector<uint32_t> Order = ComputeMortonElementOrder(Vertices, Indices, 3);
+    std::vector<uint32_t> Ordered(Indices.size());
+    for (size_t t = 0; t < Order.size(); ++t) memcpy(&Ordered[t * 3], &Indices[Order[t] * 3], sizeof(uint32_t) * 3);
+    Indices.swap(Ordered);
+
+    Remap = ComputeVertexFetchRemap(Indices, VertexCount);
+    RemapVertexAttribute(Vertices, 3, Remap);
+    RemapIndices(Indices, Remap);
+    for (size_t i = 0; i < OtherIndices.size(); ++i) RemapIndices(*OtherIndices[i], Remap);
+
+    Stats.VertexCountAfter = VertexCount;
+    return Stats;
+}
+
+}    // namespace JSON
+}    // namespace ffGraph
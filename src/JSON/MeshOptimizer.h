@@ -0,0 +1,83 @@
+/**
+ * @file MeshOptimizer.h
+ * @brief Optional import stage : vertex welding and vertex locality ordering. The meshes are drawn
+ * de-indexed, the orders only make the gathers of the import kernels read neighbouring vertices.
+ */
+#ifndef MESH_OPTIMIZER_H_
+#define MESH_OPTIMIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ffGraph {
+namespace JSON {
+
+/**
+ * @brief Numbers reported by ffGraph::JSON::OptimizeMesh.
+ */
+struct MeshOptimizeStats {
+    size_t VertexCountBefore = 0;
+    size_t VertexCountAfter = 0;
+};
+
+/**
+ * @brief Merge vertices sharing the same quantized position (and attribute when given), remapping Indices.
+ *
+ * @param Vertices [in/out] - xyz packed positions, compacted in place.
+ * @param Attributes [in/out] - Optional per vertex attribute (AttributeStride floats per vertex), compacted in place.
+ * @param AttributeStride [in] - Number of floats per vertex in Attributes, 0 when there is none.
+ * @param Remap [out] - For each original vertex, its index after welding.
+ * @param RelativeEpsilon [in] - Quantization step, relative to the bounding box diagonal.
+ *
+ * @return size_t - Number of vertices after welding.
+ */
+size_t WeldVertices(std::vector<float>& Vertices, std::vector<float>* Attributes, size_t AttributeStride,
+                    std::vector<uint32_t>& Remap, float RelativeEpsilon = 1e-6f);
+
+/**
+ * @brief Renumber vertices in order of first use in Indices so vertex fetches become sequential.
+ *
+ * @return std::vector<uint32_t> - For each original vertex, its new index. Unused vertices are kept at the end.
+ */
+std::vector<uint32_t> ComputeVertexFetchRemap(const std::vector<uint32_t>& Indices, size_t VertexCount);
+
+/**
+ * @brief Apply a vertex remap (as returned by ffGraph::JSON::ComputeVertexFetchRemap) to a packed attribute array.
+ */
+void RemapVertexAttribute(std::vector<float>& Data, size_t Stride, const std::vector<uint32_t>& Remap);
+
+/**
+ * @brief Apply a vertex remap to an index list.
+ */
+void RemapIndices(std::vector<uint32_t>& Indices, const std::vector<uint32_t>& Remap);
+
+/**
+ * @brief Order the elements of an index list along a Morton (Z-order) curve of their centroids.
+ *
+ * @param Vertices [in] - xyz packed positions.
+ * @param Indices [in] - Element list.
+ * @param VerticesPerElement [in] - 3 for triangles, 2 for edges.
+ *
+ * @return std::vector<uint32_t> - Element indices in traversal order.
+ */
+std::vector<uint32_t> ComputeMortonElementOrder(const std::vector<float>& Vertices,
+                                                const std::vector<uint32_t>& Indices, size_t VerticesPerElement);
+
+/**
+ * @brief Vertex locality optimization of a triangle mesh : welding, Morton triangle order then vertex fetch
+ * order. Every index list in OtherIndices is remapped to the new vertex numbering.
+ *
+ * @param Vertices [in/out] - xyz packed positions.
+ * @param Indices [in/out] - Triangle list to optimize.
+ * @param OtherIndices [in/out] - Index lists sharing the same vertices (borders, iso support), only remapped.
+ *
+ * @return ffGraph::JSON::MeshOptimizeStats
+ */
+MeshOptimizeStats OptimizeMesh(std::vector<float>& Vertices, std::vector<uint32_t>& Indices,
+                               const std::vector<std::vector<uint32_t> *>& OtherIndices);
+
+}    // namespace JSON
+}    // namespace ffGraph
+
+#endif    // MESH_OPTIMIZER_H_
@@ -0,0 +1,237 @@
+#include <chrono>
+#include <algorithm>
+#include <utility>
+#include "CopyCounter.h"
+#include "Logger.h"
+#include "MemoryTracker.h"
+#include "Payload.h"
+
+namespace ffGraph {
+namespace JSON {
+
+Payload::Payload(std::string&& Data) : Memory(std::move(Data))
+{
+    Bytes = Memory.size( );
+    Retrack( );
+}
+
+Payload::Payload(Payload&& Other)
+    : Memory(std::move(Other.Memory)), Path(std::move(Other.Path)), Bytes(Other.Bytes), OwnsFile(Other.OwnsFile), View(Other.View),
+      Tracked(Other.Tracked), Copied(Other.Copied)
+{
+    Other.Path.clear( );
+    Other.Bytes = 0;
+    Other.OwnsFile = false;
+    Other.View = IO::MappedFile( );
+    Other.Tracked = 0;
+    Other.Copied = 0;
+}
+
+Payload& Payload::operator=(Payload&& Other)
+{
+    if (this != &Other) {
+        Release( );
+        Memory = std::move(Other.Memory);
+        Path = std::move(Other.Path);
+        Bytes = Other.Bytes;
+        OwnsFile = Other.OwnsFile;
+        View = Other.View;
+        Tracked = Other.Tracked;
+        Copied = Other.Copied;
+        Other.Path.clear( );
+        Other.Bytes = 0;
+        Other.OwnsFile = false;
+        Other.View = IO::MappedFile( );
+        Other.Tracked = 0;
+        Other.Copied = 0;
+    }
+    return *this;
+}
+
+Payload::~Payload( ) { Release( ); }
+
+void Payload::Release( )
+{
+    Unmap( );
+    if (OwnsFile && !Path.empty( ))
+        IO::RemoveFile(Path);
+    std::string( ).swap(Memory);
+    Retrack( );
+    Path.clear( );
+    Bytes = 0;
+    OwnsFile = false;
+    Copied = 0;
+}
+
+void Payload::Retrack( )
+{
+    // The small string buffer lives inside the payload, only heap storage is accounted.
+    size_t Now = (Memory.capacity( ) > std::string( ).capacity( )) ? Memory.capacity( ) : 0;
+    if (Now == Tracked)
+        return;
+    MemoryManagement::MemoryTracker& Tracker = MemoryManagement::GetMemoryTracker( );
+    if (Now > Tracked)
+        Tracker.Add(MemoryManagement::MEMORY_TAG_NETWORK, Now - Tracked, (Tracked == 0) ? 1 : 0);
+    else
+        Tracker.Remove(MemoryManagement::MEMORY_TAG_NETWORK, Tracked - Now, (Now == 0) ? 1 : 0);
+    Tracked = Now;
+}
+
+Payload Payload::FromFile(const std::string& Path)
+{
+    Payload p;
+    IO::MappedFile File;
+    if (IO::MapFile(Path, File)) {
+        p.Path = Path;
+        p.Bytes = File.Size;
+        IO::UnmapFile(File);
+    }
+    return p;
+}
+
+const uint8_t *Payload::Map( )
+{
+    if (!IsSpilled( ))
+        return (const uint8_t *)Memory.data( );
+    if (View.Data == nullptr && !IO::MapFile(Path, View))
+        return nullptr;
+    return View.Data;
+}
+
+void Payload::Unmap( )
+{
+    if (View.Data != nullptr)
+        IO::UnmapFile(View);
+}
+
+void PayloadQueue::Push(Payload&& Item)
+{
+    std::unique_lock<std::mutex> lock(Mutex);
+    if (Item.IsSpilled( ))
+        FileBytes += Item.Size( );
+    else
+        MemoryBytes += Item.Size( );
+    Queue.push_back(std::move(Item));
+    lock.unlock( );
+    Conditional.notify_one( );
+}
+
+bool PayloadQueue::TryPop(Payload& Item)
+{
+    return WaitPop(Item, 0);
+}
+
+bool PayloadQueue::WaitPop(Payload& Item, uint32_t TimeoutMs)
+{
+    std::unique_lock<std::mutex> lock(Mutex);
+    if (Queue.empty( ) && TimeoutMs)
+        Conditional.wait_for(lock, std::chrono::milliseconds(TimeoutMs), [this]( ) { return !Queue.empty( ); });
+    if (Queue.empty( ))
+        return false;
+    Item = std::move(Queue.front( ));
+    Queue.pop_front( );
+    if (Item.IsSpilled( ))
+        FileBytes -= Item.Size( );
+    else
+        MemoryBytes -= Item.Size( );
+    return true;
+}
+
+bool PayloadQueue::Empty( )
+{
+    std::unique_lock<std::mutex> lock(Mutex);
+    return Queue.empty( );
+}
+
+size_t PayloadQueue::Size( )
+{
+    std::unique_lock<std::mutex> lock(Mutex);
+    return Queue.size( );
+}
+
+std::string PayloadQueue::NewSpillPath( )
+{
+    return IO::GetTmpFile(NextSpillID++);
+}
+
+bool PayloadBuilder::ShouldSpill(size_t Incoming) const
+{
+    const SpillSettings& s = Target.Settings;
+    size_t MessageSize = Current.Bytes + Incoming;
+
+    if (s.MessageThreshold != 0 && MessageSize > s.MessageThreshold)
+        return true;
+    return s.BacklogThreshold != 0 && Target.InMemoryBytes( ) + MessageSize > s.BacklogThreshold;
+}
+
+void PayloadBuilder::Spill( )
+{
+    std::string Path = Target.NewSpillPath( );
+    if (IO::OpenOutputFile(Path, SpillFile) && IO::WriteOutputFile(SpillFile, Current.Memory.data( ), Current.Memory.size( ))) {
+        Current.Path = Path;
+        Current.OwnsFile = true;
+        CountCopy(COPY_STAGE_PAYLOAD, Current.Memory.size( ));
+        std::string( ).swap(Current.Memory);
+    } else {
+        IO::CloseOutputFile(SpillFile);
+        IO::RemoveFile(Path);
+        LogWarning("PayloadBuilder", "Failed to spill message, keeping it in memory.");
+    }
+}
+
+void PayloadBuilder::Append(const char *Data, size_t Size)
+{
+    if (!Current.IsSpilled( ) && ShouldSpill(Size))
+        Spill( );
+    if (Current.IsSpilled( )) {
+        if (!IO::WriteOutputFile(SpillFile, Data, Size))
+            LogWarning("PayloadBuilder", "Lost %lu bytes of a spilled message.", (unsigned long)Size);
+    } else {
+        Current.Memory.append(Data, Size);
+        Current.Copied += Size;
+    }
+    CountCopy(COPY_STAGE_PAYLOAD, Size);
+    Current.Bytes += Size;
+    Current.Retrack( );
+}
+
+char *PayloadBuilder::Reserve(size_t Size)
+{
+    if (!Current.IsSpilled( ) && ShouldSpill(Size))
+        Spill( );
+    Reserved = Size;
+    if (Current.IsSpilled( )) {
+        Scratch.resize(Size);
+        return &Scratch[0];
+    }
+    size_t Offset = Current.Memory.size( );
+    Current.Memory.resize(Offset + Size);
+    return &Current.Memory[Offset];
+}
+
+void PayloadBuilder::Commit(size_t Written)
+{
+    Written = std::min(Written, Reserved);
+    if (Current.IsSpilled( )) {
+        if (Written != 0 && !IO::WriteOutputFile(SpillFile, Scratch.data( ), Written))
+            LogWarning("PayloadBuilder", "Lost %lu bytes of a spilled message.", (unsigned long)Written);
+        CountCopy(COPY_STAGE_PAYLOAD, Written);
+    } else {
+        Current.Memory.resize(Current.Memory.size( ) - (Reserved - Written));
+    }
+    Current.Bytes += Written;
+    Reserved = 0;
+    Current.Retrack( );
+}
+
+void PayloadBuilder::Submit( )
+{
+    // The reader maps the file, everything must be written first.
+    if (SpillFile.IsOpen( ) && !IO::CloseOutputFile(SpillFile))
+        LogWarning("PayloadBuilder", "Spilled message %s may be truncated.", Current.Path.c_str( ));
+    Target.Push(std::move(Current));
+    Current = Payload( );
+}
+
+}    // namespace JSON
+}    // namespace ffGraph
@@ -0,0 +1,173 @@
+/**
+ * @file Payload.h
+ * @brief Raw CBOR messages waiting to be decoded, kept in memory or spilled to temporary files.
+ */
+#ifndef PAYLOAD_H_
+#define PAYLOAD_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include "IO.h"
+
+namespace ffGraph {
+namespace JSON {
+
+/**
+ * @brief When received messages are written through to temporary files instead of being kept in memory.
+ */
+struct SpillSettings {
+    // @brief A single message bigger than this is spilled, 0 disables spilling.
+    size_t MessageThreshold = 256 * 1024 * 1024;
+    // @brief Messages are spilled when the in-memory backlog would grow over this, 0 disables spilling.
+    size_t BacklogThreshold = 1024 * 1024 * 1024;
+};
+
+/**
+ * @brief One complete message. Either owns its bytes or a temporary file, which is deleted with the payload.
+ */
+class Payload {
+   public:
+    Payload( ) = default;
+    explicit Payload(std::string&& Bytes);
+    Payload(Payload&& Other);
+    Payload& operator=(Payload&& Other);
+    ~Payload( );
+
+    Payload(const Payload&) = delete;
+    Payload& operator=(const Payload&) = delete;
+
+    /**
+     * @brief Wrap a file written by someone else. The file is not deleted with the payload.
+     */
+    static Payload FromFile(const std::string& Path);
+
+    bool IsSpilled( ) const { return !Path.empty( ); }
+    size_t Size( ) const { return Bytes; }
+    // @brief Bytes copied into the payload from another buffer (ffGraph::JSON::PayloadBuilder::Append).
+    size_t CopiedBytes( ) const { return Copied; }
+
+    /**
+     * @brief Get a read only view on the message, mapping the file if the payload was spilled.
+     *
+     * @return const uint8_t* - nullptr if the spill file couldn't be mapped.
+     */
+    const uint8_t *Map( );
+
+    /**
+     * @brief Release the view returned by ffGraph::JSON::Payload::Map.
+     */
+    void Unmap( );
+
+   private:
+    friend class PayloadBuilder;
+
+    void Release( );
+
+    /**
+     * @brief Update the network bytes accounted to this payload after Memory changed.
+     */
+    void Retrack( );
+
+    std::string Memory;
+    std::string Path;
+    size_t Bytes = 0;
+    bool OwnsFile = false;
+    IO::MappedFile View;
+    size_t Tracked = 0;
+    size_t Copied = 0;
+};
+
+/**
+ * @brief Thread safe FIFO of payloads shared between the ffGraph::ffClient and the render loop.
+ */
+class PayloadQueue {
+   public:
+    PayloadQueue( ) {}
+    PayloadQueue(const PayloadQueue&) = delete;
+    PayloadQueue& operator=(const PayloadQueue&) = delete;
+
+    void Push(Payload&& Item);
+    bool TryPop(Payload& Item);
+    /**
+     * @brief Same as ffGraph::JSON::PayloadQueue::TryPop, waiting at most TimeoutMs milliseconds for a payload.
+     */
+    bool WaitPop(Payload& Item, uint32_t TimeoutMs);
+    bool Empty( );
+    size_t Size( );
+
+    size_t InMemoryBytes( ) const { return MemoryBytes.load( ); }
+    size_t SpilledBytes( ) const { return FileBytes.load( ); }
+
+    /**
+     * @brief Unique temporary path for the next spilled payload.
+     */
+    std::string NewSpillPath( );
+
+    SpillSettings Settings;
+
+   private:
+    std::deque<Payload> Queue;
+    std::mutex Mutex;
+    std::condition_variable Conditional;
+    std::atomic<size_t> MemoryBytes{0};
+    std::atomic<size_t> FileBytes{0};
+    std::atomic<int> NextSpillID{0};
+};
+
+/**
+ * @brief Accumulates the packets of one message, switching to a temporary file as soon as the message or
+ * the queue backlog goes over the ffGraph::JSON::SpillSettings thresholds.
+ */
+class PayloadBuilder {
+   public:
+    explicit PayloadBuilder(PayloadQueue& Queue) : Target(Queue) {}
+    ~PayloadBuilder( ) { IO::CloseOutputFile(SpillFile); }
+
+    PayloadBuilder(const PayloadBuilder&) = delete;
+    PayloadBuilder& operator=(const PayloadBuilder&) = delete;
+
+    /**
+     * @brief Copy Size bytes at the end of the message.
+     */
+    void Append(const char *Data, size_t Size);
+
+    /**
+     * @brief Get room for Size bytes at the end of the message, so a reader can write there directly
+     * instead of going through ffGraph::JSON::PayloadBuilder::Append. Must be followed by
+     * ffGraph::JSON::PayloadBuilder::Commit.
+     *
+     * @return char* - Size writable bytes.
+     */
+    char *Reserve(size_t Size);
+
+    /**
+     * @brief Keep the first Written bytes of the last ffGraph::JSON::PayloadBuilder::Reserve, the rest is
+     * dropped (0 when the read failed).
+     */
+    void Commit(size_t Written);
+
+    /**
+     * @brief Push the message built so far to the queue and start a new one.
+     */
+    void Submit( );
+
+   private:
+    bool ShouldSpill(size_t Incoming) const;
+    void Spill( );
+
+    PayloadQueue& Target;
+    Payload Current;
+    // @brief Open on Current.Path from the spill until the message is submitted.
+    IO::OutputFile SpillFile;
+    // @brief Room given by Reserve once the message is spilled, written to the file on Commit.
+    std::string Scratch;
+    size_t Reserved = 0;
+};
+
+}    // namespace JSON
+}    // namespace ffGraph
+
+#endif    // PAYLOAD_H_
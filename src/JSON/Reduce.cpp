@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include "Parallel.h"
+#include "Reduce.h"
+
+namespace ffGraph {
+namespace JSON {
+
+// Loops are written over ReduceLanes independent accumulators so the compiler can keep them in SIMD
+// registers. Data is processed by blocks small enough to stay in L1 between the vectorized range loop and
+// the (scalar) histogram scatter. The first pass bins on the 16 upper bits of the keys, which is coarse
+// (300 and 301 share a bin) : bins over [Min, Max] and exact percentiles need a second pass.
+static constexpr size_t ReduceLanes = 8;
+static constexpr size_t ReduceBlockSize = 1024;
+static constexpr size_t ReduceGrain = 1 << 18;
+
+struct PartialStats {
+    float Min = FLT_MAX;
+    float Max = -FLT_MAX;
+    double Sum = 0.0;
+    std::vector<uint32_t> Keys;
+};
+
+struct RefineSettings {
+    float Min = 0.f;
+    // @brief Bins per field unit, 0 when every value is the same.
+    float Scale = 0.f;
+    size_t Bins = 0;
+    // @brief Upper 16 bits of the keys whose lower 16 bits are counted.
+    std::vector<uint32_t> KeyBins;
+};
+
+struct PartialRefine {
+    std::vector<uint32_t> Histogram;
+    // @brief ReduceKeyBins counters per entry of RefineSettings::KeyBins.
+    std::vector<uint32_t> LowKeys;
+};
+
+/**
+ * @brief Map a float to an unsigned integer with the same ordering.
+ */
+static inline uint32_t FloatToKey(float Value)
+{
+    uint32_t Bits;
+    memcpy(&Bits, &Value, sizeof(uint32_t));
+    return (Bits & 0x80000000u) ? ~Bits : (Bits | 0x80000000u);
+}
+
+static inline float KeyToFloat(uint32_t Key)
+{
+    uint32_t Bits = (Key & 0x80000000u) ? (Key & 0x7fffffffu) : ~Key;
+    float Value;
+    memcpy(&Value, &Bits, sizeof(float));
+    return Value;
+}
+
+/**
+ * @brief Range and mean of one block. Means are computed on MeanValues, which is Values itself for scalar
+ * fields and the magnitudes for vector fields.
+ */
+static void ReduceBlock(const float *Values, const float *MeanValues, size_t n, PartialStats& Partial)
+{
+    float LaneMin[ReduceLanes], LaneMax[ReduceLanes], LaneSum[ReduceLanes];
+    for (size_t k = 0; k < ReduceLanes; ++k) {
+        LaneMin[k] = Partial.Min;
+        LaneMax[k] = Partial.Max;
+        LaneSum[k] = 0.f;
+    }
+    size_t i = 0;
+    for (; i + ReduceLanes <= n; i += ReduceLanes) {
+        for (size_t k = 0; k < ReduceLanes; ++k) {
+            float v = Values[i + k];
+            LaneMin[k] = (v < LaneMin[k]) ? v : LaneMin[k];
+            LaneMax[k] = (v > LaneMax[k]) ? v : LaneMax[k];
+            LaneSum[k] += MeanValues[i + k];
+        }
+    }
+    for (; i < n; ++i) {
+        LaneMin[0] = std::min(LaneMin[0], Values[i]);
+        LaneMax[0] = std::max(LaneMax[0], Values[i]);
+        LaneSum[0] += MeanValues[i];
+    }
+    float BlockSum = 0.f;
+    for (size_t k = 0; k < ReduceLanes; ++k) {
+        Partial.Min = std::min(Partial.Min, LaneMin[k]);
+        Partial.Max = std::max(Partial.Max, LaneMax[k]);
+        BlockSum += LaneSum[k];
+    }
+    Partial.Sum += (double)BlockSum;
+
+    uint32_t *Keys = Partial.Keys.data();
+    for (i = 0; i < n; ++i) Keys[FloatToKey(Values[i]) >> 16] += 1;
+}
+
+/**
+ * @brief Second pass over one block. Keys are computed on KeyValues, the fixed bins on BinValues, the same
+ * array for scalar fields and the squared magnitudes and magnitudes for vector fields.
+ */
+static void RefineBlock(const float *KeyValues, const float *BinValues, size_t n, const RefineSettings& Settings,
+                        PartialRefine& Partial)
+{
+    if (Settings.Bins != 0) {
+        uint32_t *Histogram = Partial.Histogram.data( );
+        float Last = (float)(Settings.Bins - 1);
+        for (size_t i = 0; i < n; ++i) {
+            float t = (BinValues[i] - Settings.Min) * Settings.Scale;
+            Histogram[(size_t)std::min(std::max(t, 0.f), Last)] += 1;
+        }
+    }
+    for (size_t j = 0; j < Settings.KeyBins.size( ); ++j) {
+        uint32_t *Low = Partial.LowKeys.data( ) + j * ReduceKeyBins;
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t Key = FloatToKey(KeyValues[i]);
+            if ((Key >> 16) == Settings.KeyBins[j]) Low[Key & 0xffffu] += 1;
+        }
+    }
+}
+
+/**
+ * @brief Run Block(Begin, End, Partial) over [0, Count) on every worker, each range starting from Initial.
+ *
+ * @return std::vector<PartialType> - One partial result per range.
+ */
+template <typename PartialType, typename Func>
+static std::vector<PartialType> ReduceRanges(size_t Count, const PartialType& Initial, Func&& Block)
+{
+    std::vector<PartialType> Partials(GetParallelWorkerCount( ));
+    size_t RangeSize = std::max((Count + Partials.size( ) - 1) / Partials.size( ), ReduceGrain);
+    size_t RangeCount = (Count + RangeSize - 1) / RangeSize;
+
+    ParallelFor(RangeCount, [&](size_t Begin, size_t End) {
+        for (size_t r = Begin; r < End; ++r) {
+            PartialType& Partial = Partials[r];
+            Partial = Initial;
+            size_t RangeEnd = std::min(Count, (r + 1) * RangeSize);
+            for (size_t b = r * RangeSize; b < RangeEnd; b += ReduceBlockSize)
+                Block(b, std::min(RangeEnd, b + ReduceBlockSize), Partial);
+        }
+    }, 1);
+    Partials.resize(RangeCount);
+    return Partials;
+}
+
+template <typename Func>
+static PartialStats ReduceParallel(size_t Count, Func&& Block)
+{
+    PartialStats Result;
+    Result.Keys.assign(ReduceKeyBins, 0);
+    std::vector<PartialStats> Partials = ReduceRanges(Count, Result, Block);
+
+    for (const auto& Partial : Partials) {
+        Result.Min = std::min(Result.Min, Partial.Min);
+        Result.Max = std::max(Result.Max, Partial.Max);
+        Result.Sum += Partial.Sum;
+        for (size_t k = 0; k < ReduceKeyBins; ++k) Result.Keys[k] += Partial.Keys[k];
+    }
+    return Result;
+}
+
+/**
+ * @brief Value at a fraction of a key bin, in field units.
+ */
+static float KeyBinValue(size_t Bin, bool SquaredKeys, float Fraction)
+{
+    float Low = KeyToFloat((uint32_t)(Bin << 16));
+    float High = KeyToFloat((uint32_t)((Bin << 16) | 0xffffu));
+    float Value = Low + (High - Low) * Fraction;
+    return (SquaredKeys) ? sqrtf(std::max(Value, 0.f)) : Value;
+}
+
+/**
+ * @brief Find the bin holding the sample of rank Target.
+ *
+ * @param Bins [in] - Histogram.
+ * @param Count [in] - Number of bins.
+ * @param Target [in] - Rank of the sample, in [0, sum of Bins].
+ * @param Rank [out] - Rank of the sample within the bin.
+ *
+ * @return size_t - Index of the bin.
+ */
+static size_t FindRankBin(const uint32_t *Bins, size_t Count, double Target, double& Rank)
+{
+    double Accumulated = 0.0;
+    size_t Last = 0;
+
+    for (size_t k = 0; k < Count; ++k) {
+        if (Bins[k] == 0) continue;
+        Last = k;
+        if (Accumulated + Bins[k] >= Target) {
+            Rank = Target - Accumulated;
+            return k;
+        }
+        Accumulated += Bins[k];
+    }
+    Rank = Bins[Last];
+    return Last;
+}
+
+static FieldStats FinalizeStats(PartialStats& Partial, size_t Count, bool SquaredKeys)
+{
+    FieldStats Stats;
+    Stats.Count = Count;
+    if (Count == 0)
+        return Stats;
+    Stats.SquaredKeys = SquaredKeys;
+    Stats.Min = (SquaredKeys) ? sqrtf(Partial.Min) : Partial.Min;
+    Stats.Max = (SquaredKeys) ? sqrtf(Partial.Max) : Partial.Max;
+    Stats.Mean = (float)(Partial.Sum / (double)Count);
+    Stats.KeyHistogram.swap(Partial.Keys);
+    return Stats;
+}
+
+/**
+ * @brief Second pass : bin the values over [Min, Max] and count the lower 16 bits of the keys in the key
+ * bins holding the ranks, which gives their exact value.
+ */
+template <typename Func>
+static void RefineStats(FieldStats& Stats, size_t Bins, const std::vector<float>& Ranks, Func&& Block)
+{
+    if (Stats.Count == 0 || (Bins == 0 && Ranks.empty( )))
+        return;
+    RefineSettings Settings;
+    Settings.Min = Stats.Min;
+    Settings.Bins = Bins;
+    float Range = Stats.Max - Stats.Min;
+    Settings.Scale = (Range > 0.f) ? (float)Bins / Range : 0.f;
+
+    std::vector<size_t> Slots(Ranks.size( ));
+    std::vector<double> InBin(Ranks.size( ));
+    for (size_t r = 0; r < Ranks.size( ); ++r) {
+        double Target = (double)std::min(std::max(Ranks[r], 0.f), 1.f) * (double)Stats.Count;
+        uint32_t Bin = (uint32_t)FindRankBin(Stats.KeyHistogram.data( ), ReduceKeyBins, Target, InBin[r]);
+        auto Found = std::find(Settings.KeyBins.begin( ), Settings.KeyBins.end( ), Bin);
+        Slots[r] = (size_t)(Found - Settings.KeyBins.begin( ));
+        if (Found == Settings.KeyBins.end( ))
+            Settings.KeyBins.push_back(Bin);
+    }
+
+    PartialRefine Result;
+    Result.Histogram.assign(Bins, 0);
+    Result.LowKeys.assign(Settings.KeyBins.size( ) * ReduceKeyBins, 0);
+    std::vector<PartialRefine> Partials = ReduceRanges(Stats.Count, Result,
+        [&Settings, &Block](size_t Begin, size_t End, PartialRefine& P) { Block(Begin, End, Settings, P); });
+    for (const auto& Partial : Partials) {
+        for (size_t b = 0; b < Bins; ++b) Result.Histogram[b] += Partial.Histogram[b];
+        for (size_t k = 0; k < Result.LowKeys.size( ); ++k) Result.LowKeys[k] += Partial.LowKeys[k];
+    }
+    Stats.Histogram.swap(Result.Histogram);
+
+    for (size_t r = 0; r < Ranks.size( ); ++r) {
+        double Ignored;
+        uint32_t Low = (uint32_t)FindRankBin(Result.LowKeys.data( ) + Slots[r] * ReduceKeyBins, ReduceKeyBins, InBin[r], Ignored);
+        float Value = KeyToFloat((Settings.KeyBins[Slots[r]] << 16) | Low);
+        Value = (Stats.SquaredKeys) ? sqrtf(std::max(Value, 0.f)) : Value;
+        Stats.Ranks.push_back(std::min(std::max(Ranks[r], 0.f), 1.f));
+        Stats.RankValues.push_back(std::min(std::max(Value, Stats.Min), Stats.Max));
+    }
+}
+
+float FieldStats::Percentile(float P) const
+{
+    if (Count == 0 || KeyHistogram.empty( ))
+        return 0.f;
+    P = std::min(std::max(P, 0.f), 1.f);
+    for (size_t r = 0; r < Ranks.size( ); ++r)
+        if (Ranks[r] == P) return RankValues[r];
+
+    double Rank = 0.0;
+    size_t k = FindRankBin(KeyHistogram.data( ), ReduceKeyBins, (double)P * (double)Count, Rank);
+    float Fraction = (float)(Rank / (double)KeyHistogram[k]);
+    return std::min(std::max(KeyBinValue(k, SquaredKeys, Fraction), Min), Max);
+}
+
+FieldStats ReduceScalarField(const float *Values, size_t Count, size_t Bins, const std::vector<float>& Ranks)
+{
+    PartialStats Partial = ReduceParallel(Count, [Values](size_t Begin, size_t End, PartialStats& P) {
+        ReduceBlock(Values + Begin, Values + Begin, End - Begin, P);
+    });
+    FieldStats Stats = FinalizeStats(Partial, Count, false);
+    RefineStats(Stats, Bins, Ranks, [Values](size_t Begin, size_t End, const RefineSettings& S, PartialRefine& P) {
+        RefineBlock(Values + Begin, Values + Begin, End - Begin, S, P);
+    });
+    return Stats;
+}
+
+static void SquaredMagnitudes(const float *v, size_t n, size_t Components, float *Squared)
+{
+    if (Components == 2) {
+        for (size_t i = 0; i < n; ++i) Squared[i] = v[i * 2] * v[i * 2] + v[i * 2 + 1] * v[i * 2 + 1];
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            float s = 0.f;
+            for (size_t c = 0; c < Components; ++c) s += v[i * Components + c] * v[i * Components + c];
+            Squared[i] = s;
+        }
+    }
+}
+
+FieldStats ReduceVectorMagnitude(const float *Values, size_t Count, size_t Components, size_t Bins,
+                                 const std::vector<float>& Ranks)
+{
+    PartialStats Partial = ReduceParallel(Count, [Values, Components](size_t Begin, size_t End, PartialStats& P) {
+        float Squared[ReduceBlockSize];
+        float Magnitude[ReduceBlockSize];
+        size_t n = End - Begin;
+
+        SquaredMagnitudes(Values + Begin * Components, n, Components, Squared);
+        for (size_t i = 0; i < n; ++i) Magnitude[i] = sqrtf(Squared[i]);
+        ReduceBlock(Squared, Magnitude, n, P);
+    });
+    FieldStats Stats = FinalizeStats(Partial, Count, true);
+    RefineStats(Stats, Bins, Ranks, [Values, Components](size_t Begin, size_t End, const RefineSettings& S, PartialRefine& P) {
+        float Squared[ReduceBlockSize];
+        float Magnitude[ReduceBlockSize];
+        size_t n = End - Begin;
+
+        SquaredMagnitudes(Values + Begin * Components, n, Components, Squared);
+        for (size_t i = 0; i < n; ++i) Magnitude[i] = sqrtf(Squared[i]);
+        RefineBlock(Squared, Magnitude, n, S, P);
+    });
+    return Stats;
+}
+
+}    // namespace JSON
+}    // namespace ffGraph
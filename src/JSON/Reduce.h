@@ -0,0 +1,84 @@
+/**
+ * @file Reduce.h
+ * @brief Multi-threaded statistics over the fields received from FreeFEM. The range, mean and a coarse key
+ * histogram come from a first pass, the fixed bins histogram and the requested percentiles from a second
+ * one once the range is known.
+ */
+#ifndef REDUCE_H_
+#define REDUCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ffGraph {
+namespace JSON {
+
+/**
+ * @brief Number of bins of the order-preserving key histogram (upper 16 bits of the float keys).
+ */
+constexpr size_t ReduceKeyBins = 65536;
+
+/**
+ * @brief Default number of bins of ffGraph::JSON::FieldStats::Histogram.
+ */
+constexpr size_t ReduceDefaultBins = 64;
+
+/**
+ * @brief Result of ffGraph::JSON::ReduceScalarField and ffGraph::JSON::ReduceVectorMagnitude.
+ */
+struct FieldStats {
+    size_t Count = 0;
+    float Min = 0.f;
+    float Max = 0.f;
+    float Mean = 0.f;
+    // @brief Fixed bins histogram over [Min, Max], binned on the values themselves. Empty if no bins were asked.
+    std::vector<uint32_t> Histogram;
+    // @brief Histogram of the 16 upper bits of the order-preserving keys, used for percentiles.
+    std::vector<uint32_t> KeyHistogram;
+    // @brief Keys are computed on squared magnitudes, percentiles need a square root.
+    bool SquaredKeys = false;
+    // @brief Percentiles asked to the reduction and their exact values.
+    std::vector<float> Ranks;
+    std::vector<float> RankValues;
+
+    /**
+     * @brief Value under which lie P (in [0, 1]) of the samples. Exact for the ranks asked to the reduction,
+     * otherwise interpolated in the key histogram with a relative error bounded by its 7 mantissa bits.
+     */
+    float Percentile(float P) const;
+};
+
+/**
+ * @brief Min, max, mean and histograms of a scalar field. The data is read a second time only for the
+ * fixed bins histogram and the ranks.
+ *
+ * @param Values [in] - Field values.
+ * @param Count [in] - Number of values.
+ * @param Bins [in] - Number of bins of FieldStats::Histogram, 0 for none.
+ * @param Ranks [in] - Percentiles (in [0, 1]) to compute exactly, see FieldStats::Percentile.
+ *
+ * @return ffGraph::JSON::FieldStats
+ */
+FieldStats ReduceScalarField(const float *Values, size_t Count, size_t Bins = ReduceDefaultBins,
+                             const std::vector<float>& Ranks = std::vector<float>( ));
+
+/**
+ * @brief Same as ffGraph::JSON::ReduceScalarField on the magnitudes of a vector field. The range is reduced
+ * on squared magnitudes, square roots are only taken on the results, for the mean and the fixed bins.
+ *
+ * @param Values [in] - Packed vectors.
+ * @param Count [in] - Number of vectors.
+ * @param Components [in] - Number of floats per vector.
+ * @param Bins [in] - Number of bins of FieldStats::Histogram, 0 for none.
+ * @param Ranks [in] - Percentiles (in [0, 1]) to compute exactly, see FieldStats::Percentile.
+ *
+ * @return ffGraph::JSON::FieldStats
+ */
+FieldStats ReduceVectorMagnitude(const float *Values, size_t Count, size_t Components, size_t Bins = ReduceDefaultBins,
+                                 const std::vector<float>& Ranks = std::vector<float>( ));
+
+}    // namespace JSON
+}    // namespace ffGraph
+
+#endif    // REDUCE_H_
@@ -1,64 +1,156 @@
-#include <nlohmann/json.hpp>
-#include <fstream>
+#include <chrono>
+#include <thread>
 #include "ThreadQueue.h"
 #include "Logger.h"
 
 namespace ffGraph {
 namespace JSON {
 
-using json = nlohmann::json;
+// Attempts spent yielding before a blocked call goes to sleep.
+static constexpr uint32_t SpinAttempts = 64;
 
-ConstructedGeometry ThreadSafeQueue::pop()
+void ThreadSafeQueue::Wait(std::condition_variable& Conditional, uint32_t Attempt)
 {
-    std::unique_lock<std::mutex> lock(Mutex);
-    while (Queue.empty()) {
-        Conditional.wait(lock);
+    if (Attempt < SpinAttempts) {
+        std::this_thread::yield();
+        return;
     }
-    auto item = Queue.front();
-    Queue.pop();
-    return item;
+    // The timeout bounds the cost of a wake up missed between the last try and the wait.
+    std::unique_lock<std::mutex> lock(Mutex);
+    Sleepers++;
+    Conditional.wait_for(lock, std::chrono::milliseconds(1));
+    Sleepers--;
 }
 
-void ThreadSafeQueue::pop(ConstructedGeometry& item)
+void ThreadSafeQueue::Wake(std::condition_variable& Conditional)
 {
+    if (Sleepers.load() == 0)
+        return;
     std::unique_lock<std::mutex> lock(Mutex);
-    while (Queue.empty()) {
-        Conditional.wait(lock);
+    Conditional.notify_all();
+}
+
+void ThreadSafeQueue::CountPushed(size_t Count)
+{
+    Pushed += Count;
+    size_t Depth = Ring.size();
+    size_t Peak = PeakDepth.load();
+    while (Depth > Peak && !PeakDepth.compare_exchange_weak(Peak, Depth)) {
     }
-    item = Queue.front();
-    Queue.pop();
+    Wake(NotEmpty);
 }
 
-void ThreadSafeQueue::push(const ConstructedGeometry& item)
+bool ThreadSafeQueue::try_push(ConstructedGeometry&& item)
 {
-    std::unique_lock<std::mutex> lock(Mutex);
-    Queue.push(item);
-    lock.unlock();
-    Conditional.notify_one();
+    if (Closed.load() || !Ring.try_push(std::move(item)))
+        return false;
+    CountPushed(1);
+    return true;
 }
 
-void ThreadSafeQueue::push(ConstructedGeometry&& item)
+bool ThreadSafeQueue::push(ConstructedGeometry&& item)
 {
-    std::unique_lock<std::mutex> lock(Mutex);
-    Queue.push(item);
-    lock.unlock();
-    Conditional.notify_one();
+    for (uint32_t Attempt = 0; !Ring.try_push(std::move(item)); ++Attempt) {
+        if (Closed.load())
+            return false;
+        if (Attempt == 0)
+            FullStalls++;
+        Wait(NotFull, Attempt);
+    }
+    CountPushed(1);
+    return true;
 }
 
-bool ThreadSafeQueue::empty()
+size_t ThreadSafeQueue::try_push_bulk(std::vector<ConstructedGeometry>& Items)
 {
-    std::unique_lock<std::mutex> lock(Mutex);
-    bool r = Queue.empty();
-    lock.unlock();
-    return r;
+    if (Closed.load() || Items.empty())
+        return 0;
+    size_t n = Ring.try_push_bulk(Items.data(), Items.size());
+    Items.erase(Items.begin(), Items.begin() + n);
+    if (n)
+        CountPushed(n);
+    return n;
 }
 
-size_t ThreadSafeQueue::size()
+bool ThreadSafeQueue::push_bulk(std::vector<ConstructedGeometry>& Items)
 {
+    size_t Done = 0;
+    for (uint32_t Attempt = 0; Done < Items.size(); ++Attempt) {
+        size_t n = Ring.try_push_bulk(Items.data() + Done, Items.size() - Done);
+        if (n) {
+            Done += n;
+            CountPushed(n);
+            Attempt = 0;
+            continue;
+        }
+        if (Closed.load()) {
+            Items.erase(Items.begin(), Items.begin() + Done);
+            return false;
+        }
+        if (Attempt == 0)
+            FullStalls++;
+        Wait(NotFull, Attempt);
+    }
+    Items.clear();
+    return true;
+}
+
+bool ThreadSafeQueue::try_pop(ConstructedGeometry& item)
+{
+    if (!Ring.try_pop(item))
+        return false;
+    Popped++;
+    Wake(NotFull);
+    return true;
+}
+
+bool ThreadSafeQueue::pop(ConstructedGeometry& item)
+{
+    for (uint32_t Attempt = 0; !Ring.try_pop(item); ++Attempt) {
+        if (Closed.load() && Ring.empty())
+            return false;
+        Wait(NotEmpty, Attempt);
+    }
+    Popped++;
+    Wake(NotFull);
+    return true;
+}
+
+size_t ThreadSafeQueue::try_pop_bulk(std::vector<ConstructedGeometry>& Out, size_t Max)
+{
+    size_t Ready = Ring.size();
+    if (Ready == 0)
+        return 0;
+    size_t Count = (Ready < Max) ? Ready : Max;
+    size_t First = Out.size();
+    Out.resize(First + Count);
+    size_t n = Ring.try_pop_bulk(Out.data() + First, Count);
+    Out.resize(First + n);
+    if (n) {
+        Popped += n;
+        Wake(NotFull);
+    }
+    return n;
+}
+
+void ThreadSafeQueue::close()
+{
+    Closed.store(true);
     std::unique_lock<std::mutex> lock(Mutex);
-    size_t r = Queue.size();
-    lock.unlock();
-    return r;
+    NotEmpty.notify_all();
+    NotFull.notify_all();
+}
+
+GeometryQueueStats ThreadSafeQueue::GetStats() const
+{
+    GeometryQueueStats s;
+    s.Depth = Ring.size();
+    s.PeakDepth = PeakDepth.load();
+    s.Capacity = Ring.capacity();
+    s.Pushed = Pushed.load();
+    s.Popped = Popped.load();
+    s.FullStalls = FullStalls.load();
+    return s;
 }
 
 }    // namespace JSON
@@ -1,36 +1,102 @@
 #ifndef THREAD_QUEUE_H_
 #define THREAD_QUEUE_H_
 
-#include <queue>
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <vector>
 #include "Geometry.h"
 #include "LabelTable.h"
+#include "MPMCQueue.h"
 
 namespace ffGraph {
 namespace JSON {
 
+struct GeometryQueueStats {
+    size_t Depth = 0;
+    size_t PeakDepth = 0;
+    size_t Capacity = 0;
+    uint64_t Pushed = 0;
+    uint64_t Popped = 0;
+    // @brief Number of blocking pushes which found the queue full and had to wait for the render loop.
+    uint64_t FullStalls = 0;
+};
+
+/**
+ * @brief Bounded queue of the geometries waiting for the render loop, built on a lock-free ffGraph::MPMCQueue.
+ * The try_ functions never block. The other ones wait for room (or for an item), first spinning then sleeping,
+ * and give up once the queue is closed.
+ */
 class ThreadSafeQueue {
     public:
-        ConstructedGeometry pop();
-        void pop(ConstructedGeometry& item);
-        void push(const ConstructedGeometry& item);
-        void push(ConstructedGeometry&& item);
+        static constexpr size_t DefaultCapacity = 1024;
 
-        bool empty();
-        size_t size();
+        explicit ThreadSafeQueue(size_t Capacity = DefaultCapacity) : Ring(Capacity) {}
 
         // delete copy constructor
         ThreadSafeQueue(const ThreadSafeQueue&) = delete;
         ThreadSafeQueue& operator=(const ThreadSafeQueue&) = delete;
 
-        ThreadSafeQueue() {};
+        /**
+         * @return bool - false if the queue was closed before item could be pushed.
+         */
+        bool push(ConstructedGeometry&& item);
+        bool try_push(ConstructedGeometry&& item);
+
+        /**
+         * @brief Push every item of Items, in order, then clear it.
+         *
+         * @return bool - false if the queue was closed before all of them could be pushed.
+         */
+        bool push_bulk(std::vector<ConstructedGeometry>& Items);
+
+        /**
+         * @brief Push the longest prefix of Items the queue has room for, and erase it from Items.
+         *
+         * @return size_t - Number of items pushed.
+         */
+        size_t try_push_bulk(std::vector<ConstructedGeometry>& Items);
+
+        /**
+         * @return bool - false if the queue is closed and empty.
+         */
+        bool pop(ConstructedGeometry& item);
+        bool try_pop(ConstructedGeometry& item);
+
+        /**
+         * @brief Append up to Max ready geometries to Out.
+         *
+         * @return size_t - Number of geometries appended.
+         */
+        size_t try_pop_bulk(std::vector<ConstructedGeometry>& Out, size_t Max = SIZE_MAX);
+
+        /**
+         * @brief Wake up the blocked producers and consumers and make every blocking call return.
+         */
+        void close();
+        bool closed() const { return Closed.load(); }
+
+        bool empty() const { return Ring.empty(); }
+        size_t size() const { return Ring.size(); }
+        GeometryQueueStats GetStats() const;
 
     private:
+        void Wait(std::condition_variable& Conditional, uint32_t Attempt);
+        void Wake(std::condition_variable& Conditional);
+        void CountPushed(size_t Count);
+
+        MPMCQueue<ConstructedGeometry> Ring;
+        std::atomic<bool> Closed{false};
+        std::atomic<size_t> PeakDepth{0};
+        std::atomic<uint64_t> Pushed{0};
+        std::atomic<uint64_t> Popped{0};
+        std::atomic<uint64_t> FullStalls{0};
 
-        std::queue<ConstructedGeometry> Queue;
+        // Only used to park the threads which waited too long, never on the fast path.
+        std::atomic<int> Sleepers{0};
         std::mutex Mutex;
-        std::condition_variable Conditional;
+        std::condition_variable NotEmpty;
+        std::condition_variable NotFull;
 };
 
 }    // namespace JSON
@@ -0,0 +1,41 @@
+#include "DeletionQueue.h"
+#include "GlobalEnvironment.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+void DeletionQueue::Defer(std::function<void( )> Destroy)
+{
+    Entries.push_back(Entry{Frame, std::move(Destroy)});
+}
+
+void DeletionQueue::DeferBuffer(const Buffer& b)
+{
+    if (b.Handle == VK_NULL_HANDLE)
+        return;
+    Buffer Copy = b;
+    Defer([Copy]( ) { DestroyBuffer(GetAllocator( ), Copy); });
+}
+
+void DeletionQueue::Advance( )
+{
+    Frame++;
+    while (!Entries.empty( ) && Entries.front( ).Frame + FramesInFlight <= Frame) {
+        // Popped first, a destructor may defer something else.
+        std::function<void( )> Destroy = std::move(Entries.front( ).Destroy);
+        Entries.pop_front( );
+        Destroy( );
+    }
+}
+
+void DeletionQueue::Flush( )
+{
+    while (!Entries.empty( )) {
+        std::function<void( )> Destroy = std::move(Entries.front( ).Destroy);
+        Entries.pop_front( );
+        Destroy( );
+    }
+}
+
+}    // namespace Vulkan
+}    // namespace ffGraph
@@ -0,0 +1,55 @@
+/**
+ * @file DeletionQueue.h
+ * @brief Vulkan objects the CPU is done with while a frame in flight may still use them, destroyed once
+ * that frame is over instead of waiting for the device to go idle.
+ */
+#ifndef DELETION_QUEUE_H_
+#define DELETION_QUEUE_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vulkan/vulkan.h>
+#include "Resource/Buffer/Buffer.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+// @brief Frames whose command buffers can still be executing, see Instance::FrameData.
+constexpr uint64_t FramesInFlight = 2;
+
+class DeletionQueue {
+   public:
+    /**
+     * @brief Run Destroy FramesInFlight frames from now.
+     */
+    void Defer(std::function<void( )> Destroy);
+    void DeferBuffer(const Buffer& b);
+
+    /**
+     * @brief Called once per rendered frame : destroy what was deferred FramesInFlight frames ago.
+     */
+    void Advance( );
+    /**
+     * @brief Destroy everything right away, the device must be idle.
+     */
+    void Flush( );
+
+    uint64_t GetFrame( ) const { return Frame; }
+    size_t Size( ) const { return Entries.size( ); }
+
+   private:
+    struct Entry {
+        uint64_t Frame;
+        std::function<void( )> Destroy;
+    };
+
+    uint64_t Frame = 0;
+    // @brief Oldest first.
+    std::deque<Entry> Entries;
+};
+
+}    // namespace Vulkan
+}    // namespace ffGraph
+
+#endif    // DELETION_QUEUE_H_
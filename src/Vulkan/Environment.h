@@ -4,6 +4,7 @@
 #include <vulkan/vulkan.h>
 #include "Window/NativeWindow.h"
 #include "Resource/Image/Image.h"
+#include "DeletionQueue.h"
 #include "vk_mem_alloc.h"
 
 namespace ffGraph {
@@ -42,6 +43,7 @@ struct Environment {
 
     VmaAllocator Allocator = 0;
     VkCommandPool TransfertCommandPool = VK_NULL_HANDLE;
+    DeletionQueue Deletion;
 
     struct GraphicInformations {
         VkRenderPass RenderPass = VK_NULL_HANDLE;
@@ -30,6 +30,8 @@ inline uint32_t GetGraphicQueueIndex( ) {
     return GlobalEnvironmentPTR->GPUInfos.QueueIndex[GlobalEnvironmentPTR->GPUInfos.GraphicQueueIndex];
 }
 
+inline DeletionQueue& GetDeletionQueue( ) { return GlobalEnvironmentPTR->Deletion; }
+
 inline VkRenderPass GetRenderPass( ) {
     return GlobalEnvironmentPTR->GraphManager.RenderPass;
 }
@@ -1,9 +1,35 @@
 #include <iostream>
 #include "Pipeline.h"
+#include "Geometry.h"
 
 namespace ffGraph {
 namespace Vulkan {
 
+/**
+ * @brief Positions and colours are read from a binding per GeometryStream, and the colours blended in
+ * during playback from a last one.
+ */
+static void SetVertexStreams(PipelineCreateInfos& n)
+{
+    n.BindingStrides.resize(GEO_STREAM_COUNT + 1);
+    n.BindingStrides[GEO_STREAM_POSITION] = StreamStride(GEO_STREAM_POSITION);
+    n.BindingStrides[GEO_STREAM_COLOR] = StreamStride(GEO_STREAM_COLOR);
+    n.BindingStrides[GEO_BINDING_NEXT_COLOR] = StreamStride(GEO_STREAM_COLOR);
+
+    n.VertexFormat.resize(3);
+    n.VertexFormat[0].Format = VK_FORMAT_R32G32B32_SFLOAT;
+    n.VertexFormat[0].Offset = 0;
+    n.VertexFormat[0].Binding = GEO_STREAM_POSITION;
+
+    n.VertexFormat[1].Format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    n.VertexFormat[1].Offset = 0;
+    n.VertexFormat[1].Binding = GEO_STREAM_COLOR;
+
+    n.VertexFormat[2].Format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    n.VertexFormat[2].Offset = 0;
+    n.VertexFormat[2].Binding = GEO_BINDING_NEXT_COLOR;
+}
+
 static PipelineCreateInfos NewCurve2DPipeline(ShaderLibrary& ShaderLib, void *pPushConstantData, size_t PushConstantSize, VkShaderStageFlags PushConstantStage)
 {
     PipelineCreateInfos n;
@@ -12,13 +38,7 @@ static PipelineCreateInfos NewCurve2DPipeline(ShaderLibrary& ShaderLib, void *pP
     n.PolygonMode = VK_POLYGON_MODE_LINE;
     n.LineWidth = 2;
 
-    n.VertexSize = sizeof(float) * 7;
-    n.VertexFormat.resize(2);
-    n.VertexFormat[0].Format = VK_FORMAT_R32G32B32_SFLOAT;
-    n.VertexFormat[0].Offset = 0;
-
-    n.VertexFormat[1].Format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    n.VertexFormat[1].Offset = sizeof(float) * 3;
+    SetVertexStreams(n);
 
     n.ShaderInfos.resize(2);
     n.ShaderInfos[0].Stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -44,9 +64,7 @@ static PipelineCreateInfos NewCurve3DPipeline(ShaderLibrary& ShaderLib, void *pP
     n.PolygonMode = VK_POLYGON_MODE_LINE;
     n.LineWidth = 2;
 
-    n.VertexSize = sizeof(float) * 7;
-    n.VertexFormat.resize(2);
-    n.VertexFormat[0].Offset = 0;
+    SetVertexStreams(n);
 
     n.ShaderInfos.resize(2);
     n.ShaderInfos[0].Stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -72,13 +90,7 @@ static PipelineCreateInfos NewMesh2DPipeline(ShaderLibrary& ShaderLib, void *pPu
     n.PolygonMode = VK_POLYGON_MODE_LINE;
     n.LineWidth = 2;
 
-    n.VertexSize = sizeof(float) * 7;
-    n.VertexFormat.resize(2);
-    n.VertexFormat[0].Format = VK_FORMAT_R32G32B32_SFLOAT;
-    n.VertexFormat[0].Offset = 0;
-
-    n.VertexFormat[1].Format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    n.VertexFormat[1].Offset = sizeof(float) * 3;
+    SetVertexStreams(n);
 
     n.ShaderInfos.resize(2);
     n.ShaderInfos[0].Stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -104,13 +116,7 @@ static PipelineCreateInfos NewMesh3DPipeline(ShaderLibrary& ShaderLib, void *pPu
     n.PolygonMode = VK_POLYGON_MODE_LINE;
     n.LineWidth = 2;
 
-    n.VertexSize = sizeof(float) * 7;
-    n.VertexFormat.resize(2);
-    n.VertexFormat[0].Format = VK_FORMAT_R32G32B32_SFLOAT;
-    n.VertexFormat[0].Offset = 0;
-
-    n.VertexFormat[1].Format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    n.VertexFormat[1].Offset = sizeof(float) * 3;
+    SetVertexStreams(n);
 
     n.ShaderInfos.resize(2);
     n.ShaderInfos[0].Stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -136,13 +142,7 @@ static PipelineCreateInfos NewVectorField2DPipeline(ShaderLibrary& ShaderLib, vo
     n.PolygonMode = VK_POLYGON_MODE_LINE;
     n.LineWidth = 2;
 
-    n.VertexSize = sizeof(float) * 7;
-    n.VertexFormat.resize(2);
-    n.VertexFormat[0].Format = VK_FORMAT_R32G32B32_SFLOAT;
-    n.VertexFormat[0].Offset = 0;
-
-    n.VertexFormat[1].Format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    n.VertexFormat[1].Offset = sizeof(float) * 3;
+    SetVertexStreams(n);
 
     n.ShaderInfos.resize(2);
     n.ShaderInfos[0].Stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -168,13 +168,7 @@ static PipelineCreateInfos NewVectorField3DPipeline(ShaderLibrary& ShaderLib, vo
     n.PolygonMode = VK_POLYGON_MODE_LINE;
     n.LineWidth = 2;
 
-    n.VertexSize = sizeof(float) * 7;
-    n.VertexFormat.resize(2);
-    n.VertexFormat[0].Format = VK_FORMAT_R32G32B32_SFLOAT;
-    n.VertexFormat[0].Offset = 0;
-
-    n.VertexFormat[1].Format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    n.VertexFormat[1].Offset = sizeof(float) * 3;
+    SetVertexStreams(n);
 
     n.ShaderInfos.resize(2);
     n.ShaderInfos[0].Stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -200,8 +194,6 @@ static PipelineCreateInfos UnknowPipeline()
     n.PolygonMode = VK_POLYGON_MODE_MAX_ENUM;
     n.LineWidth = 0;
 
-    n.VertexSize = 0;
-
     n.DescriptorListHandle.ffType = ffTypes::FF_TYPE_UNKOWN;
 
     return n;
@@ -0,0 +1,134 @@
+#include "Root.h"
+#include "DeletionQueue.h"
+#include "GlobalEnvironment.h"
+#include "Logger.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+/**
+ * @brief Start a pass if the heap is fragmented enough and one of its blocks fits in the others.
+ */
+static bool StartCompaction(Root& r)
+{
+    HeapCompaction& Compaction = r.Compaction;
+    GeometryHeapStats Heap = r.Heap.GetStats( );
+    Compaction.Stats.Fragmentation = Heap.Fragmentation( );
+    if (Compaction.Active)
+        return true;
+    if (r.Frame < Compaction.NextPass || Heap.Blocks < 2 || Compaction.Stats.Fragmentation < Compaction.Threshold)
+        return false;
+    if (!r.Heap.FindSparsestBlock(Compaction.Block))
+        return false;
+    Compaction.Active = true;
+    Compaction.Stats.Passes++;
+    return true;
+}
+
+static void EndCompaction(Root& r, bool Emptied)
+{
+    HeapCompaction& Compaction = r.Compaction;
+    Compaction.Active = false;
+    Compaction.NextPass = r.Frame + FramesInFlight + 1;
+    if (Emptied)
+        Compaction.Stats.BlocksEmptied++;
+}
+
+/**
+ * @brief Copy a range out of the block being emptied. Draws of the previous frame may still read the old
+ * range, it goes through the deletion queue.
+ *
+ * @return bool - false if the other blocks have no room left for it.
+ */
+static bool MoveRange(Root& r, VkCommandBuffer CmdBuffer, const StreamRange& Range, VkDeviceSize Size,
+                      StreamRange& Moved)
+{
+    HeapRange Target;
+    if (!r.Heap.AllocateElsewhere(Size, Range.Block, Target))
+        return false;
+    VkBufferCopy Region = {Range.Offset, Target.Offset, Size};
+    vkCmdCopyBuffer(CmdBuffer, r.Heap.GetBuffer(Range.Block), r.Heap.GetBuffer(Target.Block), 1, &Region);
+
+    HeapRange Old(Range.Block, Range.Offset, Size);
+    GetDeletionQueue( ).Defer([&r, Old]( ) { r.Heap.Free(Old); });
+    Moved.Block = Target.Block;
+    Moved.Offset = Target.Offset;
+    r.Compaction.Stats.Moves++;
+    return true;
+}
+
+void RecordHeapCompaction(Root& r, VkCommandBuffer CmdBuffer)
+{
+    if (!StartCompaction(r))
+        return;
+    HeapCompaction& Compaction = r.Compaction;
+    VkDeviceSize Moved = 0;
+    bool Emptied = true;
+
+    for (size_t i = 0; i < r.Geometries.size( ) && Compaction.Active; ++i) {
+        ConstructedGeometry& g = r.Geometries[i];
+        // Back ranges hold nothing to keep, the next update allocates them again.
+        for (uint8_t s = 0; s < GEO_STREAM_COUNT; ++s) {
+            if ((g.BackSlots & (1 << s)) == 0 || g.BackStreams[s].Block != Compaction.Block)
+                continue;
+            if (g.FlipStreams != 0)
+                Emptied = false;
+            else
+                ReleaseBackStreams(r, g);
+        }
+        for (uint8_t s = 0; s < GEO_STREAM_COUNT; ++s) {
+            VkDeviceSize Size = g.Geo.streamSize(s);
+            StreamRange Range = g.Geo.Streams[s];
+            if (!g.GpuResident || Size == 0 || Range.Block != Compaction.Block)
+                continue;
+            // Geometries still being copied stay, the block is emptied by a later pass.
+            if (!IsUploaded(r, g) || Moved >= Compaction.SliceSize) {
+                Emptied = false;
+                continue;
+            }
+            StreamRange Target;
+            if (!MoveRange(r, CmdBuffer, Range, Size, Target)) {
+                EndCompaction(r, false);
+                break;
+            }
+            // Generations sharing the stream follow it.
+            for (auto& Other : r.Geometries) {
+                StreamRange& OtherRange = Other.Geo.Streams[s];
+                if (Other.GpuResident && OtherRange.Block == Range.Block && OtherRange.Offset == Range.Offset)
+                    OtherRange = Target;
+            }
+            Moved += Size;
+        }
+        for (auto& Step : g.ColorHistory) {
+            VkDeviceSize Size = g.Geo.streamSize(GEO_STREAM_COLOR);
+            if (Step.Block != Compaction.Block || !Compaction.Active)
+                continue;
+            if (Moved >= Compaction.SliceSize) {
+                Emptied = false;
+                continue;
+            }
+            if (!MoveRange(r, CmdBuffer, Step, Size, Step)) {
+                EndCompaction(r, false);
+                break;
+            }
+            Moved += Size;
+        }
+    }
+    Compaction.Stats.BytesMoved += Moved;
+    if (Compaction.Active && Emptied)
+        EndCompaction(r, Moved != 0);
+
+    if (Moved == 0)
+        return;
+    // This frame draws the moved geometries from their new range.
+    VkMemoryBarrier Barrier = {};
+    Barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    Barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(CmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &Barrier, 0, 0, 0,
+                         0);
+}
+
+}    // namespace Vulkan
+}    // namespace ffGraph
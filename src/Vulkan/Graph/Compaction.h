@@ -0,0 +1,46 @@
+/**
+ * @file Compaction.h
+ * @brief Incremental defragmentation of the geometry heap. Once its free space is scattered enough, the
+ * geometries of its least used block are moved to the free ranges of the other ones, a slice per frame,
+ * until the block is empty and released.
+ */
+#ifndef COMPACTION_H_
+#define COMPACTION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vulkan/vulkan.h>
+
+namespace ffGraph {
+namespace Vulkan {
+
+struct HeapCompactionStats {
+    // @brief See ffGraph::Vulkan::GeometryHeapStats::Fragmentation, measured each frame.
+    float Fragmentation = 0.f;
+    // @brief Passes started, and blocks they emptied, since startup.
+    size_t Passes = 0;
+    size_t BlocksEmptied = 0;
+    size_t Moves = 0;
+    VkDeviceSize BytesMoved = 0;
+};
+
+struct HeapCompaction {
+    static constexpr float DefaultThreshold = 0.5f;
+    static constexpr VkDeviceSize DefaultSliceSize = 4ull * 1024ull * 1024ull;
+
+    // @brief Fragmentation starting a pass.
+    float Threshold = DefaultThreshold;
+    // @brief Bytes moved per frame, at least one geometry is.
+    VkDeviceSize SliceSize = DefaultSliceSize;
+    bool Active = false;
+    // @brief Block being emptied by the current pass.
+    uint32_t Block = 0;
+    // @brief No pass starts before this frame, the ranges moved by the last one are still being freed.
+    uint64_t NextPass = 0;
+    HeapCompactionStats Stats;
+};
+
+}    // namespace Vulkan
+}    // namespace ffGraph
+
+#endif    // COMPACTION_H_
@@ -1,82 +1,365 @@
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "GlobalEnvironment.h"
+#include "Logger.h"
 #include "Root.h"
 
 namespace ffGraph {
 namespace Vulkan {
 
-void BuildRenderBuffer(Root& r)
+void ListRenderedGeometries(Root& r)
 {
-    if (r.RenderBuffer.Handle != VK_NULL_HANDLE) {
-        DestroyBuffer(GetAllocator( ), r.RenderBuffer);
+    r.RenderedGeometries.clear();
+    SyncMeshes(r);
+    for (size_t i = 0; i < r.Geometries.size(); ++i)
+        if (IsUploaded(r, r.Geometries[i]) && IsFieldDrawn(r, r.Geometries[i]))
+            r.RenderedGeometries.push_back(i);
+}
+
+bool IsStreamShared(const Root& r, const ConstructedGeometry& g, uint8_t Stream)
+{
+    const StreamRange& Range = g.Geo.Streams[Stream];
+    for (const auto& Other : r.Geometries) {
+        if (&Other == &g || !Other.GpuResident || Other.Geo.Data.ElementCount == 0)
+            continue;
+        if (Other.Geo.Streams[Stream].Block == Range.Block && Other.Geo.Streams[Stream].Offset == Range.Offset)
+            return true;
     }
-    VkDeviceSize BufferSize = 0;
+    return false;
+}
 
-    for (size_t i = 0; i < r.RenderedGeometries.size(); ++i) {
-        BufferSize += r.Geometries[r.RenderedGeometries[i]].Geo.size();
+/**
+ * @return const ConstructedGeometry * - Geometry of the same plot and mesh in the geometry heap with the same
+ * positions as g, nullptr if there is none.
+ */
+static const ConstructedGeometry *FindSamePositions(const Root& r, const ConstructedGeometry& g)
+{
+    if (g.PositionHash.Empty())
+        return nullptr;
+    for (const auto& Other : r.Geometries) {
+        // Its hash is already the one of the positions it is being updated to.
+        if (&Other == &g || !Other.GpuResident || Other.FlipStreams != 0 || Other.PlotID != g.PlotID ||
+            Other.MeshID != g.MeshID)
+            continue;
+        if (Other.Geo.Data.ElementCount == g.Geo.Data.ElementCount && Other.PositionHash == g.PositionHash)
+            return &Other;
     }
+    return nullptr;
+}
 
+/**
+ * @return const ConstructedGeometry * - Geometry drawn from the geometry heap built from the same arrays as g,
+ * of any plot, nullptr if there is none.
+ */
+static const ConstructedGeometry *FindSameContent(const Root& r, const ConstructedGeometry& g)
+{
+    if (g.ContentHash.Empty())
+        return nullptr;
+    for (const auto& Other : r.Geometries) {
+        if (&Other == &g || Other.FlipStreams != 0 || !IsUploaded(r, Other))
+            continue;
+        if (Other.ContentHash == g.ContentHash && Other.Geo.Data.ElementCount == g.Geo.Data.ElementCount)
+            return &Other;
+    }
+    return nullptr;
+}
 
-    BufferCreateInfo CreateInfo = {};
+/**
+ * @brief Debug check of a content match : where both host copies are at hand they must hold the same
+ * vertices, or the shared ranges draw another content (a hash left behind by an in place update).
+ */
+static void CheckSameContent(const ConstructedGeometry& g, const ConstructedGeometry& Same)
+{
+#ifdef _DEBUG
+    const uint8_t *Vertices = JSON::PeekGeometryData(g);
+    const uint8_t *Shared = JSON::PeekGeometryData(Same);
+    if (Vertices != nullptr && Shared != nullptr && Same.FlipStreams == 0 &&
+        memcmp(Vertices, Shared, g.Geo.Data.ElementCount * g.Geo.Data.ElementSize) != 0)
+        LogError("UploadGeometry", "Geometry %s shares the ranges of %s, which hold other vertices.", g.Name.c_str(),
+                 Same.Name.c_str());
+#else
+    (void)g;
+    (void)Same;
+#endif
+}
 
-    CreateInfo.vkData.SharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    CreateInfo.vkData.Size = BufferSize;
-    CreateInfo.vkData.Usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+bool UploadGeometry(Root& r, ConstructedGeometry& g)
+{
+    g.GpuResident = false;
+    g.UploadID = 0;
+    if (g.Geo.size() == 0) {
+        g.GpuResident = true;
+        return true;
+    }
+    if (g.Geo.Data.ElementSize != sizeof(Vertex)) {
+        LogWarning("UploadGeometry", "Geometry %s doesn't hold vertices.", g.Name.c_str());
+        return false;
+    }
+    // Resent content is drawn from the ranges already there, nothing to copy.
+    if (const ConstructedGeometry *Same = FindSameContent(r, g)) {
+        CheckSameContent(g, *Same);
+        for (uint8_t s = 0; s < GEO_STREAM_COUNT; ++s)
+            g.Geo.Streams[s] = Same->Geo.Streams[s];
+        g.PositionHash = Same->PositionHash;
+        g.UploadID = Same->UploadID;
+        g.GpuResident = true;
+        std::vector<uint8_t>().swap(g.Staged);
+        r.Uploads.Stats.SharedBytes += g.Geo.size();
+        r.Uploads.Stats.ContentHits++;
+        return true;
+    }
+    std::vector<uint8_t> Expanded;
+    const uint8_t *Vertices = JSON::PeekGeometryData(g);
+    if (Vertices == nullptr) {
+        Expanded.resize(g.Geo.size());
+        if (!JSON::ReadGeometryData(g, Expanded.data())) {
+            LogWarning("UploadGeometry", "Geometry %s has no host copy left.", g.Name.c_str());
+            return false;
+        }
+        Vertices = Expanded.data();
+    }
+    const ConstructedGeometry *Same = FindSamePositions(r, g);
 
-    CreateInfo.vmaData.Usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-    CreateInfo.vmaData.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-    r.RenderBuffer = CreateBuffer(GetAllocator( ), CreateInfo);
+    uint64_t UploadID = 0;
+    for (uint8_t s = 0; s < GEO_STREAM_COUNT; ++s) {
+        if (s == GEO_STREAM_POSITION && Same != nullptr) {
+            g.Geo.Streams[s] = Same->Geo.Streams[s];
+            r.Uploads.Stats.SharedBytes += g.Geo.streamSize(s);
+            continue;
+        }
+        HeapRange Range;
+        uint64_t ID = 0;
+        if (!r.Heap.Allocate(g.Geo.streamSize(s), Range)) {
+            LogWarning("UploadGeometry", "No room left for geometry %s.", g.Name.c_str());
+        } else if ((ID = StageUpload(r, Range, Vertices, g.Geo.count(), s)) == 0) {
+            r.Heap.Free(Range);
+        }
+        if (ID == 0) {
+            // The streams staged so far go with their batch, unless shared.
+            for (uint8_t Staged = 0; Staged < s; ++Staged) {
+                HeapRange Orphan(g.Geo.Streams[Staged].Block, g.Geo.Streams[Staged].Offset, g.Geo.streamSize(Staged));
+                if (!IsStreamShared(r, g, Staged))
+                    OrphanUpload(r, UploadID, Orphan);
+            }
+            return false;
+        }
+        UploadID = ID;
+        g.Geo.Streams[s].Block = Range.Block;
+        g.Geo.Streams[s].Offset = Range.Offset;
+    }
+    std::vector<uint8_t>().swap(g.Staged);
+    g.UploadID = UploadID;
+    g.GpuResident = true;
+    return true;
+}
 
-    VkDeviceSize offset = 0;
-    for (size_t i = 0; i < r.RenderedGeometries.size(); ++i) {
-        r.Geometries[r.RenderedGeometries[i]].Geo.BufferOffset = offset;
-        memcpy(((char *)r.RenderBuffer.Infos.pMappedData) + offset,
-                    r.Geometries[r.RenderedGeometries[i]].Geo.Data.Data,
-                    r.Geometries[r.RenderedGeometries[i]].Geo.size());
-        offset += r.Geometries[r.RenderedGeometries[i]].Geo.size();
+void EvictGeometry(Root& r, ConstructedGeometry& g)
+{
+    if (!g.GpuResident)
+        return;
+    ReleaseBackStreams(r, g);
+    ReleaseColorHistory(r, g);
+    for (uint8_t s = 0; s < GEO_STREAM_COUNT && g.Geo.size() != 0; ++s) {
+        if (IsStreamShared(r, g, s))
+            continue;
+        HeapRange Range(g.Geo.Streams[s].Block, g.Geo.Streams[s].Offset, g.Geo.streamSize(s));
+        // A range still being copied to waits for its batch instead of the frames in flight.
+        if (IsUploaded(r, g) || !OrphanUpload(r, g.UploadID, Range))
+            GetDeletionQueue( ).Defer([&r, Range]( ) { r.Heap.Free(Range); });
     }
+    g.GpuResident = false;
 }
 
-void AddToGraph(Root& r, ConstructedGeometry& g, ShaderLibrary& ShaderLib)
+/**
+ * @brief Drop a reference to a pipeline, retiring it when no geometry draws with it anymore. Its slot is
+ * left empty so the PipelineID of the other geometries stay valid.
+ */
+static void ReleasePipeline(Root& r, size_t PipelineID)
 {
+    if (PipelineID >= r.PipelineUsers.size() || r.PipelineUsers[PipelineID] == 0 || --r.PipelineUsers[PipelineID] != 0)
+        return;
+    Pipeline& p = r.Pipelines[PipelineID];
+    Pipeline Retired = p;
+    GetDeletionQueue( ).Defer([Retired]( ) mutable { DestroyPipeline(Retired); });
+    p.Handle = VK_NULL_HANDLE;
+    p.Layout = VK_NULL_HANDLE;
+    p.DescriptorPool = VK_NULL_HANDLE;
+    p.DescriptorLayout = VK_NULL_HANDLE;
+    p.DescriptorSet = VK_NULL_HANDLE;
+}
+
+/**
+ * @brief Remove the geometries matching Predicate. Their host arrays go right away, the GPU never reads
+ * them, while their heap ranges and pipelines go through the deletion queue.
+ */
+template <typename Predicate>
+static size_t RemoveGeometries(Root& r, Predicate Remove)
+{
+    size_t Kept = 0;
+    for (size_t i = 0; i < r.Geometries.size(); ++i) {
+        if (Remove(r.Geometries[i])) {
+            EvictGeometry(r, r.Geometries[i]);
+            ReleasePipeline(r, r.Geometries[i].Geo.Description.PipelineID);
+            continue;
+        }
+        if (Kept != i)
+            r.Geometries[Kept] = std::move(r.Geometries[i]);
+        Kept++;
+    }
+    size_t Removed = r.Geometries.size() - Kept;
+    if (Removed == 0)
+        return 0;
+    r.Geometries.erase(r.Geometries.begin() + Kept, r.Geometries.end());
+    ListRenderedGeometries(r);
+
+    r.PlotOrder.erase(std::remove_if(r.PlotOrder.begin(), r.PlotOrder.end(),
+                                     [&r](uint16_t PlotID) {
+                                         for (const auto& g : r.Geometries)
+                                             if (g.PlotID == PlotID) return false;
+                                         return true;
+                                     }),
+                      r.PlotOrder.end());
     r.Update = true;
+    return Removed;
+}
 
-    r.Geometries.push_back(g);
+/**
+ * @brief Mark a plot as the most recently updated one.
+ */
+static void TouchPlot(Root& r, uint16_t PlotID)
+{
+    auto it = std::find(r.PlotOrder.begin(), r.PlotOrder.end(), PlotID);
+    if (it != r.PlotOrder.end())
+        r.PlotOrder.erase(it);
+    r.PlotOrder.push_back(PlotID);
+}
+
+/**
+ * @brief Remove the least recently updated plots over Root::KeepPlots.
+ */
+static void EvictPlots(Root& r)
+{
+    while (r.KeepPlots != 0 && r.PlotOrder.size() > r.KeepPlots) {
+        uint16_t Oldest = r.PlotOrder.front();
+        LogInfo("EvictPlots", "Keeping %u plots, removing plot %u.", r.KeepPlots, Oldest);
+        if (RemoveGeometries(r, [Oldest](const ConstructedGeometry& g) { return g.PlotID == Oldest; }) == 0)
+            r.PlotOrder.erase(r.PlotOrder.begin());
+    }
+}
+
+void RemoveReplacedGeometries(Root& r)
+{
+    struct Drawn {
+        uint16_t PlotID;
+        uint16_t MeshID;
+        uint32_t Generation;
+    };
+    std::vector<Drawn> Newer;
+    // A geometry updated in place is drawn with its new generation once its copies are done.
+    for (const auto& g : r.Geometries)
+        if (IsUploaded(r, g) && g.FlipStreams == 0)
+            Newer.push_back(Drawn{g.PlotID, g.MeshID, g.Generation});
+    size_t Removed = RemoveGeometries(r, [&Newer](const ConstructedGeometry& Old) {
+        for (const auto& n : Newer)
+            if (n.PlotID == Old.PlotID && n.MeshID == Old.MeshID && n.Generation > Old.Generation)
+                return true;
+        return false;
+    });
+    if (Removed != 0)
+        JSON::ApplyHostResidency(r.Geometries, r.HostMemory);
+}
+
+/**
+ * @brief Append a geometry to the graph, upload it to its own heap range and find (or create) the pipeline
+ * drawing it. The older generations of the same plot and mesh stay drawn until its upload is done, see
+ * ffGraph::Vulkan::RemoveReplacedGeometries, unless they aren't drawn anyway.
+ */
+static void AttachGeometry(Root& r, ConstructedGeometry&& g, ShaderLibrary& ShaderLib)
+{
+    uint16_t PlotID = g.PlotID;
+    uint16_t MeshID = g.MeshID;
+    uint32_t Generation = g.Generation;
+    RemoveGeometries(r, [&r, PlotID, MeshID, Generation](const ConstructedGeometry& Old) {
+        return Old.PlotID == PlotID && Old.MeshID == MeshID && Old.Generation < Generation && !IsUploaded(r, Old);
+    });
+    TouchPlot(r, PlotID);
+    // Content already in the geometry heap is shared rather than written again.
+    if (FindSameContent(r, g) == nullptr && UpdateGeometry(r, g))
+        return;
+
+    r.Geometries.push_back(std::move(g));
+    JSON::ComputeBounds(r.Geometries.back());
+    UploadGeometry(r, r.Geometries.back());
     Geometry *p = &r.Geometries[r.Geometries.size() - 1].Geo;
-    r.RenderedGeometries.push_back(r.Geometries.size() - 1);
     void *PushConstantPTR = (void *)&r.CamUniform;
     size_t PushConstantSize = sizeof(CameraUniform);
 
-    if (!r.Pipelines.empty()) {
-        bool add = true;
-        for (size_t i = 0; i < r.Pipelines.size(); ++i) {
-            if (r.Pipelines[i].CreationData.DescriptorListHandle.ffType == p->Type) {
-                p->Description.PipelineID = i;
-                add = false;
-            }
-        }
-        if (add) {
-            auto tmp = GetPipelineCreateInfos(g.Geo.Type, ShaderLib, PushConstantPTR, PushConstantSize, VK_SHADER_STAGE_VERTEX_BIT);
-            r.Pipelines.resize(r.Pipelines.size() + 1);
-            ConstructPipeline(r.Pipelines[r.Pipelines.size() - 1], tmp);
-            p->Description.PipelineID = r.Pipelines.size() - 1;
+    r.PipelineUsers.resize(r.Pipelines.size(), 0);
+    size_t Free = r.Pipelines.size();
+    for (size_t i = 0; i < r.Pipelines.size(); ++i) {
+        if (r.PipelineUsers[i] == 0) {
+            Free = std::min(Free, i);
+        } else if (r.Pipelines[i].CreationData.DescriptorListHandle.ffType == p->Type) {
+            p->Description.PipelineID = i;
+            r.PipelineUsers[i]++;
+            return;
         }
-    } else {
-        auto tmp = GetPipelineCreateInfos(g.Geo.Type, ShaderLib, PushConstantPTR, PushConstantSize, VK_SHADER_STAGE_VERTEX_BIT);
-        r.Pipelines.resize(1);
-        ConstructPipeline(r.Pipelines[0], tmp);
-        p->Description.PipelineID = 0;
     }
-    vkDeviceWaitIdle(GetLogicalDevice());
-    BuildRenderBuffer(r);
+    auto tmp = GetPipelineCreateInfos(p->Type, ShaderLib, PushConstantPTR, PushConstantSize, VK_SHADER_STAGE_VERTEX_BIT);
+    if (Free == r.Pipelines.size()) {
+        r.Pipelines.resize(r.Pipelines.size() + 1);
+        r.PipelineUsers.push_back(0);
+    }
+    ConstructPipeline(r.Pipelines[Free], tmp);
+    p->Description.PipelineID = Free;
+    r.PipelineUsers[Free] = 1;
+}
+
+void AddToGraph(Root& r, ConstructedGeometry&& g, ShaderLibrary& ShaderLib)
+{
+    r.Update = true;
+    AttachGeometry(r, std::move(g), ShaderLib);
+    EvictPlots(r);
+    RemoveReplacedGeometries(r);
+    ListRenderedGeometries(r);
+    JSON::ApplyHostResidency(r.Geometries, r.HostMemory);
+}
+
+void AddToGraph(Root& r, std::vector<ConstructedGeometry>& Batch, ShaderLibrary& ShaderLib)
+{
+    if (Batch.empty())
+        return;
+    r.Update = true;
+    r.Geometries.reserve(r.Geometries.size() + Batch.size());
+    for (auto& g : Batch)
+        AttachGeometry(r, std::move(g), ShaderLib);
+    Batch.clear();
+    EvictPlots(r);
+    RemoveReplacedGeometries(r);
+    ListRenderedGeometries(r);
+    JSON::ApplyHostResidency(r.Geometries, r.HostMemory);
+}
+
+void RemovePlot(Root& r, uint16_t PlotID)
+{
+    if (RemoveGeometries(r, [PlotID](const ConstructedGeometry& g) { return g.PlotID == PlotID; }) != 0)
+        JSON::ApplyHostResidency(r.Geometries, r.HostMemory);
+}
+
+void AdvanceFrame(Root& r)
+{
+    r.Frame++;
 }
 
 void DestroyGraph(Root& r)
 {
+    DestroyUploads(r);
     for (size_t i = 0; i < r.Pipelines.size(); ++i) {
-        DestroyPipeline(r.Pipelines[i]);
+        if (r.Pipelines[i].Handle != VK_NULL_HANDLE)
+            DestroyPipeline(r.Pipelines[i]);
     }
-    DestroyBuffer(GetAllocator( ), r.RenderBuffer);
+    r.Heap.Destroy( );
 }
 
 // static void MeshTraversal(Mesh m)
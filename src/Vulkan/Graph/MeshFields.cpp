@@ -0,0 +1,72 @@
+#include <algorithm>
+#include "Root.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+static MeshFields *FindMesh(Root& r, uint16_t PlotID, uint16_t MeshID)
+{
+    for (auto& m : r.Meshes)
+        if (m.PlotID == PlotID && m.MeshID == MeshID)
+            return &m;
+    return nullptr;
+}
+
+static const MeshFields *FindMesh(const Root& r, uint16_t PlotID, uint16_t MeshID)
+{
+    for (const auto& m : r.Meshes)
+        if (m.PlotID == PlotID && m.MeshID == MeshID)
+            return &m;
+    return nullptr;
+}
+
+void SyncMeshes(Root& r)
+{
+    for (auto& m : r.Meshes) {
+        m.Fields = 0;
+        m.MeshSize = m.FieldSize = 0;
+    }
+    for (auto& g : r.Geometries) {
+        MeshFields *m = FindMesh(r, g.PlotID, g.MeshID);
+        if (m == nullptr) {
+            r.Meshes.push_back(MeshFields( ));
+            m = &r.Meshes.back( );
+            m->PlotID = g.PlotID;
+            m->MeshID = g.MeshID;
+        }
+        if (g.FieldID == 0) {
+            m->MeshSize += g.Geo.size( );
+        } else {
+            m->Fields = std::max(m->Fields, g.FieldID);
+            m->FieldSize += g.Geo.size( );
+        }
+    }
+    r.Meshes.erase(std::remove_if(r.Meshes.begin( ), r.Meshes.end( ),
+                                  [](const MeshFields& m) { return m.MeshSize == 0 && m.FieldSize == 0; }),
+                   r.Meshes.end( ));
+    // A field selected in a previous message may be gone from the new one.
+    for (auto& m : r.Meshes)
+        if (m.ActiveField > m.Fields)
+            m.ActiveField = 0;
+}
+
+bool IsFieldDrawn(const Root& r, const ConstructedGeometry& g)
+{
+    if (g.FieldID == 0)
+        return true;
+    const MeshFields *m = FindMesh(r, g.PlotID, g.MeshID);
+    return m == nullptr || m->ActiveField == 0 || m->ActiveField == g.FieldID;
+}
+
+void SelectField(Root& r, uint16_t PlotID, uint16_t MeshID, uint16_t FieldID)
+{
+    MeshFields *m = FindMesh(r, PlotID, MeshID);
+    if (m == nullptr || FieldID > m->Fields || m->ActiveField == FieldID)
+        return;
+    m->ActiveField = FieldID;
+    ListRenderedGeometries(r);
+    r.Update = true;
+}
+
+}    // namespace Vulkan
+}    // namespace ffGraph
@@ -0,0 +1,31 @@
+/**
+ * @file MeshFields.h
+ * @brief Field shown on each mesh of the plots. The mesh, its border and every field of IsoArray are separate
+ * geometries with their own vertices, they all stay in the geometry heap and selecting a field only hides
+ * the geometries of the other ones.
+ */
+#ifndef MESH_FIELDS_H_
+#define MESH_FIELDS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ffGraph {
+namespace Vulkan {
+
+struct MeshFields {
+    uint16_t PlotID = 0;
+    uint16_t MeshID = 0;
+    // @brief Fields attached to the mesh, numbered from 1, see ffGraph::ConstructedGeometry::FieldID.
+    uint16_t Fields = 0;
+    // @brief Field drawn, 0 draws all of them.
+    uint16_t ActiveField = 0;
+    // @brief Bytes of the geometries of the mesh and its border, and of those of its fields.
+    size_t MeshSize = 0;
+    size_t FieldSize = 0;
+};
+
+}    // namespace Vulkan
+}    // namespace ffGraph
+
+#endif    // MESH_FIELDS_H_
@@ -44,16 +44,20 @@ bool ConstructPipeline(Pipeline& P, PipelineCreateInfos& CreateInfo)
         ShaderStageCreateInfo[i].pName = "main";
     }
 
-    VkVertexInputBindingDescription inputBindingDescription = {};
-    inputBindingDescription.binding = 0;
-    inputBindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-    inputBindingDescription.stride = CreateInfo.VertexSize;
+    std::vector<VkVertexInputBindingDescription> inputBindingDescriptions;
+
+    inputBindingDescriptions.resize(CreateInfo.BindingStrides.size());
+    for (size_t i = 0; i < CreateInfo.BindingStrides.size(); ++i) {
+        inputBindingDescriptions[i].binding = i;
+        inputBindingDescriptions[i].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        inputBindingDescriptions[i].stride = CreateInfo.BindingStrides[i];
+    }
 
     std::vector<VkVertexInputAttributeDescription> inputAttributeDescriptions;
 
     inputAttributeDescriptions.resize(CreateInfo.VertexFormat.size());
     for (size_t i = 0; i < CreateInfo.VertexFormat.size(); ++i) {
-        inputAttributeDescriptions[i].binding = 0;
+        inputAttributeDescriptions[i].binding = CreateInfo.VertexFormat[i].Binding;
         inputAttributeDescriptions[i].format = CreateInfo.VertexFormat[i].Format;
         inputAttributeDescriptions[i].location = i;
         inputAttributeDescriptions[i].offset = CreateInfo.VertexFormat[i].Offset;
@@ -62,8 +66,8 @@ bool ConstructPipeline(Pipeline& P, PipelineCreateInfos& CreateInfo)
     VkPipelineVertexInputStateCreateInfo VertexInputStateInfo = {};
 
     VertexInputStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    VertexInputStateInfo.vertexBindingDescriptionCount = 1;
-    VertexInputStateInfo.pVertexBindingDescriptions = &inputBindingDescription;
+    VertexInputStateInfo.vertexBindingDescriptionCount = (uint32_t)inputBindingDescriptions.size();
+    VertexInputStateInfo.pVertexBindingDescriptions = inputBindingDescriptions.data();
     VertexInputStateInfo.vertexAttributeDescriptionCount = (uint32_t)inputAttributeDescriptions.size();
     VertexInputStateInfo.pVertexAttributeDescriptions = inputAttributeDescriptions.data();
 
@@ -23,13 +23,15 @@ struct PipelineShaderInfo {
 struct PipelineDataFormat {
     VkFormat Format;
     VkDeviceSize Offset;
+    uint32_t Binding = 0;
 };
 
 struct PipelineCreateInfos {
     PushConstant PushConstantHandle;
     DescriptorHandle DescriptorListHandle;
     std::vector<PipelineShaderInfo> ShaderInfos;
-    VkDeviceSize VertexSize;
+    // @brief Stride of each vertex binding, the attributes of VertexFormat say which one they are read from.
+    std::vector<VkDeviceSize> BindingStrides;
     std::vector<PipelineDataFormat> VertexFormat;
 
     VkPrimitiveTopology Topology;
@@ -49,11 +51,12 @@ struct PipelineCreateInfos {
             ShaderInfos[i].Module = copy.ShaderInfos[i].Module;
         }
 
-        VertexSize = copy.VertexSize;
+        BindingStrides = copy.BindingStrides;
         VertexFormat.resize(copy.VertexFormat.size());
         for (size_t i = 0; i < copy.VertexFormat.size(); ++i) {
             VertexFormat[i].Format = copy.VertexFormat[i].Format;
             VertexFormat[i].Offset = copy.VertexFormat[i].Offset;
+            VertexFormat[i].Binding = copy.VertexFormat[i].Binding;
         }
 
         Topology = copy.Topology;
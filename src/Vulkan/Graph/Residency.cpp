@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <chrono>
+#include "Root.h"
+#include "Compress.h"
+#include "Logger.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+static PlotResidency *FindPlot(GpuResidency& Residency, uint16_t PlotID)
+{
+    for (auto& p : Residency.Plots)
+        if (p.PlotID == PlotID)
+            return &p;
+    return nullptr;
+}
+
+static bool HasJob(const GpuResidency& Residency, uint16_t PlotID)
+{
+    for (const auto& Job : Residency.Jobs)
+        if (Job.PlotID == PlotID)
+            return true;
+    return false;
+}
+
+void SetPlotVisible(Root& r, uint16_t PlotID, bool Visible)
+{
+    PlotResidency *p = FindPlot(r.Residency, PlotID);
+    if (p == nullptr)
+        return;
+    p->Visible = Visible;
+    if (Visible)
+        p->LastViewed = r.Frame;
+    for (auto& g : r.Geometries)
+        if (g.PlotID == PlotID)
+            g.Visible = Visible;
+}
+
+/**
+ * @brief Add the new plots, forget the removed ones and measure them.
+ */
+static void SyncPlots(Root& r)
+{
+    GpuResidency& Residency = r.Residency;
+    for (auto& p : Residency.Plots)
+        p.Size = p.ResidentSize = 0;
+    for (auto& g : r.Geometries) {
+        PlotResidency *p = FindPlot(Residency, g.PlotID);
+        if (p == nullptr) {
+            Residency.Plots.push_back(PlotResidency( ));
+            p = &Residency.Plots.back( );
+            p->PlotID = g.PlotID;
+            p->LastViewed = r.Frame;
+        }
+        g.Visible = p->Visible;
+        p->Size += g.Geo.size( );
+        if (g.GpuResident)
+            p->ResidentSize += g.Geo.size( );
+    }
+    Residency.Plots.erase(std::remove_if(Residency.Plots.begin( ), Residency.Plots.end( ),
+                                         [](const PlotResidency& p) { return p.Size == 0; }),
+                          Residency.Plots.end( ));
+    for (auto& p : Residency.Plots)
+        if (p.Visible)
+            p.LastViewed = r.Frame;
+}
+
+/**
+ * @brief Plots in the order they are given room in the geometry heap : visible ones first, then by last
+ * view, then by last update.
+ */
+static std::vector<PlotResidency *> RankPlots(Root& r)
+{
+    std::vector<PlotResidency *> Ranked;
+    for (auto& p : r.Residency.Plots)
+        Ranked.push_back(&p);
+    auto Updated = [&r](uint16_t PlotID) {
+        auto it = std::find(r.PlotOrder.begin( ), r.PlotOrder.end( ), PlotID);
+        return (size_t)(it - r.PlotOrder.begin( ));
+    };
+    std::stable_sort(Ranked.begin( ), Ranked.end( ), [&Updated](const PlotResidency *a, const PlotResidency *b) {
+        if (a->Visible != b->Visible)
+            return a->Visible;
+        if (a->LastViewed != b->LastViewed)
+            return a->LastViewed > b->LastViewed;
+        return Updated(a->PlotID) > Updated(b->PlotID);
+    });
+    return Ranked;
+}
+
+/**
+ * @brief Decompress, on another thread, the geometries of a plot which left the geometry heap.
+ */
+static void StartJob(Root& r, uint16_t PlotID)
+{
+    ResidencyJob Job;
+    Job.PlotID = PlotID;
+    std::vector<std::vector<uint8_t>> Compressed;
+    std::vector<size_t> Sizes, Strides;
+    for (auto& g : r.Geometries) {
+        if (g.PlotID != PlotID || g.GpuResident || !g.Staged.empty( ) || g.HostState != HOST_STATE_COMPRESSED)
+            continue;
+        Job.Generations.push_back(g.Generation);
+        Job.Sources.push_back(g.Compressed.data( ));
+        // The geometry may be replaced or removed meanwhile, the job works on its own copy.
+        Compressed.push_back(g.Compressed);
+        Sizes.push_back(g.Geo.size( ));
+        Strides.push_back(g.Geo.Data.ElementSize);
+    }
+    if (Job.Sources.empty( ))
+        return;
+    Job.Result = std::async(std::launch::async, [Compressed, Sizes, Strides]( ) {
+        std::vector<std::vector<uint8_t>> Out(Compressed.size( ));
+        for (size_t i = 0; i < Compressed.size( ); ++i) {
+            Out[i].resize(Sizes[i]);
+            if (!Compression::DecompressShuffled(Compressed[i], Out[i].data( ), Sizes[i], Strides[i]))
+                Out[i].clear( );
+        }
+        return Out;
+    });
+    r.Residency.Jobs.push_back(std::move(Job));
+}
+
+/**
+ * @brief Hand the finished decompressions to their geometries, uploaded by the next pass of
+ * ffGraph::Vulkan::UpdateGpuResidency.
+ */
+static void CollectJobs(Root& r)
+{
+    GpuResidency& Residency = r.Residency;
+    size_t Kept = 0;
+    for (size_t j = 0; j < Residency.Jobs.size( ); ++j) {
+        ResidencyJob& Job = Residency.Jobs[j];
+        if (Job.Result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (Kept != j)
+                Residency.Jobs[Kept] = std::move(Job);
+            Kept++;
+            continue;
+        }
+        std::vector<std::vector<uint8_t>> Data = Job.Result.get( );
+        for (auto& g : r.Geometries) {
+            if (g.PlotID != Job.PlotID || g.GpuResident)
+                continue;
+            for (size_t i = 0; i < Job.Sources.size( ); ++i) {
+                if (Job.Sources[i] != g.Compressed.data( ) || Job.Generations[i] != g.Generation)
+                    continue;
+                if (Data[i].size( ) != g.Geo.size( ))
+                    LogWarning("UpdateGpuResidency", "Compressed copy of geometry %s is corrupted.", g.Name.c_str( ));
+                else
+                    g.Staged = std::move(Data[i]);
+                break;
+            }
+        }
+    }
+    Residency.Jobs.erase(Residency.Jobs.begin( ) + Kept, Residency.Jobs.end( ));
+}
+
+void UpdateGpuResidency(Root& r)
+{
+    GpuResidency& Residency = r.Residency;
+    bool Changed = false;
+    CollectJobs(r);
+    CollectReadBacks(r);
+    SyncPlots(r);
+
+    // The most recently viewed visible plot is always given room, even when it alone exceeds the budget.
+    std::vector<PlotResidency *> Ranked = RankPlots(r);
+    size_t Used = 0;
+    for (size_t i = 0; i < Ranked.size( ); ++i) {
+        PlotResidency& p = *Ranked[i];
+        bool Wanted = Residency.Budget == 0 || Used + p.Size <= Residency.Budget || (i == 0 && p.Visible);
+        bool OverBudget = p.Visible && !Wanted;
+        if (OverBudget && !p.OverBudget)
+            LogWarning("UpdateGpuResidency", "Plot %u doesn't fit in the %.1f MB VRAM budget.", p.PlotID,
+                       Residency.Budget / (1024. * 1024.));
+        p.OverBudget = OverBudget;
+        if (Wanted)
+            Used += p.Size;
+
+        bool NeedsJob = false;
+        for (auto& g : r.Geometries) {
+            if (g.PlotID != p.PlotID || g.GpuResident == Wanted)
+                continue;
+            if (Wanted) {
+                bool HostCopy = !g.Staged.empty( ) || (g.HostState == HOST_STATE_RESIDENT && g.Geo.Data.Data != nullptr);
+                if (!HostCopy) {
+                    NeedsJob = true;
+                } else if (UploadGeometry(r, g)) {
+                    Residency.Stats.Uploads++;
+                    Changed = true;
+                }
+                continue;
+            }
+            // A geometry still being copied to the geometry heap leaves it once drawn.
+            if (!IsUploaded(r, g) || g.FlipStreams != 0)
+                continue;
+            // Without host copy, the geometry is copied back from VRAM over the next frames and leaves once
+            // that copy is done.
+            std::vector<uint8_t> GpuCopy;
+            if (g.HostState == HOST_STATE_RELEASED) {
+                uint8_t State = PollReadBack(r, g, GpuCopy);
+                if (State == READ_BACK_NONE)
+                    StartReadBack(r, g);
+                if (State != READ_BACK_DONE)
+                    continue;
+            }
+            if (!JSON::KeepCompressedCopy(g, GpuCopy.empty( ) ? nullptr : GpuCopy.data( ))) {
+                LogWarning("UpdateGpuResidency", "Geometry %s has no copy to keep, it stays in VRAM.", g.Name.c_str( ));
+                continue;
+            }
+            EvictGeometry(r, g);
+            Residency.Stats.Evictions++;
+            Changed = true;
+        }
+        if (NeedsJob && !HasJob(Residency, p.PlotID))
+            StartJob(r, p.PlotID);
+    }
+
+    if (Changed) {
+        r.Update = true;
+        ListRenderedGeometries(r);
+        JSON::ApplyHostResidency(r.Geometries, r.HostMemory);
+    }
+    Residency.Stats.Resident = Residency.Stats.Evicted = 0;
+    for (auto& g : r.Geometries) {
+        if (g.GpuResident)
+            Residency.Stats.Resident += g.Geo.size( );
+        else
+            Residency.Stats.Evicted += g.Geo.size( );
+    }
+    Residency.Stats.PendingJobs = Residency.Jobs.size( );
+}
+
+}    // namespace Vulkan
+}    // namespace ffGraph
@@ -0,0 +1,60 @@
+/**
+ * @file Residency.h
+ * @brief Which plots live in the geometry heap. Hidden and least recently viewed plots leave it first when
+ * the VRAM budget is exceeded, keeping a compressed host copy they are decompressed back from.
+ */
+#ifndef RESIDENCY_H_
+#define RESIDENCY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+namespace ffGraph {
+namespace Vulkan {
+
+struct PlotResidency {
+    uint16_t PlotID = 0;
+    bool Visible = true;
+    // @brief Last frame the plot was visible.
+    uint64_t LastViewed = 0;
+    // @brief Bytes of its geometries, and how many of them are in the geometry heap.
+    size_t Size = 0;
+    size_t ResidentSize = 0;
+    // @brief Visible but left out of the geometry heap by the budget.
+    bool OverBudget = false;
+};
+
+/**
+ * @brief Decompression of the geometries of a plot going back to the geometry heap, run on another thread.
+ */
+struct ResidencyJob {
+    uint16_t PlotID = 0;
+    // @brief Geometries being decompressed, identified by their generation and compressed buffer.
+    std::vector<uint32_t> Generations;
+    std::vector<const uint8_t *> Sources;
+    std::future<std::vector<std::vector<uint8_t>>> Result;
+};
+
+struct GpuResidencyStats {
+    size_t Resident = 0;
+    size_t Evicted = 0;
+    // @brief Geometries moved out of and back to the geometry heap since startup.
+    size_t Evictions = 0;
+    size_t Uploads = 0;
+    size_t PendingJobs = 0;
+};
+
+struct GpuResidency {
+    // @brief Bytes of geometry allowed in the geometry heap, 0 means no limit.
+    size_t Budget = 0;
+    std::vector<PlotResidency> Plots;
+    std::vector<ResidencyJob> Jobs;
+    GpuResidencyStats Stats;
+};
+
+}    // namespace Vulkan
+}    // namespace ffGraph
+
+#endif    // RESIDENCY_H_
@@ -6,27 +6,222 @@
 #include <glm/mat4x4.hpp>
 #include "Plot.h"
 #include "Pipeline.h"
+#include "Compaction.h"
 #include "Geometry.h"
+#include "HostResidency.h"
+#include "Residency.h"
+#include "TimeSeries.h"
+#include "MeshFields.h"
+#include "Upload.h"
 #include "Resource/Buffer/Buffer.h"
+#include "Resource/Buffer/GeometryHeap.h"
 #include "Resource/Camera/CameraController.h"
 
 namespace ffGraph {
 namespace Vulkan {
+
 struct Root {
     glm::mat4 Transform;
     bool Update = true;
 
     bool UpdateExecutionData = false;
     std::vector<Pipeline> Pipelines;
+    // @brief Number of geometries drawn by each pipeline, a pipeline is retired when it reaches 0.
+    std::vector<uint32_t> PipelineUsers;
     // std::vector<Plot> Plots;
     std::vector<ConstructedGeometry> Geometries;
     std::vector<size_t> RenderedGeometries;
-    Buffer RenderBuffer;
+    // @brief Vertex storage of the geometries in VRAM, each one has its own range.
+    GeometryHeap Heap;
+    HeapCompaction Compaction;
+    UploadQueue Uploads;
+    // @brief Number of frames rendered, see ffGraph::Vulkan::AdvanceFrame.
+    uint64_t Frame = 0;
+    // @brief Plots from the least to the most recently updated.
+    std::vector<uint16_t> PlotOrder;
+    // @brief Number of plots kept, the least recently updated ones are removed first. 0 keeps them all.
+    uint32_t KeepPlots = 0;
+    JSON::HostMemoryStats HostMemory;
+    GpuResidency Residency;
+    TimeSeries Series;
+    std::vector<MeshFields> Meshes;
     CameraController Cam;
     CameraUniform CamUniform;
 };
 
-void AddToGraph(Root& r, ConstructedGeometry& g, ShaderLibrary& ShaderLib);
+/**
+ * @brief Take ownership of a geometry and upload it. It replaces the geometries of the same plot and mesh
+ * built from an older message (lower ffGraph::ConstructedGeometry::Generation).
+ */
+void AddToGraph(Root& r, ConstructedGeometry&& g, ShaderLibrary& ShaderLib);
+/**
+ * @brief Take ownership of a batch of geometries, moved out of Batch, and upload each one to its own range
+ * of the geometry heap.
+ */
+void AddToGraph(Root& r, std::vector<ConstructedGeometry>& Batch, ShaderLibrary& ShaderLib);
+/**
+ * @brief Remove every geometry of a plot. The arenas holding their data are released with them, their
+ * pipelines and buffer once the GPU is done with them.
+ */
+void RemovePlot(Root& r, uint16_t PlotID);
+/**
+ * @brief Show or hide a plot. Hidden plots are the first ones to leave the geometry heap, see
+ * ffGraph::Vulkan::UpdateGpuResidency.
+ */
+void SetPlotVisible(Root& r, uint16_t PlotID, bool Visible);
+/**
+ * @brief Called once per frame : fit the most relevant plots in GpuResidency::Budget. Plots leaving the geometry
+ * heap keep a compressed host copy, plots coming back are decompressed on another thread and uploaded
+ * once ready.
+ */
+void UpdateGpuResidency(Root& r);
+/**
+ * @brief Rebuild Root::RenderedGeometries from the geometries in the geometry heap whose upload is done, and
+ * whose field is drawn.
+ */
+void ListRenderedGeometries(Root& r);
+/**
+ * @brief Rebuild Root::Meshes from the geometries, keeping the field selected on each mesh.
+ */
+void SyncMeshes(Root& r);
+/**
+ * @return bool - Whether g is the mesh or border of its mesh, or the field selected on it.
+ */
+bool IsFieldDrawn(const Root& r, const ConstructedGeometry& g);
+/**
+ * @brief Draw a single field of a mesh, 0 draws all of them. Every field stays in the geometry heap, the
+ * geometries of the other fields are skipped by the draws.
+ */
+void SelectField(Root& r, uint16_t PlotID, uint16_t MeshID, uint16_t FieldID);
+/**
+ * @brief Remove the geometries replaced by a newer generation of the same plot and mesh which is drawn.
+ */
+void RemoveReplacedGeometries(Root& r);
+/**
+ * @brief Give each stream of a geometry its range of Root::Heap and stage it, from its host copy, for the
+ * next ffGraph::Vulkan::SubmitUploads. Positions equal to those of a resident generation of the same plot
+ * and mesh share their range instead, and a geometry built from the same content as a drawn one shares all
+ * of its streams.
+ *
+ * @return bool - false if there was no room or no host copy, the geometry is left out of VRAM.
+ */
+bool UploadGeometry(Root& r, ConstructedGeometry& g);
+/**
+ * @brief Write a new generation of a drawn geometry, with the same vertex count, to the back range of its
+ * streams while the front ones are drawn. They are swapped by ffGraph::Vulkan::FlipGeometries once the copies
+ * are done, and kept for the next update. The new host copy is moved in right away.
+ *
+ * @return bool - false if no geometry can be updated in place, New is then added as a new geometry.
+ */
+bool UpdateGeometry(Root& r, ConstructedGeometry& New);
+/**
+ * @brief Called when upload batches are done : swap the back and front streams written by them.
+ */
+void FlipGeometries(Root& r);
+/**
+ * @brief Free the back ranges of a geometry, with the batch writing them if any.
+ */
+void ReleaseBackStreams(Root& r, ConstructedGeometry& g);
+/**
+ * @brief Add the colour stream a geometry was just drawn with to its time series, dropping the oldest steps
+ * over TimeSeries::Steps and TimeSeries::Budget.
+ *
+ * @return bool - false if no history is kept, the range is then left to the caller.
+ */
+bool KeepColorStep(Root& r, ConstructedGeometry& g, const StreamRange& Previous);
+/**
+ * @brief Free the time series of a geometry leaving the geometry heap, or whose positions just changed.
+ */
+void ReleaseColorHistory(Root& r, ConstructedGeometry& g);
+/**
+ * @brief Called once per frame : move TimeSeries::Position by the time elapsed when playing.
+ */
+void UpdatePlayback(Root& r, double Seconds);
+/**
+ * @brief Colour streams a geometry is drawn with at TimeSeries::Position.
+ *
+ * @return float - Weight of Next, the older step, in the drawn colours.
+ */
+float SelectColorSteps(const Root& r, const ConstructedGeometry& g, StreamRange& Color, StreamRange& Next);
+/**
+ * @return bool - Whether another geometry in the geometry heap has its stream in the same range, which then
+ * isn't freed with g.
+ */
+bool IsStreamShared(const Root& r, const ConstructedGeometry& g, uint8_t Stream);
+/**
+ * @brief Take a geometry out of VRAM, its range is freed by the deletion queue (or with its upload batch)
+ * once the GPU is done with it.
+ */
+void EvictGeometry(Root& r, ConstructedGeometry& g);
+/**
+ * @return bool - Whether the geometry is in the geometry heap and its copy there is done.
+ */
+bool IsUploaded(const Root& r, const ConstructedGeometry& g);
+/**
+ * @brief Write a stream of a geometry to the staging ring, copied to Range by the next submission. A stream
+ * larger than the ring gets a staging buffer of its own.
+ *
+ * @param Vertices [in] - Host copy of the geometry, Count interleaved ffGraph::Vertex, see JSON::ReadGeometryData.
+ * @param Stream [in] - Attribute written, see ffGraph::GeometryStream.
+ * @return uint64_t - ID of the batch doing the copy, 0 if the staging buffer couldn't be created.
+ */
+uint64_t StageUpload(Root& r, const HeapRange& Range, const uint8_t *Vertices, size_t Count, uint8_t Stream);
+/**
+ * @brief Free Range once the batch copying to it is done.
+ *
+ * @return bool - false if the batch is already done, the range then goes through the deletion queue.
+ */
+bool OrphanUpload(Root& r, uint64_t UploadID, const HeapRange& Range);
+/**
+ * @brief Called once per frame : submit the staged copies on the transfer queue.
+ */
+void SubmitUploads(Root& r);
+/**
+ * @brief Called once per frame : swap in the geometries whose copy is done, in place of the generations
+ * they replace.
+ */
+void CompleteUploads(Root& r);
+/**
+ * @brief Acquire, at the start of the frame command buffer, the ranges copied by the batches done since
+ * the last frame, which waits on their semaphores.
+ */
+void RecordUploadAcquire(Root& r, VkCommandBuffer CmdBuffer, std::vector<VkSemaphore>& WaitSemaphores,
+                         std::vector<VkPipelineStageFlags>& WaitStages);
+/**
+ * @brief Called once the frame command buffer was submitted, or failed to be : the batches it acquired are
+ * destroyed once the frame is over, or go back to UploadQueue::Acquiring when the submission failed.
+ */
+void FinishUploadAcquire(Root& r, bool Submitted);
+/**
+ * @brief Called once per frame, before the render pass : when the geometry heap is fragmented past
+ * HeapCompaction::Threshold, move a slice of the geometries of its least used block to the other ones and
+ * point their draws to the new ranges. The old ranges go through the deletion queue.
+ */
+void RecordHeapCompaction(Root& r, VkCommandBuffer CmdBuffer);
+/**
+ * @brief Submit the copy of a geometry back from the geometry heap, without waiting for it. Only needed for
+ * geometries without host copy.
+ *
+ * @return bool - false if the copy couldn't be submitted.
+ */
+bool StartReadBack(Root& r, ConstructedGeometry& g);
+/**
+ * @brief Check on the copy started by ffGraph::Vulkan::StartReadBack. Once its fence is signaled the streams
+ * are interleaved back to Data and the copy is over.
+ *
+ * @return uint8_t - READ_BACK_NONE if no copy of the current content of g was started, see ReadBackState.
+ */
+uint8_t PollReadBack(Root& r, ConstructedGeometry& g, std::vector<uint8_t>& Data);
+/**
+ * @brief Called once per frame : destroy the copies back whose geometry is gone, once they are done.
+ */
+void CollectReadBacks(Root& r);
+void DestroyUploadBatch(Root& r, UploadBatch& Batch);
+void DestroyUploads(Root& r);
+/**
+ * @brief Count a rendered frame.
+ */
+void AdvanceFrame(Root& r);
 // void GraphTraversal(Root r);
 // void ConstructCurrentGraphPipelines(Root& r, VkShaderModule Shaders[2]);
 void DestroyGraph(Root& r);
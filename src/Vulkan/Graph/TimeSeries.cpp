@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cmath>
+#include "GlobalEnvironment.h"
+#include "Root.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+static void FreeHistoryRange(Root& r, const ConstructedGeometry& g, const StreamRange& Range)
+{
+    HeapRange Freed(Range.Block, Range.Offset, g.Geo.streamSize(GEO_STREAM_COLOR));
+    GetDeletionQueue( ).Defer([&r, Freed]( ) { r.Heap.Free(Freed); });
+}
+
+/**
+ * @brief Drop the oldest steps over TimeSeries::Steps, then those of the longest histories until the
+ * history fits in TimeSeries::Budget.
+ */
+static void TrimTimeSeries(Root& r)
+{
+    TimeSeries& Series = r.Series;
+    size_t Bytes = 0;
+    for (auto& g : r.Geometries) {
+        while (!g.ColorHistory.empty( ) && g.ColorHistory.size( ) + 1 > Series.Steps) {
+            FreeHistoryRange(r, g, g.ColorHistory.back( ));
+            g.ColorHistory.pop_back( );
+        }
+        Bytes += g.ColorHistory.size( ) * g.Geo.streamSize(GEO_STREAM_COLOR);
+    }
+    while (Bytes > Series.Budget) {
+        ConstructedGeometry *Longest = nullptr;
+        for (auto& g : r.Geometries)
+            if (Longest == nullptr || g.ColorHistory.size( ) > Longest->ColorHistory.size( ))
+                Longest = &g;
+        if (Longest == nullptr || Longest->ColorHistory.empty( ))
+            break;
+        FreeHistoryRange(r, *Longest, Longest->ColorHistory.back( ));
+        Bytes -= Longest->Geo.streamSize(GEO_STREAM_COLOR);
+        Longest->ColorHistory.pop_back( );
+    }
+
+}
+
+static void MeasureTimeSeries(Root& r)
+{
+    size_t Depth = 0;
+    size_t Bytes = 0;
+    for (const auto& g : r.Geometries) {
+        Depth = std::max(Depth, g.ColorHistory.size( ));
+        Bytes += g.ColorHistory.size( ) * g.Geo.streamSize(GEO_STREAM_COLOR);
+    }
+    r.Series.Stats.Depth = (uint32_t)Depth + 1;
+    r.Series.Stats.Bytes = Bytes;
+}
+
+bool KeepColorStep(Root& r, ConstructedGeometry& g, const StreamRange& Previous)
+{
+    if (r.Series.Steps <= 1)
+        return false;
+    g.ColorHistory.push_front(Previous);
+    TrimTimeSeries(r);
+    MeasureTimeSeries(r);
+    return true;
+}
+
+void ReleaseColorHistory(Root& r, ConstructedGeometry& g)
+{
+    for (const auto& Range : g.ColorHistory)
+        FreeHistoryRange(r, g, Range);
+    g.ColorHistory.clear( );
+}
+
+void UpdatePlayback(Root& r, double Seconds)
+{
+    TimeSeries& Series = r.Series;
+    MeasureTimeSeries(r);
+    float Last = (float)(Series.Stats.Depth - 1);
+    if (Series.Live) {
+        Series.Position = 0.f;
+        Series.Playing = false;
+        return;
+    }
+    if (Series.Playing) {
+        // Forward in time is towards the latest step, playback starts over from the oldest one.
+        Series.Position -= Series.Rate * (float)Seconds;
+        if (Series.Position < 0.f)
+            Series.Position = Last;
+    }
+    Series.Position = std::max(0.f, std::min(Series.Position, Last));
+}
+
+static const StreamRange& ColorStep(const ConstructedGeometry& g, size_t Step)
+{
+    if (Step == 0 || g.ColorHistory.empty( ))
+        return g.Geo.Streams[GEO_STREAM_COLOR];
+    return g.ColorHistory[std::min(Step, g.ColorHistory.size( )) - 1];
+}
+
+float SelectColorSteps(const Root& r, const ConstructedGeometry& g, StreamRange& Color, StreamRange& Next)
+{
+    const TimeSeries& Series = r.Series;
+    size_t Step = (size_t)std::floor(Series.Position);
+    Color = ColorStep(g, Step);
+    Next = Series.Interpolate ? ColorStep(g, Step + 1) : Color;
+    return Series.Interpolate ? Series.Position - (float)Step : 0.f;
+}
+
+}    // namespace Vulkan
+}    // namespace ffGraph
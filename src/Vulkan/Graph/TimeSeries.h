@@ -0,0 +1,46 @@
+/**
+ * @file TimeSeries.h
+ * @brief Colour streams of the last time steps of the geometries updated in place, kept in the geometry
+ * heap so they can be played back and scrubbed through without FreeFEM sending them again. Only steps
+ * drawn on the current positions are kept, an update moving the positions drops the history.
+ */
+#ifndef TIME_SERIES_H_
+#define TIME_SERIES_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ffGraph {
+namespace Vulkan {
+
+struct TimeSeriesStats {
+    // @brief Steps which can be played back, the current one included.
+    uint32_t Depth = 1;
+    size_t Bytes = 0;
+};
+
+struct TimeSeries {
+    static constexpr uint32_t DefaultSteps = 32;
+    static constexpr size_t DefaultBudget = 128ull * 1024ull * 1024ull;
+
+    // @brief Steps kept per geometry, the current one included. 1 keeps no history.
+    uint32_t Steps = DefaultSteps;
+    // @brief Bytes of previous colour streams kept in the geometry heap, the oldest steps go first.
+    size_t Budget = DefaultBudget;
+
+    // @brief Draw the latest step, the playback controls take over once used.
+    bool Live = true;
+    bool Playing = false;
+    // @brief Steps played per second.
+    float Rate = 10.f;
+    // @brief Step drawn, counted back from the latest one. The fraction blends it with the previous step.
+    float Position = 0.f;
+    // @brief Blend the colours of neighbouring steps in the vertex shader, instead of switching.
+    bool Interpolate = true;
+    TimeSeriesStats Stats;
+};
+
+}    // namespace Vulkan
+}    // namespace ffGraph
+
+#endif    // TIME_SERIES_H_
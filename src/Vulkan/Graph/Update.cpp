@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <utility>
+#include "GlobalEnvironment.h"
+#include "Logger.h"
+#include "Root.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+/**
+ * @return ConstructedGeometry * - Drawn geometry New can be written over, nullptr if there is none.
+ */
+static ConstructedGeometry *FindUpdatedGeometry(Root& r, const ConstructedGeometry& New)
+{
+    for (auto& g : r.Geometries) {
+        if (g.PlotID != New.PlotID || g.MeshID != New.MeshID || g.FieldID != New.FieldID || g.Generation >= New.Generation ||
+            g.Geo.Type != New.Geo.Type)
+            continue;
+        if (g.Geo.Data.ElementCount != New.Geo.Data.ElementCount || g.Geo.Data.ElementSize != New.Geo.Data.ElementSize)
+            continue;
+        // The back ranges are still written, or still read by the frames drawn before the last swap.
+        if (!IsUploaded(r, g) || g.FlipStreams != 0 || (g.BackSlots != 0 && r.Frame < g.FlipFrame + FramesInFlight))
+            continue;
+        return &g;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Free the back range of a stream, once the batch writing it is done if it is still being written.
+ */
+static void ReleaseBackStream(Root& r, ConstructedGeometry& g, uint8_t Stream)
+{
+    HeapRange Range(g.BackStreams[Stream].Block, g.BackStreams[Stream].Offset, g.Geo.streamSize(Stream));
+    bool Written = (g.FlipStreams & (1 << Stream)) != 0 && g.FlipID > r.Uploads.Completed;
+    if (!Written || !OrphanUpload(r, g.FlipID, Range))
+        GetDeletionQueue( ).Defer([&r, Range]( ) { r.Heap.Free(Range); });
+    g.BackSlots &= ~(1 << Stream);
+    g.FlipStreams &= ~(1 << Stream);
+}
+
+void ReleaseBackStreams(Root& r, ConstructedGeometry& g)
+{
+    for (uint8_t s = 0; s < GEO_STREAM_COUNT; ++s)
+        if ((g.BackSlots & (1 << s)) != 0)
+            ReleaseBackStream(r, g, s);
+    g.FlipStreams = 0;
+}
+
+bool UpdateGeometry(Root& r, ConstructedGeometry& New)
+{
+    if (New.Geo.size( ) == 0 || New.Geo.Data.ElementSize != sizeof(Vertex))
+        return false;
+    ConstructedGeometry *g = FindUpdatedGeometry(r, New);
+    if (g == nullptr)
+        return false;
+    // The streams are gathered straight from the host copy, only a compressed one is expanded first.
+    std::vector<uint8_t> Expanded;
+    const uint8_t *Vertices = JSON::PeekGeometryData(New);
+    if (Vertices == nullptr) {
+        Expanded.resize(New.Geo.size( ));
+        if (!JSON::ReadGeometryData(New, Expanded.data( )))
+            return false;
+        Vertices = Expanded.data( );
+    }
+
+    bool Staged = true;
+    g->FlipStreams = 0;
+    for (uint8_t s = 0; s < GEO_STREAM_COUNT && Staged; ++s) {
+        // The positions were hashed on the import thread, an empty hash never matches.
+        if (s == GEO_STREAM_POSITION && !New.PositionHash.Empty( ) && New.PositionHash == g->PositionHash)
+            continue;
+        // The back range of the last update is reused, the size didn't change.
+        if ((g->BackSlots & (1 << s)) == 0) {
+            HeapRange Range;
+            if (!r.Heap.Allocate(g->Geo.streamSize(s), Range)) {
+                Staged = false;
+                break;
+            }
+            g->BackStreams[s].Block = Range.Block;
+            g->BackStreams[s].Offset = Range.Offset;
+            g->BackSlots |= 1 << s;
+        }
+        HeapRange Target(g->BackStreams[s].Block, g->BackStreams[s].Offset, g->Geo.streamSize(s));
+        uint64_t ID = StageUpload(r, Target, Vertices, New.Geo.count( ), s);
+        if (ID == 0) {
+            Staged = false;
+            break;
+        }
+        g->FlipStreams |= 1 << s;
+        g->FlipID = ID;
+    }
+    if (!Staged) {
+        // The streams written so far go with their back range, the geometry is replaced instead.
+        ReleaseBackStreams(r, *g);
+        return false;
+    }
+    // The drawn streams become the new content, a resend of the old arrays mustn't be matched to them.
+    g->PositionHash = New.PositionHash;
+    g->ContentHash = New.ContentHash;
+
+    // The host copy is the new one right away, the drawn ranges follow once the copies are done.
+    JSON::ComputeBounds(New);
+    g->Generation = New.Generation;
+    g->Name = std::move(New.Name);
+    g->Geo.Data = New.Geo.Data;
+    g->Arena = std::move(New.Arena);
+    g->HostState = New.HostState;
+    g->Bounds = New.Bounds;
+    g->Compressed = std::move(New.Compressed);
+    std::vector<uint8_t>( ).swap(g->Staged);
+    r.Uploads.Stats.InPlaceUpdates++;
+    return true;
+}
+
+void FlipGeometries(Root& r)
+{
+    bool NewStep = false;
+    for (auto& g : r.Geometries) {
+        if (g.FlipStreams == 0 || g.FlipID > r.Uploads.Completed)
+            continue;
+        // Iso field positions follow the values : older colours don't match the new positions any more.
+        bool Moved = (g.FlipStreams & (1 << GEO_STREAM_POSITION)) != 0;
+        if (Moved)
+            ReleaseColorHistory(r, g);
+        for (uint8_t s = 0; s < GEO_STREAM_COUNT; ++s) {
+            if ((g.FlipStreams & (1 << s)) == 0)
+                continue;
+            // A front range shared with another generation stays theirs, the next update gets a new one.
+            bool Shared = IsStreamShared(r, g, s);
+            std::swap(g.Geo.Streams[s], g.BackStreams[s]);
+            // Or it becomes the previous step of the time series, the next update gets a new one.
+            bool Kept = !Shared && !Moved && s == GEO_STREAM_COLOR && KeepColorStep(r, g, g.BackStreams[s]);
+            if (Shared || Kept)
+                g.BackSlots &= ~(1 << s);
+            NewStep |= Kept;
+        }
+        g.FlipStreams = 0;
+        g.FlipFrame = r.Frame;
+    }
+    // Scrubbing through the time series, the same step stays on screen.
+    if (NewStep && !r.Series.Live)
+        r.Series.Position = std::min(r.Series.Position + 1.f, (float)(r.Series.Stats.Depth - 1));
+}
+
+}    // namespace Vulkan
+}    // namespace ffGraph
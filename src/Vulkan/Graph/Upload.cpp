@@ -0,0 +1,517 @@
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include "CopyCounter.h"
+#include "GlobalEnvironment.h"
+#include "Logger.h"
+#include "Root.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+/**
+ * @brief Without a dedicated transfer family the copies run on the graphic one, and the semaphore alone
+ * orders them with the draws.
+ */
+static bool OwnershipTransfer( )
+{
+    return GetTransferQueueIndex( ) != GetGraphicQueueIndex( );
+}
+
+static VkBufferMemoryBarrier OwnershipBarrier(const Root& r, const HeapRange& Range, VkAccessFlags SrcAccess,
+                                              VkAccessFlags DstAccess)
+{
+    VkBufferMemoryBarrier Barrier = {};
+    Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    Barrier.srcAccessMask = SrcAccess;
+    Barrier.dstAccessMask = DstAccess;
+    Barrier.srcQueueFamilyIndex = GetTransferQueueIndex( );
+    Barrier.dstQueueFamilyIndex = GetGraphicQueueIndex( );
+    Barrier.buffer = r.Heap.GetBuffer(Range.Block);
+    Barrier.offset = Range.Offset;
+    Barrier.size = Range.Size;
+    return Barrier;
+}
+
+static void DestroyTransferObjects(UploadBatch& Batch)
+{
+    VkDevice Device = GetLogicalDevice( );
+    if (Batch.CmdBuffer != VK_NULL_HANDLE)
+        vkFreeCommandBuffers(Device, GetTransferCommandPool( ), 1, &Batch.CmdBuffer);
+    vkDestroyFence(Device, Batch.Fence, 0);
+    vkDestroySemaphore(Device, Batch.Semaphore, 0);
+    Batch.CmdBuffer = VK_NULL_HANDLE;
+    Batch.Fence = VK_NULL_HANDLE;
+    Batch.Semaphore = VK_NULL_HANDLE;
+}
+
+static bool CreateTransferObjects(UploadBatch& Batch)
+{
+    VkDevice Device = GetLogicalDevice( );
+    VkCommandBufferAllocateInfo AllocInfo = {};
+    AllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    AllocInfo.commandPool = GetTransferCommandPool( );
+    AllocInfo.commandBufferCount = 1;
+
+    VkFenceCreateInfo FenceInfo = {};
+    FenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    VkSemaphoreCreateInfo SemaphoreInfo = {};
+    SemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    if (vkAllocateCommandBuffers(Device, &AllocInfo, &Batch.CmdBuffer) == VK_SUCCESS &&
+        vkCreateFence(Device, &FenceInfo, 0, &Batch.Fence) == VK_SUCCESS &&
+        vkCreateSemaphore(Device, &SemaphoreInfo, 0, &Batch.Semaphore) == VK_SUCCESS)
+        return true;
+    DestroyTransferObjects(Batch);
+    return false;
+}
+
+static void DestroyStaging(UploadBatch& Batch)
+{
+    for (auto& b : Batch.Staging)
+        DestroyBuffer(GetAllocator( ), b);
+    Batch.Staging.clear( );
+}
+
+bool IsUploaded(const Root& r, const ConstructedGeometry& g)
+{
+    return g.GpuResident && g.UploadID <= r.Uploads.Completed;
+}
+
+/**
+ * @brief Find Size bytes in the staging ring for the batch being recorded. When it is full, the copies
+ * recorded so far are submitted and the oldest batches waited for until enough space is given back.
+ */
+static bool AllocateStaging(Root& r, VkDeviceSize Size, VkDeviceSize& Offset)
+{
+    UploadQueue& Uploads = r.Uploads;
+    if (Uploads.Ring.Allocate(Size, Uploads.Recording.ID, Offset))
+        return true;
+
+    auto Start = std::chrono::steady_clock::now( );
+    SubmitUploads(r);
+    bool Allocated = false;
+    bool Waited = false;
+    // The batches stay in UploadQueue::Submitted, ffGraph::Vulkan::CompleteUploads finds them done.
+    for (size_t i = 0; i < Uploads.Submitted.size( ) && !Allocated; ++i) {
+        UploadBatch& Batch = Uploads.Submitted[i];
+        if (vkGetFenceStatus(GetLogicalDevice( ), Batch.Fence) == VK_NOT_READY) {
+            vkWaitForFences(GetLogicalDevice( ), 1, &Batch.Fence, VK_TRUE, UINT64_MAX);
+            Waited = true;
+        }
+        Uploads.Ring.Release(Batch.ID);
+        Allocated = Uploads.Ring.Allocate(Size, Uploads.Recording.ID, Offset);
+    }
+    // Space given back by batches already done isn't a stall.
+    if (Waited) {
+        Uploads.Stats.Stalls++;
+        Uploads.Stats.StallMs +=
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now( ) - Start).count( );
+    }
+    return Allocated;
+}
+
+static bool CreateDedicatedStaging(VkDeviceSize Size, Buffer& Staging)
+{
+    BufferCreateInfo CreateInfo = {};
+
+    CreateInfo.vkData.SharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    CreateInfo.vkData.Size = Size;
+    CreateInfo.vkData.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    CreateInfo.vmaData.Usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    CreateInfo.vmaData.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    Staging = CreateBuffer(GetAllocator( ), CreateInfo);
+    return Staging.Handle != VK_NULL_HANDLE;
+}
+
+/**
+ * @brief Copy one attribute of every vertex next to each other, see GeometryStream.
+ */
+static void GatherStream(const uint8_t *Vertices, size_t Count, uint8_t Stream, void *Dst)
+{
+    size_t Offset = StreamAttributeOffset(Stream);
+    size_t Stride = StreamStride(Stream);
+    uint8_t *Out = (uint8_t *)Dst;
+    CountCopy(COPY_STAGE_UPLOAD, Count * Stride);
+    for (size_t i = 0; i < Count; ++i)
+        memcpy(Out + i * Stride, Vertices + i * sizeof(Vertex) + Offset, Stride);
+}
+
+uint64_t StageUpload(Root& r, const HeapRange& Range, const uint8_t *Vertices, size_t Count, uint8_t Stream)
+{
+    UploadQueue& Uploads = r.Uploads;
+    UploadCopy Copy;
+    Copy.Target = Range;
+
+    if (Range.Size <= Uploads.Ring.Capacity && AllocateStaging(r, Range.Size, Copy.SourceOffset)) {
+        Copy.Source = Uploads.Ring.GetBuffer( );
+        GatherStream(Vertices, Count, Stream, Uploads.Ring.Data(Copy.SourceOffset));
+    } else {
+        Buffer Staging;
+        if (!CreateDedicatedStaging(Range.Size, Staging)) {
+            LogWarning("StageUpload", "Couldn't create a %lu bytes staging buffer.", (unsigned long)Range.Size);
+            return 0;
+        }
+        GatherStream(Vertices, Count, Stream, Staging.Infos.pMappedData);
+        Copy.Source = Staging.Handle;
+        Uploads.Recording.Staging.push_back(Staging);
+        Uploads.Stats.Dedicated++;
+    }
+    Uploads.Recording.Copies.push_back(Copy);
+    Uploads.Recording.Bytes += Range.Size;
+    return Uploads.Recording.ID;
+}
+
+bool OrphanUpload(Root& r, uint64_t UploadID, const HeapRange& Range)
+{
+    UploadQueue& Uploads = r.Uploads;
+    if (Uploads.Recording.ID == UploadID) {
+        Uploads.Recording.Orphans.push_back(Range);
+        return true;
+    }
+    for (auto& Batch : Uploads.Submitted) {
+        if (Batch.ID == UploadID) {
+            Batch.Orphans.push_back(Range);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SubmitUploads(Root& r)
+{
+    UploadQueue& Uploads = r.Uploads;
+    UploadBatch& Batch = Uploads.Recording;
+    if (Batch.Copies.empty( ))
+        return;
+    if (!CreateTransferObjects(Batch)) {
+        LogError("SubmitUploads", "Failed to create the transfer command buffer, fence or semaphore.");
+        return;
+    }
+
+    VkCommandBufferBeginInfo BeginInfo = {};
+    BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(Batch.CmdBuffer, &BeginInfo);
+
+    // One copy command per source and heap block, with a region per geometry.
+    std::vector<size_t> Order(Batch.Copies.size( ));
+    std::iota(Order.begin( ), Order.end( ), 0);
+    std::stable_sort(Order.begin( ), Order.end( ), [&Batch](size_t a, size_t b) {
+        const UploadCopy& ca = Batch.Copies[a];
+        const UploadCopy& cb = Batch.Copies[b];
+        if (ca.Source != cb.Source)
+            return ca.Source < cb.Source;
+        return ca.Target.Block < cb.Target.Block;
+    });
+    std::vector<VkBufferCopy> Regions;
+    for (size_t i = 0; i < Order.size( ); ++i) {
+        const UploadCopy& Copy = Batch.Copies[Order[i]];
+        VkBufferCopy Region = {Copy.SourceOffset, Copy.Target.Offset, Copy.Target.Size};
+        Regions.push_back(Region);
+        bool Last = i + 1 == Order.size( ) || Batch.Copies[Order[i + 1]].Source != Copy.Source ||
+                    Batch.Copies[Order[i + 1]].Target.Block != Copy.Target.Block;
+        if (!Last)
+            continue;
+        vkCmdCopyBuffer(Batch.CmdBuffer, Copy.Source, r.Heap.GetBuffer(Copy.Target.Block), (uint32_t)Regions.size( ),
+                        Regions.data( ));
+        Regions.clear( );
+    }
+
+    // The new ranges hold nothing worth keeping, the transfer queue writes them without acquiring them first.
+    std::vector<VkBufferMemoryBarrier> Release;
+    if (OwnershipTransfer( )) {
+        for (const auto& Copy : Batch.Copies)
+            Release.push_back(OwnershipBarrier(r, Copy.Target, VK_ACCESS_TRANSFER_WRITE_BIT, 0));
+    }
+    if (!Release.empty( ))
+        vkCmdPipelineBarrier(Batch.CmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0, 0, (uint32_t)Release.size( ), Release.data( ), 0, 0);
+    vkEndCommandBuffer(Batch.CmdBuffer);
+
+    VkSubmitInfo SubmitInfo = {};
+    SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    SubmitInfo.commandBufferCount = 1;
+    SubmitInfo.pCommandBuffers = &Batch.CmdBuffer;
+    SubmitInfo.signalSemaphoreCount = 1;
+    SubmitInfo.pSignalSemaphores = &Batch.Semaphore;
+    if (vkQueueSubmit(GetTransferQueue( ), 1, &SubmitInfo, Batch.Fence) != VK_SUCCESS) {
+        LogError("SubmitUploads", "Failed to submit %zu copies to the transfer queue.", Batch.Copies.size( ));
+        // The copies are recorded again by the next frame.
+        DestroyTransferObjects(Batch);
+        return;
+    }
+
+    Uploads.Stats.Batches++;
+    Uploads.Stats.Bytes += Batch.Bytes;
+    uint64_t NextID = Batch.ID + 1;
+    Uploads.Submitted.push_back(std::move(Batch));
+    Uploads.Recording = UploadBatch( );
+    Uploads.Recording.ID = NextID;
+}
+
+void CompleteUploads(Root& r)
+{
+    UploadQueue& Uploads = r.Uploads;
+    size_t Done = 0;
+    // Batches are checked in submission order, a later one is only counted once the earlier ones are done.
+    while (Done < Uploads.Submitted.size( ) &&
+           vkGetFenceStatus(GetLogicalDevice( ), Uploads.Submitted[Done].Fence) == VK_SUCCESS) {
+        UploadBatch& Batch = Uploads.Submitted[Done++];
+        DestroyStaging(Batch);
+        Uploads.Ring.Release(Batch.ID);
+        Uploads.RateBytes += Batch.Bytes;
+        Uploads.Completed = Batch.ID;
+        Uploads.Acquiring.push_back(std::move(Batch));
+    }
+    Uploads.Submitted.erase(Uploads.Submitted.begin( ), Uploads.Submitted.begin( ) + Done);
+    Uploads.Stats.PendingBatches = Uploads.Submitted.size( ) + (Uploads.Recording.Copies.empty( ) ? 0 : 1);
+    Uploads.Stats.Ring = Uploads.Ring.GetStats( );
+
+    auto Now = std::chrono::steady_clock::now( );
+    double Elapsed = std::chrono::duration<double>(Now - Uploads.RateStart).count( );
+    if (Elapsed >= 1.) {
+        // The first window starts with the first frame.
+        if (Uploads.RateStart != std::chrono::steady_clock::time_point( ))
+            Uploads.Stats.Throughput = Uploads.RateBytes / (1024. * 1024.) / Elapsed;
+        Uploads.RateBytes = 0;
+        Uploads.RateStart = Now;
+    }
+    if (Done == 0)
+        return;
+    FlipGeometries(r);
+    RemoveReplacedGeometries(r);
+    ListRenderedGeometries(r);
+    r.Update = true;
+}
+
+void RecordUploadAcquire(Root& r, VkCommandBuffer CmdBuffer, std::vector<VkSemaphore>& WaitSemaphores,
+                         std::vector<VkPipelineStageFlags>& WaitStages)
+{
+    UploadQueue& Uploads = r.Uploads;
+    if (Uploads.Acquiring.empty( ))
+        return;
+    std::vector<VkBufferMemoryBarrier> Acquire;
+    for (auto& Batch : Uploads.Acquiring) {
+        WaitSemaphores.push_back(Batch.Semaphore);
+        // The ranges may also be moved by the heap compaction recorded right after.
+        WaitStages.push_back(VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT);
+        if (OwnershipTransfer( )) {
+            for (const auto& Copy : Batch.Copies)
+                Acquire.push_back(OwnershipBarrier(r, Copy.Target, 0,
+                                                   VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT));
+        }
+        Uploads.Acquired.push_back(std::move(Batch));
+    }
+    Uploads.Acquiring.clear( );
+    if (!Acquire.empty( ))
+        // The acquire has no source access to wait for, the semaphores already order it after the copies.
+        vkCmdPipelineBarrier(CmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, 0,
+                             (uint32_t)Acquire.size( ), Acquire.data( ), 0, 0);
+}
+
+void FinishUploadAcquire(Root& r, bool Submitted)
+{
+    UploadQueue& Uploads = r.Uploads;
+    if (!Submitted) {
+        // The semaphores weren't waited on, the next frame acquires the batches again.
+        for (auto& Batch : Uploads.Acquiring)
+            Uploads.Acquired.push_back(std::move(Batch));
+        Uploads.Acquiring = std::move(Uploads.Acquired);
+        Uploads.Acquired.clear( );
+        return;
+    }
+    // The semaphores are waited on by this frame, the batches go once the frame is done.
+    for (auto& Batch : Uploads.Acquired) {
+        UploadBatch Retired = std::move(Batch);
+        GetDeletionQueue( ).Defer([&r, Retired]( ) mutable { DestroyUploadBatch(r, Retired); });
+    }
+    Uploads.Acquired.clear( );
+}
+
+static void DestroyReadBack(ReadBack& Copy)
+{
+    VkDevice Device = GetLogicalDevice( );
+    if (Copy.CmdBuffer != VK_NULL_HANDLE)
+        vkFreeCommandBuffers(Device, GetCommandPool( ), 1, &Copy.CmdBuffer);
+    vkDestroyFence(Device, Copy.Fence, 0);
+    DestroyBuffer(GetAllocator( ), Copy.Target);
+    Copy.CmdBuffer = VK_NULL_HANDLE;
+    Copy.Fence = VK_NULL_HANDLE;
+}
+
+static ReadBack *FindReadBack(UploadQueue& Uploads, uint64_t ID)
+{
+    for (auto& Copy : Uploads.ReadBacks)
+        if (Copy.ID == ID)
+            return &Copy;
+    return nullptr;
+}
+
+bool StartReadBack(Root& r, ConstructedGeometry& g)
+{
+    VkDeviceSize Size = g.Geo.Data.ElementCount * g.Geo.Data.ElementSize;
+    if (!IsUploaded(r, g) || Size == 0)
+        return false;
+    ReadBack Copy;
+    Copy.Generation = g.Generation;
+    Copy.FlipFrame = g.FlipFrame;
+    BufferCreateInfo CreateInfo = {};
+
+    CreateInfo.vkData.SharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    CreateInfo.vkData.Size = Size;
+    CreateInfo.vkData.Usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    CreateInfo.vmaData.Usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+    CreateInfo.vmaData.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    CreateInfo.vmaData.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    Copy.Target = CreateBuffer(GetAllocator( ), CreateInfo);
+    if (Copy.Target.Handle == VK_NULL_HANDLE)
+        return false;
+
+    // The graphic queue family owns the uploaded ranges, the copy runs there, ordered after the frames
+    // already submitted.
+    VkDevice Device = GetLogicalDevice( );
+    VkCommandBufferAllocateInfo AllocInfo = {};
+    AllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    AllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    AllocInfo.commandPool = GetCommandPool( );
+    AllocInfo.commandBufferCount = 1;
+    VkFenceCreateInfo FenceInfo = {};
+    FenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    if (vkAllocateCommandBuffers(Device, &AllocInfo, &Copy.CmdBuffer) != VK_SUCCESS ||
+        vkCreateFence(Device, &FenceInfo, 0, &Copy.Fence) != VK_SUCCESS) {
+        LogWarning("StartReadBack", "Failed to create the command buffer or fence reading %s back.", g.Name.c_str( ));
+        DestroyReadBack(Copy);
+        return false;
+    }
+    VkCommandBufferBeginInfo BeginInfo = {};
+    BeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    BeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(Copy.CmdBuffer, &BeginInfo);
+    // The range may have just been written by the heap compaction of the last frame.
+    VkMemoryBarrier Barrier = {};
+    Barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    Barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(Copy.CmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &Barrier,
+                         0, 0, 0, 0);
+    // The streams are copied one after the other and interleaved back on the host.
+    VkDeviceSize Offset = 0;
+    for (uint8_t s = 0; s < GEO_STREAM_COUNT; ++s) {
+        VkBufferCopy Region = {g.Geo.Streams[s].Offset, Offset, g.Geo.streamSize(s)};
+        vkCmdCopyBuffer(Copy.CmdBuffer, r.Heap.GetBuffer(g.Geo.Streams[s].Block), Copy.Target.Handle, 1, &Region);
+        Offset += Region.size;
+    }
+    Barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    Barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(Copy.CmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &Barrier, 0,
+                         0, 0, 0);
+    vkEndCommandBuffer(Copy.CmdBuffer);
+
+    VkSubmitInfo SubmitInfo = {};
+    SubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    SubmitInfo.commandBufferCount = 1;
+    SubmitInfo.pCommandBuffers = &Copy.CmdBuffer;
+    if (vkQueueSubmit(GetGraphicQueue( ), 1, &SubmitInfo, Copy.Fence) != VK_SUCCESS) {
+        LogWarning("StartReadBack", "Failed to submit the copy of geometry %s back from VRAM.", g.Name.c_str( ));
+        DestroyReadBack(Copy);
+        return false;
+    }
+    Copy.ID = r.Uploads.NextReadBack++;
+    g.ReadBackID = Copy.ID;
+    r.Uploads.ReadBacks.push_back(Copy);
+    return true;
+}
+
+uint8_t PollReadBack(Root& r, ConstructedGeometry& g, std::vector<uint8_t>& Data)
+{
+    UploadQueue& Uploads = r.Uploads;
+    ReadBack *Copy = (g.ReadBackID != 0) ? FindReadBack(Uploads, g.ReadBackID) : nullptr;
+    if (Copy == nullptr) {
+        g.ReadBackID = 0;
+        return READ_BACK_NONE;
+    }
+    VkResult Status = vkGetFenceStatus(GetLogicalDevice( ), Copy->Fence);
+    bool Stale = Copy->Generation != g.Generation || Copy->FlipFrame != g.FlipFrame;
+    if (Status == VK_NOT_READY && !Stale)
+        return READ_BACK_PENDING;
+    // A stale copy still in flight is destroyed by CollectReadBacks once it is done.
+    if (Status == VK_NOT_READY) {
+        g.ReadBackID = 0;
+        return READ_BACK_NONE;
+    }
+
+    bool Success = Status == VK_SUCCESS && !Stale;
+    if (Success) {
+        const uint8_t *Src = (const uint8_t *)Copy->Target.Infos.pMappedData;
+        Data.resize(g.Geo.Data.ElementCount * g.Geo.Data.ElementSize);
+        for (uint8_t s = 0; s < GEO_STREAM_COUNT; ++s) {
+            size_t Stride = StreamStride(s);
+            for (size_t i = 0; i < g.Geo.Data.ElementCount; ++i)
+                memcpy(Data.data( ) + i * sizeof(Vertex) + StreamAttributeOffset(s), Src + i * Stride, Stride);
+            Src += g.Geo.streamSize(s);
+        }
+    } else if (!Stale) {
+        LogWarning("PollReadBack", "Failed to copy geometry %s back from VRAM.", g.Name.c_str( ));
+    }
+    DestroyReadBack(*Copy);
+    Uploads.ReadBacks.erase(Uploads.ReadBacks.begin( ) + (Copy - Uploads.ReadBacks.data( )));
+    g.ReadBackID = 0;
+    return (Success) ? READ_BACK_DONE : READ_BACK_NONE;
+}
+
+void CollectReadBacks(Root& r)
+{
+    UploadQueue& Uploads = r.Uploads;
+    if (Uploads.ReadBacks.empty( ))
+        return;
+    auto Orphan = [&r](const ReadBack& Copy) {
+        for (const auto& g : r.Geometries)
+            if (g.ReadBackID == Copy.ID)
+                return false;
+        return vkGetFenceStatus(GetLogicalDevice( ), Copy.Fence) != VK_NOT_READY;
+    };
+    for (auto& Copy : Uploads.ReadBacks)
+        if (Orphan(Copy))
+            DestroyReadBack(Copy);
+    Uploads.ReadBacks.erase(std::remove_if(Uploads.ReadBacks.begin( ), Uploads.ReadBacks.end( ),
+                                           [](const ReadBack& Copy) { return Copy.Fence == VK_NULL_HANDLE; }),
+                            Uploads.ReadBacks.end( ));
+}
+
+void DestroyUploadBatch(Root& r, UploadBatch& Batch)
+{
+    DestroyStaging(Batch);
+    for (auto& Range : Batch.Orphans)
+        r.Heap.Free(Range);
+    Batch.Orphans.clear( );
+    Batch.Copies.clear( );
+    DestroyTransferObjects(Batch);
+}
+
+void DestroyUploads(Root& r)
+{
+    UploadQueue& Uploads = r.Uploads;
+    DestroyUploadBatch(r, Uploads.Recording);
+    for (auto& Batch : Uploads.Submitted)
+        DestroyUploadBatch(r, Batch);
+    for (auto& Batch : Uploads.Acquiring)
+        DestroyUploadBatch(r, Batch);
+    for (auto& Batch : Uploads.Acquired)
+        DestroyUploadBatch(r, Batch);
+    for (auto& Copy : Uploads.ReadBacks)
+        DestroyReadBack(Copy);
+    Uploads.Submitted.clear( );
+    Uploads.Acquiring.clear( );
+    Uploads.Acquired.clear( );
+    Uploads.ReadBacks.clear( );
+    Uploads.Ring.Destroy( );
+}
+
+}    // namespace Vulkan
+}    // namespace ffGraph
@@ -0,0 +1,107 @@
+/**
+ * @file Upload.h
+ * @brief Copies of the geometries to the device local geometry heap, recorded on the transfer queue. A
+ * geometry is drawn once its copy is done, until then the previous scene stays on screen.
+ */
+#ifndef UPLOAD_H_
+#define UPLOAD_H_
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "Resource/Buffer/Buffer.h"
+#include "Resource/Buffer/GeometryHeap.h"
+#include "Resource/Buffer/StagingRing.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+struct UploadCopy {
+    HeapRange Target;
+    VkBuffer Source = VK_NULL_HANDLE;
+    VkDeviceSize SourceOffset = 0;
+};
+
+/**
+ * @brief Geometries copied from the staging ring by one transfer submission, a frame's worth. The copied ranges are
+ * released by the transfer queue family and acquired by the graphic one, see
+ * ffGraph::Vulkan::RecordUploadAcquire.
+ */
+struct UploadBatch {
+    uint64_t ID = 0;
+    VkCommandBuffer CmdBuffer = VK_NULL_HANDLE;
+    // @brief Signaled when the copies are done, polled by ffGraph::Vulkan::CompleteUploads.
+    VkFence Fence = VK_NULL_HANDLE;
+    // @brief Waited on by the first frame drawing the copied geometries.
+    VkSemaphore Semaphore = VK_NULL_HANDLE;
+    std::vector<UploadCopy> Copies;
+    // @brief Staging buffers of the geometries larger than the whole staging ring.
+    std::vector<Buffer> Staging;
+    VkDeviceSize Bytes = 0;
+    // @brief Ranges of geometries removed while being copied, freed with the batch.
+    std::vector<HeapRange> Orphans;
+};
+
+/**
+ * @brief Copy of a geometry from the geometry heap back to the host, submitted on the graphic queue and
+ * polled by ffGraph::Vulkan::PollReadBack instead of waited for.
+ */
+struct ReadBack {
+    uint64_t ID = 0;
+    // @brief Generation and last swap of the geometry when the copy was recorded, it is stale once they change.
+    uint32_t Generation = 0;
+    uint64_t FlipFrame = 0;
+    VkCommandBuffer CmdBuffer = VK_NULL_HANDLE;
+    VkFence Fence = VK_NULL_HANDLE;
+    // @brief The streams one after the other.
+    Buffer Target;
+};
+
+enum ReadBackState : uint8_t { READ_BACK_NONE, READ_BACK_PENDING, READ_BACK_DONE };
+
+struct UploadStats {
+    size_t Batches = 0;
+    size_t PendingBatches = 0;
+    VkDeviceSize Bytes = 0;
+    // @brief Transfer throughput over the last second, in MB per second.
+    double Throughput = 0.;
+    // @brief Uploads which waited for the staging ring, and for how long in total.
+    size_t Stalls = 0;
+    double StallMs = 0.;
+    // @brief Uploads too large for the staging ring, given a staging buffer of their own.
+    size_t Dedicated = 0;
+    // @brief Bytes of streams shared with a geometry already in the geometry heap instead of uploaded.
+    VkDeviceSize SharedBytes = 0;
+    // @brief Geometries sharing every stream of one built from the same content, see ffGraph::JSON::ContentCache.
+    size_t ContentHits = 0;
+    // @brief New generations written over the back streams of the drawn one, see ffGraph::Vulkan::UpdateGeometry.
+    size_t InPlaceUpdates = 0;
+    StagingRingStats Ring;
+};
+
+struct UploadQueue {
+    UploadQueue( ) { Recording.ID = 1; }
+
+    // @brief Every batch up to this one is done, see ffGraph::ConstructedGeometry::UploadID.
+    uint64_t Completed = 0;
+    // @brief Copies waiting for ffGraph::Vulkan::SubmitUploads.
+    UploadBatch Recording;
+    StagingRing Ring;
+    std::vector<UploadBatch> Submitted;
+    // @brief Done, acquired by the graphic queue during the next frame.
+    std::vector<UploadBatch> Acquiring;
+    // @brief Acquired by the frame being recorded, see ffGraph::Vulkan::FinishUploadAcquire.
+    std::vector<UploadBatch> Acquired;
+    std::vector<ReadBack> ReadBacks;
+    uint64_t NextReadBack = 1;
+    UploadStats Stats;
+    // @brief Window UploadStats::Throughput is measured over.
+    std::chrono::steady_clock::time_point RateStart;
+    VkDeviceSize RateBytes = 0;
+};
+
+}    // namespace Vulkan
+}    // namespace ffGraph
+
+#endif    // UPLOAD_H_
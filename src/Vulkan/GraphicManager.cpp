@@ -4,6 +4,24 @@
 namespace ffGraph {
 namespace Vulkan {
 
+/**
+ * @brief Wait for this submission only, instead of everything else on the queue.
+ */
+static void submitAndWait(const VkDevice& Device, const VkQueue& Queue, const VkSubmitInfo& submitInfo) {
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence fence = VK_NULL_HANDLE;
+    if (vkCreateFence(Device, &fenceInfo, 0, &fence)) {
+        vkQueueSubmit(Queue, 1, &submitInfo, VK_NULL_HANDLE);
+        vkQueueWaitIdle(Queue);
+        return;
+    }
+    if (vkQueueSubmit(Queue, 1, &submitInfo, fence) == VK_SUCCESS)
+        vkWaitForFences(Device, 1, &fence, VK_TRUE, UINT64_MAX);
+    vkDestroyFence(Device, fence, 0);
+}
+
 static bool pushDepthImage(const VkDevice& Device, const VkQueue& Queue, const Image DepthImage,
                            const VkCommandPool& Pool) {
     VkCommandBufferAllocateInfo AllocInfo = {};
@@ -38,8 +56,7 @@ static bool pushDepthImage(const VkDevice& Device, const VkQueue& Queue, const I
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &cmdBuffer;
 
-    vkQueueSubmit(Queue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(Queue);
+    submitAndWait(Device, Queue, submitInfo);
 
     vkFreeCommandBuffers(Device, Pool, 1, &cmdBuffer);
     return true;
@@ -80,8 +97,7 @@ static bool pushColorImage(const VkDevice& Device, const VkQueue& Queue, const I
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &cmdBuffer;
 
-    vkQueueSubmit(Queue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(Queue);
+    submitAndWait(Device, Queue, submitInfo);
 
     vkFreeCommandBuffers(Device, Pool, 1, &cmdBuffer);
     return true;
@@ -130,7 +130,6 @@ static bool InitImGuiResource(UiPipeline& Node) {
 }
 
 void UpdateUiPipeline(UiPipeline& Node) {
-    vkDeviceWaitIdle(GetLogicalDevice( ));
     ImDrawData* imDrawData = ImGui::GetDrawData( );
 
     // Note: Alignment is done inside buffer creation
@@ -146,7 +145,7 @@ void UpdateUiPipeline(UiPipeline& Node) {
 
     // Vertex buffer
     if ((Node.ImGuiVertices.Handle == VK_NULL_HANDLE) || (Node.VertexCount != imDrawData->TotalVtxCount)) {
-        DestroyBuffer(GetAllocator( ), Node.ImGuiVertices);
+        GetDeletionQueue( ).DeferBuffer(Node.ImGuiVertices);
 
         BufferCreateInfo vInfo = {};
         vInfo.vkData.Usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
@@ -164,7 +163,7 @@ void UpdateUiPipeline(UiPipeline& Node) {
     // Index buffer
     VkDeviceSize indexSize = imDrawData->TotalIdxCount * sizeof(ImDrawIdx);
     if ((Node.ImGuiIndices.Handle == VK_NULL_HANDLE) || (Node.IndexCount < imDrawData->TotalIdxCount)) {
-        DestroyBuffer(GetAllocator( ), Node.ImGuiIndices);
+        GetDeletionQueue( ).DeferBuffer(Node.ImGuiIndices);
 
         BufferCreateInfo vInfo = {};
         vInfo.vkData.Usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
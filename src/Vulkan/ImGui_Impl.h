@@ -39,6 +39,10 @@ struct UiPipeline {
 };
 
 UiPipeline NewUiPipeline(UiPipeline& Node, const VkShaderModule Shaders[2]);
+/**
+ * @brief Write the ImGui draw data to the UI buffers, in place. Called once the previous frame is done with
+ * them, see Instance::render. Outgrown buffers go through the deletion queue.
+ */
 void UpdateUiPipeline(UiPipeline& n);
 void DestroyUiPipeline(UiPipeline& n);
 
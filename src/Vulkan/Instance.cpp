@@ -1,9 +1,12 @@
 #include <imgui.h>
 #include <assert.h>
+#include <cstdlib>
+#include <cstring>
 #include "Instance.h"
 #include "Logger.h"
 #include "utils.h"
 #include "GlobalEnvironment.h"
+#include "MemoryTracker.h"
 
 namespace ffGraph {
 namespace Vulkan {
@@ -40,8 +43,29 @@ static bool ImportShaders(ShaderLibrary &Shaders, const VkDevice &Device) {
     return true;
 }
 
+// The size of an ImGui allocation is stored in front of it so frees can be accounted.
+static constexpr size_t ImGuiAllocHeader = 16;
+
+static void *ImGuiTrackedAlloc(size_t Size, void *) {
+    char *p = (char *)malloc(Size + ImGuiAllocHeader);
+    if (p == nullptr) return nullptr;
+    memcpy(p, &Size, sizeof(size_t));
+    MemoryManagement::GetMemoryTracker( ).Add(MemoryManagement::MEMORY_TAG_IMGUI, Size);
+    return p + ImGuiAllocHeader;
+}
+
+static void ImGuiTrackedFree(void *Ptr, void *) {
+    if (Ptr == nullptr) return;
+    char *p = (char *)Ptr - ImGuiAllocHeader;
+    size_t Size;
+    memcpy(&Size, p, sizeof(size_t));
+    MemoryManagement::GetMemoryTracker( ).Remove(MemoryManagement::MEMORY_TAG_IMGUI, Size);
+    free(p);
+}
+
 static void InitImGui(int width, int height) {
     IMGUI_CHECKVERSION( );
+    ImGui::SetAllocatorFunctions(ImGuiTrackedAlloc, ImGuiTrackedFree);
     assert(ImGui::CreateContext( ) != 0);
 
     ImGuiStyle &style = ImGui::GetStyle( );
@@ -177,6 +201,7 @@ void Instance::load(const std::string &AppName, unsigned int width, unsigned int
 
 void Instance::destroy( ) {
     vkDeviceWaitIdle(Env.GPUInfos.Device);
+    Env.Deletion.Flush( );
     DestroyUiPipeline(Ui);
     DestroyGraph(RenderGraph);
 
@@ -10,8 +10,10 @@
 #include "Frame.h"
 #include "Resource/Shader.h"
 #include "ThreadQueue.h"
+#include "Payload.h"
 #include "ImGui_Impl.h"
 #include "Graph/Root.h"
+#include "SoakTest.h"
 
 namespace ffGraph {
 namespace Vulkan {
@@ -29,6 +31,8 @@ class Instance {
 
     UiPipeline Ui;
     Root RenderGraph;
+    // @brief Driven by Instance::run when enabled, which then returns once the test is over.
+    SoakTest Soak;
 
     bool PressedButton[5] = {false, false, false, false, false};
 
@@ -45,7 +49,7 @@ class Instance {
     void load(const std::string& AppName, unsigned int width, unsigned int height);
     void reload( );
     void destroy( );
-    void run(std::shared_ptr<std::deque<std::string>> SharedQueue, JSON::ThreadSafeQueue& GeometryQueue);
+    void run(std::shared_ptr<JSON::PayloadQueue> SharedQueue, JSON::ThreadSafeQueue& GeometryQueue);
     void render( );
     void renderUI( );
 
@@ -41,6 +41,8 @@ void Instance::render( ) {
         vkWaitForFences(Env.GPUInfos.Device, 1, &CurrentFrame.PresentFence, VK_TRUE, UINT64_MAX);
         vkResetFences(Env.GPUInfos.Device, 1, &CurrentFrame.PresentFence);
     }
+    // The previous frame is over, nothing reads the UI buffers anymore.
+    UpdateUiPipeline(Ui);
 
     uint32_t imageIndex = UINT32_MAX;
     VkResult res;
@@ -57,6 +59,11 @@ void Instance::render( ) {
 
     if (vkBeginCommandBuffer(CurrentFrame.CmdBuffer, &CmdBufferBeginInfo)) return;
 
+    std::vector<VkSemaphore> WaitSemaphores(1, CurrentFrame.AcquireSemaphore);
+    std::vector<VkPipelineStageFlags> WaitStages(1, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    RecordUploadAcquire(RenderGraph, CurrentFrame.CmdBuffer, WaitSemaphores, WaitStages);
+    RecordHeapCompaction(RenderGraph, CurrentFrame.CmdBuffer);
+
     VkClearValue clearValues[3];
     clearValues[0].color.float32[0] = 1.0f;
     clearValues[0].color.float32[1] = 1.0f;
@@ -84,6 +91,9 @@ void Instance::render( ) {
 
     if (!RenderGraph.Pipelines.empty()) {
         for (size_t i = 0; i < RenderGraph.RenderedGeometries.size(); ++i) {
+            Geometry& Geo = RenderGraph.Geometries[RenderGraph.RenderedGeometries[i]].Geo;
+            if (!RenderGraph.Geometries[RenderGraph.RenderedGeometries[i]].Visible || Geo.count() == 0)
+                continue;
             const Pipeline p = RenderGraph.Pipelines[RenderGraph.Geometries[RenderGraph.RenderedGeometries[i]].Geo.Description.PipelineID];
             vkCmdBindPipeline(CurrentFrame.CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, p.Handle);
 
@@ -97,7 +107,10 @@ void Instance::render( ) {
 
             vkCmdSetViewport(CurrentFrame.CmdBuffer, 0, 1, &viewport);
 
+            StreamRange Color, Previous;
             RenderGraph.CamUniform.ViewProj = RenderGraph.Cam.Handle.ViewProjMatrix;
+            RenderGraph.CamUniform.ColorBlend =
+                SelectColorSteps(RenderGraph, RenderGraph.Geometries[RenderGraph.RenderedGeometries[i]], Color, Previous);
             vkCmdPushConstants(CurrentFrame.CmdBuffer, p.Layout, VK_SHADER_STAGE_VERTEX_BIT, 0, p.CreationData.PushConstantHandle.Size,
                            p.CreationData.PushConstantHandle.pData);
 
@@ -109,10 +122,17 @@ void Instance::render( ) {
             scissor.extent.height = m_Window.WindowSize.height;
             vkCmdSetScissor(CurrentFrame.CmdBuffer, 0, 1, &scissor);
 
-            vkCmdBindVertexBuffers(CurrentFrame.CmdBuffer, 0, 1, &RenderGraph.RenderBuffer.Handle,
-                    &RenderGraph.Geometries[RenderGraph.RenderedGeometries[i]].Geo.BufferOffset);
+            // The colours are those of the time step played back.
+            StreamRange Bound[GEO_STREAM_COUNT + 1] = {Geo.Streams[GEO_STREAM_POSITION], Color, Previous};
+            VkBuffer Blocks[GEO_STREAM_COUNT + 1];
+            VkDeviceSize Offsets[GEO_STREAM_COUNT + 1];
+            for (uint32_t b = 0; b < GEO_STREAM_COUNT + 1; ++b) {
+                Blocks[b] = RenderGraph.Heap.GetBuffer(Bound[b].Block);
+                Offsets[b] = Bound[b].Offset;
+            }
+            vkCmdBindVertexBuffers(CurrentFrame.CmdBuffer, 0, GEO_STREAM_COUNT + 1, Blocks, Offsets);
 
-            vkCmdDraw(CurrentFrame.CmdBuffer, RenderGraph.Geometries[RenderGraph.RenderedGeometries[i]].Geo.count(), 1, 0, 0);
+            vkCmdDraw(CurrentFrame.CmdBuffer, Geo.count(), 1, 0, 0);
         }
     }
 
@@ -122,18 +142,18 @@ void Instance::render( ) {
 
     res = vkEndCommandBuffer(CurrentFrame.CmdBuffer);
 
-    VkPipelineStageFlags pipelineStageFlags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &CurrentFrame.AcquireSemaphore;
-    submitInfo.pWaitDstStageMask = &pipelineStageFlags;
+    submitInfo.waitSemaphoreCount = WaitSemaphores.size( );
+    submitInfo.pWaitSemaphores = WaitSemaphores.data( );
+    submitInfo.pWaitDstStageMask = WaitStages.data( );
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &CurrentFrame.CmdBuffer;
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = &CurrentFrame.RenderSemaphore;
 
     res = vkQueueSubmit(Env.GPUInfos.Queues[Env.GPUInfos.GraphicQueueIndex], 1, &submitInfo, CurrentFrame.PresentFence);
+    FinishUploadAcquire(RenderGraph, res == VK_SUCCESS);
     if (res != VK_SUCCESS) return;
 
     VkPresentInfoKHR presentInfo = {};
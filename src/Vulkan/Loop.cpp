@@ -1,16 +1,91 @@
 #include <imgui.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <string>
 #include <memory>
 #include <iostream>
+#include <thread>
 #include "Instance.h"
 #include "Import.h"
+#include "ContentCache.h"
 #include "Graph/Root.h"
+#include "GlobalEnvironment.h"
+#include "ChunkPool.h"
+#include "CopyCounter.h"
+#include "Logger.h"
+#include "MemoryTracker.h"
 
 namespace ffGraph {
 namespace Vulkan {
 
-static void newGraphFrame(Root& r)
+/**
+ * @brief Live counters of ffGraph::MemoryManagement::MemoryTracker, with a button writing the JSON dump.
+ */
+static void MemoryDiagnosticsWindow( )
+{
+    MemoryManagement::MemoryTracker& Tracker = MemoryManagement::GetMemoryTracker( );
+    const float MB = 1.f / (1024.f * 1024.f);
+
+    ImGui::Begin("Memory diagnostics");
+    ImGui::Columns(5, "MemoryTags");
+    ImGui::Text("Subsystem"); ImGui::NextColumn();
+    ImGui::Text("Live (MB)"); ImGui::NextColumn();
+    ImGui::Text("Peak (MB)"); ImGui::NextColumn();
+    ImGui::Text("Allocations"); ImGui::NextColumn();
+    ImGui::Text("Frees"); ImGui::NextColumn();
+    ImGui::Separator();
+    for (uint8_t t = 0; t < MemoryManagement::MEMORY_TAG_COUNT; ++t) {
+        MemoryManagement::MemoryTagStats s = Tracker.GetStats((MemoryManagement::MemoryTag)t);
+        ImGui::Text("%s", MemoryManagement::GetMemoryTagName((MemoryManagement::MemoryTag)t)); ImGui::NextColumn();
+        ImGui::Text("%.2f", s.Live * MB); ImGui::NextColumn();
+        ImGui::Text("%.2f", s.Peak * MB); ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long)s.Allocations); ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long)s.Frees); ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+    ImGui::Separator();
+    if (ImGui::Button("Dump JSON")) {
+        const std::string& Path = Tracker.GetDumpPath( );
+        if (Tracker.DumpJSON(Path))
+            LogInfo("MemoryDiagnostics", "Memory counters written to %s.", Path.c_str( ));
+        else
+            LogWarning("MemoryDiagnostics", "Failed to write %s.", Path.c_str( ));
+    }
+    ImGui::End( );
+}
+
+/**
+ * @brief Play, pause and scrub through the time series kept in VRAM, see ffGraph::Vulkan::TimeSeries.
+ */
+static void PlaybackWindow(Root& r)
+{
+    TimeSeries& Series = r.Series;
+    const float MB = 1.f / (1024.f * 1024.f);
+
+    ImGui::Begin("Playback");
+    ImGui::Text("%u steps kept, %.1f MB", Series.Stats.Depth, Series.Stats.Bytes * MB);
+    if (ImGui::Checkbox("Live", &Series.Live) && !Series.Live)
+        Series.Position = 0.f;
+    ImGui::SameLine( );
+    if (ImGui::Button(Series.Playing ? "Pause" : "Play")) {
+        Series.Playing = !Series.Playing;
+        Series.Live = false;
+    }
+    ImGui::SameLine( );
+    ImGui::Checkbox("Interpolate", &Series.Interpolate);
+    ImGui::SliderFloat("Steps / s", &Series.Rate, 0.5f, 60.f);
+    // The bar goes forward in time, the position counts back from the latest step.
+    float Last = (float)(Series.Stats.Depth - 1);
+    float Step = Last - Series.Position;
+    if (ImGui::SliderFloat("Step", &Step, 0.f, Last)) {
+        Series.Position = Last - Step;
+        Series.Live = false;
+    }
+    ImGui::End( );
+}
+
+static void newGraphFrame(Root& r, const JSON::GeometryQueueStats& Queue)
 {
     static glm::vec3 Rotation;
     static float ZoomLevel;
@@ -60,30 +135,149 @@ static void newGraphFrame(Root& r)
     ImGui::SameLine();
     if (ImGui::Button("Z -"))
         r.Cam.Translate(glm::vec3(0.f, 0.f, -0.25f * std::min(r.Cam.ZoomLevel, 1.f)));
+
+    ImGui::Separator();
+    std::vector<uint16_t> PlotIDs;
+    for (const auto& g : r.Geometries) {
+        if (std::find(PlotIDs.begin(), PlotIDs.end(), g.PlotID) == PlotIDs.end())
+            PlotIDs.push_back(g.PlotID);
+    }
+    bool RemoveRequested = false;
+    uint16_t PlotToRemove = 0;
+    for (uint16_t PlotID : PlotIDs) {
+        ImGui::PushID(PlotID);
+        ImGui::Text("Plot %u", PlotID);
+        for (const auto& p : r.Residency.Plots) {
+            if (p.PlotID != PlotID)
+                continue;
+            bool Visible = p.Visible;
+            ImGui::SameLine();
+            if (ImGui::Checkbox("Visible", &Visible))
+                SetPlotVisible(r, PlotID, Visible);
+            ImGui::SameLine();
+            if (p.ResidentSize == p.Size)
+                ImGui::Text("VRAM");
+            else if (p.OverBudget)
+                ImGui::Text("over budget");
+            else
+                ImGui::Text("host");
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Remove")) {
+            RemoveRequested = true;
+            PlotToRemove = PlotID;
+        }
+        for (const auto& m : r.Meshes) {
+            if (m.PlotID != PlotID || m.Fields < 2)
+                continue;
+            // Every field stays in VRAM, switching only changes what is drawn.
+            ImGui::PushID(m.MeshID);
+            int Field = m.ActiveField;
+            ImGui::Text("Mesh %u : %u fields (%.1f MB), mesh %.1f MB", m.MeshID, m.Fields, m.FieldSize / (1024.f * 1024.f),
+                        m.MeshSize / (1024.f * 1024.f));
+            if (ImGui::SliderInt("Field (0 : all)", &Field, 0, m.Fields))
+                SelectField(r, PlotID, m.MeshID, (uint16_t)Field);
+            ImGui::PopID();
+        }
+        ImGui::PopID();
+    }
+
+    ImGui::Separator();
+    MemoryManagement::ChunkPoolStats Stats = MemoryManagement::GetChunkPool( ).GetStats( );
+    const float MB = 1.f / (1024.f * 1024.f);
+    ImGui::Text("Host memory : %.1f MB used, %.1f MB reserved", Stats.Live * MB, Stats.Reserved * MB);
+    ImGui::Text("Peak : %.1f MB used, %.1f MB reserved", Stats.PeakLive * MB, Stats.PeakReserved * MB);
+    ImGui::Text("Fragmentation : %.1f %%, %.1f MB cached", Stats.Fragmentation( ) * 100.f, Stats.Cached * MB);
+    ImGui::Text("Arena backend : %s, %.1f MB prefaulted", MemoryManagement::GetChunkBackendName(Stats.Backend), Stats.Prefaulted * MB);
+    const JSON::HostMemoryStats& Host = r.HostMemory;
+    ImGui::Text("Host copies : %.1f MB resident, %.1f MB compressed (%.1f MB raw)", Host.Resident * MB, Host.Compressed * MB, Host.CompressedRaw * MB);
+    ImGui::Text("GPU only : %.1f MB, %zu evictions", Host.GpuOnly * MB, Host.Evictions);
+    if (JSON::GHostResidency.Budget != 0)
+        ImGui::Text("Host budget : %.1f / %.1f MB", Host.Total( ) * MB, JSON::GHostResidency.Budget * MB);
+    const GpuResidencyStats& Gpu = r.Residency.Stats;
+    if (r.Residency.Budget != 0)
+        ImGui::Text("VRAM : %.1f / %.1f MB, %.1f MB on host", Gpu.Resident * MB, r.Residency.Budget * MB, Gpu.Evicted * MB);
+    else
+        ImGui::Text("VRAM : %.1f MB, %.1f MB on host", Gpu.Resident * MB, Gpu.Evicted * MB);
+    GeometryHeapStats Heap = r.Heap.GetStats( );
+    ImGui::Text("Geometry heap : %zu blocks, %.1f / %.1f MB, %zu free ranges (largest %.1f MB)", Heap.Blocks,
+                Heap.Used * MB, Heap.Reserved * MB, Heap.FreeRanges, Heap.LargestFree * MB);
+    const HeapCompactionStats& Compaction = r.Compaction.Stats;
+    ImGui::Text("Heap compaction : %s, %.0f%% fragmented (threshold %.0f%%), %zu passes, %zu blocks emptied, %zu moves, %.1f MB",
+                r.Compaction.Active ? "running" : "idle", Compaction.Fragmentation * 100.f, r.Compaction.Threshold * 100.f,
+                Compaction.Passes, Compaction.BlocksEmptied, Compaction.Moves, Compaction.BytesMoved * MB);
+    ImGui::Text("Residency : %zu evictions, %zu uploads, %zu pending", Gpu.Evictions, Gpu.Uploads, Gpu.PendingJobs);
+    const UploadStats& Uploads = r.Uploads.Stats;
+    ImGui::Text("Transfers : %.1f MB/s, %zu batches, %.1f MB, %zu pending, %.1f MB shared",
+                Uploads.Throughput, Uploads.Batches, Uploads.Bytes * MB, Uploads.PendingBatches, Uploads.SharedBytes * MB);
+    ImGui::Text("In place updates : %zu", Uploads.InPlaceUpdates);
+    JSON::ContentCacheStats Content = JSON::GContentCache.GetStats( );
+    ImGui::Text("Content cache : %zu hits, %zu misses (%zu entries), %zu uploads skipped", Content.Hits, Content.Misses,
+                Content.Entries, Uploads.ContentHits);
+#ifdef _DEBUG
+    ImGui::Text("Plot data copies : %.1f MB to payloads, %.1f MB decoded, %.1f MB extracted, %.1f MB by the import, %.1f MB for uploads",
+                GetCopiedBytes(COPY_STAGE_PAYLOAD) * MB, GetCopiedBytes(COPY_STAGE_DECODE) * MB,
+                GetCopiedBytes(COPY_STAGE_EXTRACT) * MB, GetCopiedBytes(COPY_STAGE_IMPORT) * MB,
+                GetCopiedBytes(COPY_STAGE_UPLOAD) * MB);
+#endif
+    ImGui::Text("Staging ring : %.1f / %.1f MB (peak %.1f MB), %zu stalls (%.1f ms), %zu dedicated",
+                Uploads.Ring.Used * MB, Uploads.Ring.Capacity * MB, Uploads.Ring.PeakUsed * MB, Uploads.Stalls,
+                Uploads.StallMs, Uploads.Dedicated);
+    ImGui::Text("Deletion queue : %zu pending", GetDeletionQueue( ).Size( ));
+    ImGui::Text("Geometry queue : %zu / %zu (peak %zu), %llu stalls", Queue.Depth, Queue.Capacity, Queue.PeakDepth,
+                (unsigned long long)Queue.FullStalls);
     ImGui::End();
+    MemoryDiagnosticsWindow( );
+    PlaybackWindow(r);
 
     ImGui::Render();
+    if (RemoveRequested)
+        RemovePlot(r, PlotToRemove);
 }
 
-void Instance::run(std::shared_ptr<std::deque<std::string>> SharedQueue, JSON::ThreadSafeQueue& GeometryQueue) {
+void Instance::run(std::shared_ptr<JSON::PayloadQueue> SharedQueue, JSON::ThreadSafeQueue& GeometryQueue) {
     InitCameraController(RenderGraph.Cam, 1280.f / 768.f, 90.f, CameraType::_3D);
     RenderGraph.Cam.Translate(glm::vec3(0.5, -0.5, 0));
-    RenderGraph.CamUniform.Model = glm::mat4(1.0f);
 
-    while (!ffWindowShouldClose(m_Window)) {
-        UpdateImGuiButton( );
-        if (!SharedQueue->empty( )) {
-            JSON::AsyncImport(SharedQueue->at(0), GeometryQueue);
-            SharedQueue->pop_front( );
+    // Messages are decoded on their own thread : the geometry queue is bounded, so the render loop can't be
+    // both the producer blocked on a full queue and the consumer supposed to drain it.
+    std::atomic<bool> Running(true);
+    std::atomic<uint64_t> Imported(0);
+    std::thread ImportThread([&Running, &Imported, SharedQueue, &GeometryQueue]( ) {
+        while (Running.load( )) {
+            JSON::Payload Message;
+            if (SharedQueue->WaitPop(Message, 50)) {
+                JSON::AsyncImport(Message, GeometryQueue);
+                Imported++;
+            }
         }
-        if (!GeometryQueue.empty()) {
-            ConstructedGeometry g = GeometryQueue.pop();
-            AddToGraph(RenderGraph, g, Shaders);
+    });
+
+    std::vector<ConstructedGeometry> Ready;
+    auto FrameStart = std::chrono::steady_clock::now( );
+    while (!ffWindowShouldClose(m_Window) && !Soak.Finished( )) {
+        UpdateImGuiButton( );
+        // Everything ready is uploaded at once, instead of one geometry per frame.
+        if (GeometryQueue.try_pop_bulk(Ready) != 0) {
+            AddToGraph(RenderGraph, Ready, Shaders);
+            Ready.clear( );
         }
-        newGraphFrame(RenderGraph);
-        UpdateUiPipeline(Ui);
+        UpdateGpuResidency(RenderGraph);
+        SubmitUploads(RenderGraph);
+        CompleteUploads(RenderGraph);
+        auto Now = std::chrono::steady_clock::now( );
+        double FrameMs = std::chrono::duration<double, std::milli>(Now - FrameStart).count( );
+        FrameStart = Now;
+        UpdatePlayback(RenderGraph, FrameMs / 1000.);
+        Soak.Update(RenderGraph, *SharedQueue, GeometryQueue, Imported.load( ), FrameMs);
+        newGraphFrame(RenderGraph, GeometryQueue.GetStats( ));
         render( );
+        Env.Deletion.Advance( );
+        AdvanceFrame(RenderGraph);
     }
+    Running.store(false);
+    GeometryQueue.close( );
+    ImportThread.join( );
 }
 
 }
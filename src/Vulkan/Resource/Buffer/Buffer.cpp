@@ -1,5 +1,6 @@
 #include "Buffer.h"
 #include "Logger.h"
+#include "MemoryTracker.h"
 
 namespace ffGraph {
 namespace Vulkan {
@@ -28,11 +29,13 @@ Buffer CreateBuffer(VmaAllocator Allocator, BufferCreateInfo pCreateInfo) {
         LogError(GetCurrentLogLocation( ), "Failed to create Buffer.\n");
         return Buffer();
     }
+    MemoryManagement::GetMemoryTracker( ).Add(MemoryManagement::MEMORY_TAG_VMA_BUFFER, n.Infos.size);
     return n;
 }
 
 void DestroyBuffer(VmaAllocator Allocator, Buffer toDestroy) {
     if (toDestroy.Handle == VK_NULL_HANDLE) return;
+    MemoryManagement::GetMemoryTracker( ).Remove(MemoryManagement::MEMORY_TAG_VMA_BUFFER, toDestroy.Infos.size);
     vmaDestroyBuffer(Allocator, toDestroy.Handle, toDestroy.Memory);
 }
 
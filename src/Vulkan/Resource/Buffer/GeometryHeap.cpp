@@ -0,0 +1,203 @@
+#include <algorithm>
+#include "GeometryHeap.h"
+#include "GlobalEnvironment.h"
+#include "Logger.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+static VkDeviceSize AlignSize(VkDeviceSize Size)
+{
+    return (Size + GeometryHeap::Alignment - 1) & ~(GeometryHeap::Alignment - 1);
+}
+
+bool GeometryHeap::AddBlock(VkDeviceSize MinSize, uint32_t& Index)
+{
+    BufferCreateInfo CreateInfo = {};
+
+    CreateInfo.vkData.SharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    CreateInfo.vkData.Size = std::max(BlockSize, MinSize);
+    // Written by the transfer queue, read back for geometries without host copy.
+    CreateInfo.vkData.Usage =
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    CreateInfo.vmaData.Usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    Buffer Memory = CreateBuffer(GetAllocator( ), CreateInfo);
+    if (Memory.Handle == VK_NULL_HANDLE) {
+        LogWarning("GeometryHeap", "Couldn't create a %lu bytes geometry block.", (unsigned long)CreateInfo.vkData.Size);
+        return false;
+    }
+
+    // Slots of destroyed blocks are reused, so the block index of the live geometries never changes.
+    Index = (uint32_t)Blocks.size( );
+    for (uint32_t i = 0; i < Blocks.size( ); ++i) {
+        if (Blocks[i].Memory.Handle == VK_NULL_HANDLE) {
+            Index = i;
+            break;
+        }
+    }
+    if (Index == Blocks.size( ))
+        Blocks.push_back(Block( ));
+    Block& b = Blocks[Index];
+    b.Memory = Memory;
+    b.Size = CreateInfo.vkData.Size;
+    b.Used = 0;
+    b.Ranges = 0;
+    b.Free.assign(1, FreeRange{0, b.Size});
+    return true;
+}
+
+bool GeometryHeap::FindFree(VkDeviceSize Size, uint32_t Excluded, uint32_t& BestBlock, size_t& BestRange) const
+{
+    BestRange = SIZE_MAX;
+    VkDeviceSize BestSize = VK_WHOLE_SIZE;
+    for (uint32_t i = 0; i < Blocks.size( ); ++i) {
+        if (i == Excluded)
+            continue;
+        const std::vector<FreeRange>& Free = Blocks[i].Free;
+        for (size_t j = 0; j < Free.size( ); ++j) {
+            if (Free[j].Size >= Size && Free[j].Size < BestSize) {
+                BestBlock = i;
+                BestRange = j;
+                BestSize = Free[j].Size;
+            }
+        }
+    }
+    return BestRange != SIZE_MAX;
+}
+
+void GeometryHeap::Take(uint32_t BlockIndex, size_t FreeIndex, VkDeviceSize Size, HeapRange& Range)
+{
+    Block& b = Blocks[BlockIndex];
+    FreeRange& f = b.Free[FreeIndex];
+    Range = HeapRange(BlockIndex, f.Offset, Size);
+    f.Offset += Size;
+    f.Size -= Size;
+    if (f.Size == 0)
+        b.Free.erase(b.Free.begin( ) + FreeIndex);
+    b.Used += Size;
+    b.Ranges += 1;
+}
+
+bool GeometryHeap::Allocate(VkDeviceSize Size, HeapRange& Range)
+{
+    Size = AlignSize(Size);
+    uint32_t BestBlock = 0;
+    size_t BestRange = 0;
+    if (!FindFree(Size, UINT32_MAX, BestBlock, BestRange)) {
+        if (!AddBlock(Size, BestBlock))
+            return false;
+        BestRange = 0;
+    }
+    Take(BestBlock, BestRange, Size, Range);
+    return true;
+}
+
+bool GeometryHeap::AllocateElsewhere(VkDeviceSize Size, uint32_t Excluded, HeapRange& Range)
+{
+    Size = AlignSize(Size);
+    uint32_t BestBlock = 0;
+    size_t BestRange = 0;
+    if (!FindFree(Size, Excluded, BestBlock, BestRange))
+        return false;
+    Take(BestBlock, BestRange, Size, Range);
+    return true;
+}
+
+void GeometryHeap::Free(const HeapRange& Range)
+{
+    if (Range.Size == 0 || Range.Block >= Blocks.size( ) || Blocks[Range.Block].Memory.Handle == VK_NULL_HANDLE)
+        return;
+    Block& b = Blocks[Range.Block];
+    VkDeviceSize Size = AlignSize(Range.Size);
+
+    auto Next = std::lower_bound(b.Free.begin( ), b.Free.end( ), Range.Offset,
+                                 [](const FreeRange& f, VkDeviceSize Offset) { return f.Offset < Offset; });
+    auto Inserted = b.Free.insert(Next, FreeRange{Range.Offset, Size});
+    // Merge with the following range, then with the previous one.
+    auto After = Inserted + 1;
+    if (After != b.Free.end( ) && Inserted->Offset + Inserted->Size == After->Offset) {
+        Inserted->Size += After->Size;
+        b.Free.erase(After);
+    }
+    if (Inserted != b.Free.begin( )) {
+        auto Before = Inserted - 1;
+        if (Before->Offset + Before->Size == Inserted->Offset) {
+            Before->Size += Inserted->Size;
+            b.Free.erase(Inserted);
+        }
+    }
+    b.Used -= Size;
+    b.Ranges -= 1;
+
+    if (b.Ranges != 0)
+        return;
+    size_t LiveBlocks = 0;
+    for (const auto& Other : Blocks)
+        LiveBlocks += (Other.Memory.Handle != VK_NULL_HANDLE) ? 1 : 0;
+    if (LiveBlocks > 1) {
+        DestroyBuffer(GetAllocator( ), b.Memory);
+        b = Block( );
+    }
+}
+
+bool GeometryHeap::FindSparsestBlock(uint32_t& Sparsest) const
+{
+    VkDeviceSize Free = 0;
+    size_t LiveBlocks = 0;
+    for (const auto& b : Blocks) {
+        if (b.Memory.Handle == VK_NULL_HANDLE)
+            continue;
+        Free += b.Size - b.Used;
+        LiveBlocks++;
+    }
+    if (LiveBlocks < 2)
+        return false;
+    bool Found = false;
+    float BestUse = 1.f;
+    for (uint32_t i = 0; i < Blocks.size( ); ++i) {
+        const Block& b = Blocks[i];
+        if (b.Memory.Handle == VK_NULL_HANDLE)
+            continue;
+        float Use = (float)b.Used / (float)b.Size;
+        // The other blocks must have room for its ranges, assuming they don't fragment it further.
+        if (b.Used <= Free - (b.Size - b.Used) && Use < BestUse) {
+            Sparsest = i;
+            BestUse = Use;
+            Found = true;
+        }
+    }
+    return Found;
+}
+
+VkBuffer GeometryHeap::GetBuffer(uint32_t Block) const
+{
+    return (Block < Blocks.size( )) ? Blocks[Block].Memory.Handle : VK_NULL_HANDLE;
+}
+
+GeometryHeapStats GeometryHeap::GetStats( ) const
+{
+    GeometryHeapStats s;
+    for (const auto& b : Blocks) {
+        if (b.Memory.Handle == VK_NULL_HANDLE)
+            continue;
+        s.Blocks += 1;
+        s.Ranges += b.Ranges;
+        s.FreeRanges += b.Free.size( );
+        s.Reserved += b.Size;
+        s.Used += b.Used;
+        for (const auto& f : b.Free)
+            s.LargestFree = std::max(s.LargestFree, f.Size);
+    }
+    return s;
+}
+
+void GeometryHeap::Destroy( )
+{
+    for (auto& b : Blocks)
+        DestroyBuffer(GetAllocator( ), b.Memory);
+    Blocks.clear( );
+}
+
+}    // namespace Vulkan
+}    // namespace ffGraph
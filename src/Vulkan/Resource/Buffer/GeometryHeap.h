@@ -0,0 +1,111 @@
+/**
+ * @file GeometryHeap.h
+ * @brief Vertex storage carved out of a few large buffers, so adding or removing a geometry only touches
+ * its own range.
+ */
+#ifndef GEOMETRY_HEAP_H_
+#define GEOMETRY_HEAP_H_
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "Buffer.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+struct HeapRange {
+    uint32_t Block = 0;
+    VkDeviceSize Offset = 0;
+    VkDeviceSize Size = 0;
+
+    HeapRange( ) {}
+    HeapRange(uint32_t pBlock, VkDeviceSize pOffset, VkDeviceSize pSize) : Block(pBlock), Offset(pOffset), Size(pSize) {}
+};
+
+struct GeometryHeapStats {
+    size_t Blocks = 0;
+    size_t Ranges = 0;
+    size_t FreeRanges = 0;
+    VkDeviceSize Reserved = 0;
+    VkDeviceSize Used = 0;
+    VkDeviceSize LargestFree = 0;
+
+    /**
+     * @return float - Share of the free space outside of the largest free range, 0 when it is in one piece.
+     */
+    float Fragmentation( ) const {
+        VkDeviceSize Free = Reserved - Used;
+        return (Free == 0) ? 0.f : 1.f - (float)LargestFree / (float)Free;
+    }
+};
+
+/**
+ * @brief Free-list allocator over device local vertex buffers, written through the transfer queue (see
+ * ffGraph::Vulkan::SubmitUploads). Ranges are taken best-fit among the free ranges of every block, freed
+ * ranges are merged with their neighbours, and the heap grows by adding a block (never by reallocating
+ * one). Blocks left empty are destroyed, except the last one.
+ *
+ * Freeing a range doesn't wait for the GPU, the caller defers it first (see ffGraph::Vulkan::DeletionQueue).
+ */
+class GeometryHeap {
+   public:
+    static constexpr VkDeviceSize DefaultBlockSize = 64ull * 1024ull * 1024ull;
+    static constexpr VkDeviceSize Alignment = 16;
+
+    /**
+     * @brief Find (or make room for) Size bytes.
+     *
+     * @return bool - false if a new block was needed and couldn't be created.
+     */
+    bool Allocate(VkDeviceSize Size, HeapRange& Range);
+    /**
+     * @brief Find Size bytes in the free ranges of the blocks other than Block, without adding one.
+     */
+    bool AllocateElsewhere(VkDeviceSize Size, uint32_t Block, HeapRange& Range);
+    void Free(const HeapRange& Range);
+    /**
+     * @brief Find the least used block whose ranges all fit in the free space of the other ones.
+     *
+     * @return bool - false if there is a single block, or if no block can be emptied that way.
+     */
+    bool FindSparsestBlock(uint32_t& Block) const;
+
+    VkBuffer GetBuffer(uint32_t Block) const;
+
+    GeometryHeapStats GetStats( ) const;
+    void Destroy( );
+
+    // @brief Size of the blocks added when the heap is full, a larger geometry gets a block of its own size.
+    VkDeviceSize BlockSize = DefaultBlockSize;
+
+   private:
+    struct FreeRange {
+        VkDeviceSize Offset;
+        VkDeviceSize Size;
+    };
+    struct Block {
+        Buffer Memory;
+        VkDeviceSize Size = 0;
+        VkDeviceSize Used = 0;
+        size_t Ranges = 0;
+        // @brief Sorted by offset, never two adjacent ones.
+        std::vector<FreeRange> Free;
+    };
+
+    bool AddBlock(VkDeviceSize MinSize, uint32_t& Index);
+    /**
+     * @brief Best-fit free range of Size bytes outside of Excluded.
+     *
+     * @return bool - false if none is large enough.
+     */
+    bool FindFree(VkDeviceSize Size, uint32_t Excluded, uint32_t& BestBlock, size_t& BestRange) const;
+    void Take(uint32_t Block, size_t FreeIndex, VkDeviceSize Size, HeapRange& Range);
+
+    std::vector<Block> Blocks;
+};
+
+}    // namespace Vulkan
+}    // namespace ffGraph
+
+#endif    // GEOMETRY_HEAP_H_
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include "StagingRing.h"
+#include "GlobalEnvironment.h"
+#include "Logger.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+static VkDeviceSize AlignSize(VkDeviceSize Size)
+{
+    return (Size + StagingRing::Alignment - 1) & ~(StagingRing::Alignment - 1);
+}
+
+bool StagingRing::Create( )
+{
+    BufferCreateInfo CreateInfo = {};
+
+    CreateInfo.vkData.SharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    CreateInfo.vkData.Size = AlignSize(Capacity);
+    CreateInfo.vkData.Usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    CreateInfo.vmaData.Usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    CreateInfo.vmaData.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    Memory = CreateBuffer(GetAllocator( ), CreateInfo);
+    if (Memory.Handle == VK_NULL_HANDLE) {
+        LogWarning("StagingRing", "Couldn't create a %lu bytes staging ring.", (unsigned long)CreateInfo.vkData.Size);
+        return false;
+    }
+    Size = CreateInfo.vkData.Size;
+    Head = Tail = Used = 0;
+    return true;
+}
+
+bool StagingRing::Allocate(VkDeviceSize pSize, uint64_t BatchID, VkDeviceSize& Offset)
+{
+    if (Memory.Handle == VK_NULL_HANDLE && (Capacity == 0 || !Create( )))
+        return false;
+    pSize = AlignSize(pSize);
+    if (pSize > Size)
+        return false;
+    if (Used == 0)
+        Head = Tail = 0;
+
+    VkDeviceSize Start = Head;
+    VkDeviceSize Skipped = 0;
+    if (Used != 0 && Head <= Tail) {
+        // Wrapped around, the free space is between the head and the oldest allocation.
+        if (Tail - Head < pSize)
+            return false;
+    } else if (Size - Head < pSize) {
+        if (Tail < pSize)
+            return false;
+        Skipped = Size - Head;
+        Start = 0;
+    }
+
+    Offset = Start;
+    Head = Start + pSize;
+    Used += Skipped + pSize;
+    PeakUsed = std::max(PeakUsed, Used);
+    if (!Spans.empty( ) && Spans.back( ).BatchID == BatchID) {
+        Spans.back( ).End = Head;
+        Spans.back( ).Bytes += Skipped + pSize;
+    } else {
+        Spans.push_back(Span{BatchID, Head, Skipped + pSize});
+    }
+    return true;
+}
+
+void StagingRing::Release(uint64_t BatchID)
+{
+    while (!Spans.empty( ) && Spans.front( ).BatchID <= BatchID) {
+        Tail = Spans.front( ).End;
+        Used -= Spans.front( ).Bytes;
+        Spans.pop_front( );
+    }
+    if (Used == 0)
+        Head = Tail = 0;
+}
+
+char *StagingRing::Data(VkDeviceSize Offset) const
+{
+    return ((char *)Memory.Infos.pMappedData) + Offset;
+}
+
+StagingRingStats StagingRing::GetStats( ) const
+{
+    StagingRingStats s;
+    s.Capacity = Size;
+    s.Used = Used;
+    s.PeakUsed = PeakUsed;
+    return s;
+}
+
+void StagingRing::Destroy( )
+{
+    DestroyBuffer(GetAllocator( ), Memory);
+    Memory = Buffer( );
+    Spans.clear( );
+    Size = Head = Tail = Used = 0;
+}
+
+}    // namespace Vulkan
+}    // namespace ffGraph
@@ -0,0 +1,77 @@
+/**
+ * @file StagingRing.h
+ * @brief One persistently mapped buffer every upload of a frame is written to, its space is recycled once
+ * the transfer batch reading it is done.
+ */
+#ifndef STAGING_RING_H_
+#define STAGING_RING_H_
+
+#include <cstdint>
+#include <deque>
+#include <vulkan/vulkan.h>
+#include "Buffer.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+struct StagingRingStats {
+    VkDeviceSize Capacity = 0;
+    VkDeviceSize Used = 0;
+    VkDeviceSize PeakUsed = 0;
+};
+
+/**
+ * @brief Ring allocator over a host visible transfer source buffer. Allocations are tagged with the
+ * transfer batch reading them and released in order, a whole batch at a time. An allocation which doesn't
+ * fit before the end of the buffer starts back at its beginning, the skipped bytes go with it.
+ */
+class StagingRing {
+   public:
+    static constexpr VkDeviceSize DefaultCapacity = 32ull * 1024ull * 1024ull;
+    static constexpr VkDeviceSize Alignment = 16;
+
+    /**
+     * @brief Find Size bytes, creating the buffer on first use.
+     *
+     * @param BatchID [in] - Batch reading them, see ffGraph::Vulkan::UploadBatch::ID.
+     * @return bool - false if the ring is full until older batches are released, or if Size is larger than
+     * the whole ring.
+     */
+    bool Allocate(VkDeviceSize Size, uint64_t BatchID, VkDeviceSize& Offset);
+    /**
+     * @brief Give back the space of every batch up to BatchID.
+     */
+    void Release(uint64_t BatchID);
+
+    char *Data(VkDeviceSize Offset) const;
+    VkBuffer GetBuffer( ) const { return Memory.Handle; }
+    StagingRingStats GetStats( ) const;
+    void Destroy( );
+
+    // @brief Size of the buffer, read when it is created.
+    VkDeviceSize Capacity = DefaultCapacity;
+
+   private:
+    struct Span {
+        uint64_t BatchID;
+        // @brief Head of the ring after the last allocation of the batch.
+        VkDeviceSize End;
+        VkDeviceSize Bytes;
+    };
+
+    bool Create( );
+
+    Buffer Memory;
+    VkDeviceSize Size = 0;
+    VkDeviceSize Head = 0;
+    VkDeviceSize Tail = 0;
+    VkDeviceSize Used = 0;
+    VkDeviceSize PeakUsed = 0;
+    // @brief Live allocations, oldest batch first.
+    std::deque<Span> Spans;
+};
+
+}    // namespace Vulkan
+}    // namespace ffGraph
+
+#endif    // STAGING_RING_H_
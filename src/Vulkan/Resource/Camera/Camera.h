@@ -13,7 +13,8 @@ namespace Vulkan {
 
 struct CameraUniform {
     glm::mat4 ViewProj;
-    glm::mat4 Model;
+    // @brief Weight of the colours of the older time step, see ffGraph::Vulkan::SelectColorSteps.
+    float ColorBlend = 0.f;
 };
 
 struct CameraHandle {
@@ -1,6 +1,7 @@
 #include <cstring>
 #include "Image.h"
 #include "Logger.h"
+#include "MemoryTracker.h"
 
 namespace ffGraph {
 namespace Vulkan {
@@ -28,6 +29,7 @@ Image CreateImage(const VmaAllocator& Allocator, const VkDevice& Device, ImageCr
     }
 
     if (vmaCreateImage(Allocator, &vkCreateInfo, &pAllocationInfos, &n.Handle, &n.Memory, &n.AllocationInfos)) return n;
+    MemoryManagement::GetMemoryTracker( ).Add(MemoryManagement::MEMORY_TAG_VMA_IMAGE, n.AllocationInfos.size);
 
     if (pCreateInfo.AsView) {
         VkImageViewCreateInfo ImageViewCreateInfo = {};
@@ -46,6 +48,8 @@ Image CreateImage(const VmaAllocator& Allocator, const VkDevice& Device, ImageCr
 
 void DestroyImage(const VmaAllocator& Allocator, const VkDevice& Device, Image Image) {
     vkDestroyImageView(Device, Image.View, 0);
+    if (Image.Memory != VK_NULL_HANDLE)
+        MemoryManagement::GetMemoryTracker( ).Remove(MemoryManagement::MEMORY_TAG_VMA_IMAGE, Image.AllocationInfos.size);
     vmaDestroyImage(Allocator, Image.Handle, Image.Memory);
 }
 
@@ -0,0 +1,180 @@
+#include <cstring>
+#include <sstream>
+#include <utility>
+#include "SoakTest.h"
+#include "ChunkPool.h"
+#include "GlobalEnvironment.h"
+#include "Logger.h"
+#include "MeditLoader.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+// The replayed plot alternates between two identifiers, each replacement removing the other one.
+static constexpr uint16_t SoakPlotBase = 0xF000;
+// Frames a sample waits for the uploads and deletions to settle before being taken anyway.
+static constexpr uint32_t MaxSettleFrames = 600;
+
+static bool EndsWith(const std::string& s, const char *Suffix)
+{
+    size_t n = strlen(Suffix);
+    return s.size( ) >= n && s.compare(s.size( ) - n, n, Suffix) == 0;
+}
+
+SoakTest::~SoakTest( )
+{
+    if (Loader.joinable( ))
+        Loader.join( );
+}
+
+bool SoakTest::Load(const SoakSettings& pSettings)
+{
+    Settings = pSettings;
+    if (!Enabled( ))
+        return true;
+    if (Settings.Source.empty( )) {
+        LogError("SoakTest", "A soak test replays a file, give one with -File.");
+        Settings.Iterations = 0;
+        return false;
+    }
+    IsMedit = !EndsWith(Settings.Source, ".cbor");
+    if (IsMedit && Settings.MockServer) {
+        LogError("SoakTest", "The mock server sends .cbor messages, %s can't be replayed through it.",
+                 Settings.Source.c_str( ));
+        Settings.Iterations = 0;
+        return false;
+    }
+    if (IsMedit)
+        return true;
+
+    JSON::Payload Message = JSON::Payload::FromFile(Settings.Source);
+    const uint8_t *Bytes = Message.Map( );
+    if (Bytes == nullptr) {
+        LogError("SoakTest", "Failed to read %s.", Settings.Source.c_str( ));
+        Settings.Iterations = 0;
+        return false;
+    }
+    Document = nlohmann::json::from_cbor(Bytes, Bytes + Message.Size( ), true, false);
+    Message.Unmap( );
+    if (Document.is_discarded( ) || !Document.contains("Plot")) {
+        LogError("SoakTest", "%s isn't a plot message.", Settings.Source.c_str( ));
+        Settings.Iterations = 0;
+        return false;
+    }
+    return true;
+}
+
+void SoakTest::Submit(JSON::PayloadQueue& Payloads, JSON::ThreadSafeQueue& Geometries, uint64_t Imported)
+{
+    CurrentPlot = SoakPlotBase + (Completed & 1);
+    Pending = true;
+    if (IsMedit) {
+        LoaderDone = false;
+        uint16_t PlotID = CurrentPlot;
+        Loader = std::thread([this, &Geometries, PlotID]( ) {
+            JSON::LoadMeditFile(Settings.Source, Geometries, PlotID);
+            LoaderDone = true;
+        });
+        return;
+    }
+    Document["Plot"] = CurrentPlot;
+    std::vector<uint8_t> Bytes = nlohmann::json::to_cbor(Document);
+    ExpectedImports = Imported + 1;
+    if (Transport)
+        Transport(std::move(Bytes));
+    else
+        Payloads.Push(JSON::Payload(std::string(Bytes.begin( ), Bytes.end( ))));
+}
+
+/**
+ * @brief Nothing recorded, in flight or waiting to be acquired by the graphic queue, and every deferred
+ * deletion ran : what the replacement freed is really gone.
+ */
+bool SoakTest::Settled(const Root& r) const
+{
+    const UploadQueue& Uploads = r.Uploads;
+    return Uploads.Recording.Copies.empty( ) && Uploads.Submitted.empty( ) && Uploads.Acquiring.empty( ) &&
+           GetDeletionQueue( ).Size( ) == 0;
+}
+
+void SoakTest::Sample(JSON::PayloadQueue& Payloads, JSON::ThreadSafeQueue& Geometries)
+{
+    VmaStats Stats;
+    vmaCalculateStats(GetAllocator( ), &Stats);
+
+    SoakSample s;
+    s.Values[SOAK_METRIC_RSS] = (double)ReadResidentBytes( );
+    s.Values[SOAK_METRIC_ARENA] = (double)MemoryManagement::GetChunkPool( ).GetStats( ).Live;
+    s.Values[SOAK_METRIC_VMA] = (double)Stats.total.usedBytes;
+    s.Values[SOAK_METRIC_VMA_ALLOCATIONS] = (double)Stats.total.allocationCount;
+    s.Values[SOAK_METRIC_GEOMETRY_QUEUE] = (double)Geometries.size( );
+    s.Values[SOAK_METRIC_PAYLOAD_QUEUE] = (double)Payloads.Size( );
+    s.Values[SOAK_METRIC_FRAME_TIME] = (FrameCount) ? FrameTimeSum / FrameCount : 0.;
+    Monitor.AddSample(s);
+    FrameTimeSum = 0.;
+    FrameCount = 0;
+}
+
+void SoakTest::Finish( )
+{
+    Done = true;
+    std::string Report;
+    Success = Monitor.Analyze(Settings.Threshold, Report);
+
+    std::istringstream Lines(Report);
+    std::string Line;
+    while (std::getline(Lines, Line)) {
+        if (Success)
+            LogInfo("SoakTest", "%s", Line.c_str( ));
+        else
+            LogError("SoakTest", "%s", Line.c_str( ));
+    }
+    if (!Monitor.WriteSamples(Settings.SamplesPath))
+        LogWarning("SoakTest", "Failed to write the samples to %s.", Settings.SamplesPath.c_str( ));
+}
+
+void SoakTest::Update(Root& r, JSON::PayloadQueue& Payloads, JSON::ThreadSafeQueue& Geometries, uint64_t Imported,
+                      double FrameMs)
+{
+    if (!Enabled( ) || Done)
+        return;
+    FrameTimeSum += FrameMs;
+    FrameCount++;
+
+    if (Pending) {
+        bool Decoded = (IsMedit) ? LoaderDone.load( ) : Imported >= ExpectedImports;
+        if (!Decoded || !Geometries.empty( ) || !Payloads.Empty( ))
+            return;
+        if (Loader.joinable( ))
+            Loader.join( );
+        Pending = false;
+
+        uint16_t Replaced = SoakPlotBase + ((Completed + 1) & 1);
+        for (const auto& g : r.Geometries) {
+            if (g.PlotID == Replaced) {
+                RemovePlot(r, Replaced);
+                break;
+            }
+        }
+        Settling = true;
+        SettleFrames = 0;
+        return;
+    }
+    if (Settling) {
+        if (!Settled(r) && ++SettleFrames < MaxSettleFrames)
+            return;
+        if (SettleFrames >= MaxSettleFrames)
+            LogWarning("SoakTest", "Replacement %u didn't settle in %u frames, sampled anyway.", Completed,
+                       MaxSettleFrames);
+        Settling = false;
+        Sample(Payloads, Geometries);
+        if (++Completed == Settings.Iterations) {
+            Finish( );
+            return;
+        }
+    }
+    Submit(Payloads, Geometries, Imported);
+}
+
+}    // namespace Vulkan
+}    // namespace ffGraph
@@ -0,0 +1,107 @@
+#ifndef SOAK_TEST_H_
+#define SOAK_TEST_H_
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "Graph/Root.h"
+#include "Payload.h"
+#include "SoakMonitor.h"
+#include "ThreadQueue.h"
+
+namespace ffGraph {
+namespace Vulkan {
+
+struct SoakSettings {
+    // @brief Number of plot replacements, 0 disables the soak test.
+    uint32_t Iterations = 0;
+    // @brief Largest accepted growth of a metric over the test, relative to its value after the warm-up.
+    float Threshold = 0.05f;
+    // @brief .cbor message or .mesh/.sol file replayed as the plot.
+    std::string Source;
+    // @brief CSV file receiving every sample.
+    std::string SamplesPath = "ffGraph_soak.csv";
+    // @brief The .cbor message is sent by a ffGraph::MockServer and received by the client, instead of being
+    // pushed to the payload queue.
+    bool MockServer = false;
+};
+
+/**
+ * @brief Replays the same plot over and over, replacing the previous one each time, and samples the memory,
+ * GPU allocations, queue depths and frame times after every replacement, once its uploads are done and the
+ * deletions it deferred have run. Driven from the render loop, one replacement in flight at a time.
+ */
+class SoakTest {
+   public:
+    SoakTest( ) {}
+    ~SoakTest( );
+
+    SoakTest(const SoakTest&) = delete;
+    SoakTest& operator=(const SoakTest&) = delete;
+
+    /**
+     * @brief Read the replayed message (a .mesh/.sol file is read again on every replacement).
+     *
+     * @return bool - false if the source couldn't be loaded.
+     */
+    bool Load(const SoakSettings& pSettings);
+
+    /**
+     * @brief Messages are given to Send instead of the payload queue, see SoakSettings::MockServer.
+     */
+    void SetTransport(std::function<void(std::vector<uint8_t>)> Send) { Transport = Send; }
+
+    /**
+     * @brief Called once per frame : once every geometry of the replacement in flight reached the graph,
+     * removes the replaced plot, waits for the uploads and deferred deletions to settle, samples, and submits
+     * the next one.
+     *
+     * @param r [in] - Render graph, from which the replaced plot is removed.
+     * @param Payloads [in] - Queue receiving the replayed messages.
+     * @param Geometries [in] - Queue of the geometries waiting for the render loop.
+     * @param Imported [in] - Number of messages the import thread finished decoding.
+     * @param FrameMs [in] - Duration of the previous frame.
+     */
+    void Update(Root& r, JSON::PayloadQueue& Payloads, JSON::ThreadSafeQueue& Geometries, uint64_t Imported,
+                double FrameMs);
+
+    bool Enabled( ) const { return Settings.Iterations != 0; }
+    bool Finished( ) const { return Done; }
+    bool Passed( ) const { return Success; }
+    bool UsesMockServer( ) const { return Settings.MockServer; }
+
+   private:
+    void Submit(JSON::PayloadQueue& Payloads, JSON::ThreadSafeQueue& Geometries, uint64_t Imported);
+    void Sample(JSON::PayloadQueue& Payloads, JSON::ThreadSafeQueue& Geometries);
+    void Finish( );
+    bool Settled(const Root& r) const;
+
+    SoakSettings Settings;
+    SoakMonitor Monitor;
+    bool IsMedit = false;
+    nlohmann::json Document;
+
+    uint32_t Completed = 0;
+    bool Pending = false;
+    // @brief The replaced plot was removed, the sample waits for the GPU side to catch up.
+    bool Settling = false;
+    uint32_t SettleFrames = 0;
+    uint16_t CurrentPlot = 0;
+    uint64_t ExpectedImports = 0;
+    std::thread Loader;
+    std::atomic<bool> LoaderDone{false};
+    std::function<void(std::vector<uint8_t>)> Transport;
+
+    double FrameTimeSum = 0.;
+    uint32_t FrameCount = 0;
+    bool Done = false;
+    bool Success = true;
+};
+
+}    // namespace Vulkan
+}    // namespace ffGraph
+
+#endif    // SOAK_TEST_H_
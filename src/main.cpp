@@ -1,9 +1,18 @@
+#include <algorithm>
 #include <cstring>
 #include "App.h"
+#include "Import.h"
+#include "MeditLoader.h"
+#include "MockServer.h"
 #include "LinearAlloc.h"
+#include "Logger.h"
 
 ffGraph::ffAppCreateInfos ffGraph::ffGetAppCreateInfos(int ac, char** av) {
-    ffAppCreateInfos Infos = {"localhost", "12345", 1280, 768};
+    ffAppCreateInfos Infos = {"localhost", "12345", 1280, 768, false, 0.f, ffGraph::JSON::SpillSettings( ), "",
+                              ffGraph::JSON::HostResidencySettings( ), ffGraph::MemoryManagement::CHUNK_BACKEND_MALLOC, 0, "",
+                              ffGraph::Vulkan::SoakSettings( ), 0, 0, ffGraph::Vulkan::StagingRing::DefaultCapacity,
+                              ffGraph::Vulkan::HeapCompaction::DefaultThreshold, ffGraph::Vulkan::TimeSeries::DefaultSteps,
+                              ffGraph::Vulkan::TimeSeries::DefaultBudget};
 
     if (ac < 2)
         return Infos;
@@ -19,6 +28,51 @@ ffGraph::ffAppCreateInfos ffGraph::ffGetAppCreateInfos(int ac, char** av) {
                 Infos.width = atoi(av[i + 1]);
             } else if (strcmp(av[i], "-ScreenHeight") == 0) {
                 Infos.height = atoi(av[i + 1]);
+            } else if (strcmp(av[i], "-OptimizeMesh") == 0) {
+                Infos.OptimizeMesh = true;
+            } else if (strcmp(av[i], "-ClipPercentile") == 0) {
+                Infos.ClipPercentile = (float)atof(av[i + 1]);
+            } else if (strcmp(av[i], "-File") == 0) {
+                Infos.File.clear( );
+                Infos.File.append(av[i + 1]);
+            } else if (strcmp(av[i], "-SpillThreshold") == 0) {
+                Infos.Spill.MessageThreshold = (size_t)atoll(av[i + 1]) * 1024 * 1024;
+            } else if (strcmp(av[i], "-SpillBacklog") == 0) {
+                Infos.Spill.BacklogThreshold = (size_t)atoll(av[i + 1]) * 1024 * 1024;
+            } else if (strcmp(av[i], "-HostResidency") == 0) {
+                if (!ffGraph::JSON::ParseHostResidencyPolicy(av[i + 1], Infos.Residency.Policy))
+                    LogWarning("ffGetAppCreateInfos", "Unknown host residency policy %s (keep, release or compressed).", av[i + 1]);
+            } else if (strcmp(av[i], "-HostBudget") == 0) {
+                Infos.Residency.Budget = (size_t)atoll(av[i + 1]) * 1024 * 1024;
+            } else if (strcmp(av[i], "-Arena") == 0) {
+                if (!ffGraph::MemoryManagement::ParseChunkBackend(av[i + 1], Infos.Arena))
+                    LogWarning("ffGetAppCreateInfos", "Unknown arena backend %s (malloc, mmap, thp or hugetlb).", av[i + 1]);
+            } else if (strcmp(av[i], "-Prefault") == 0) {
+                Infos.Prefault = (size_t)atoll(av[i + 1]) * 1024 * 1024;
+            } else if (strcmp(av[i], "-MemoryDump") == 0) {
+                Infos.MemoryDump.clear( );
+                Infos.MemoryDump.append(av[i + 1]);
+            } else if (strcmp(av[i], "-Soak") == 0) {
+                Infos.Soak.Iterations = (uint32_t)atoi(av[i + 1]);
+            } else if (strcmp(av[i], "-SoakThreshold") == 0) {
+                Infos.Soak.Threshold = (float)atof(av[i + 1]) / 100.f;
+            } else if (strcmp(av[i], "-SoakServer") == 0) {
+                Infos.Soak.MockServer = true;
+            } else if (strcmp(av[i], "-SoakSamples") == 0) {
+                Infos.Soak.SamplesPath.clear( );
+                Infos.Soak.SamplesPath.append(av[i + 1]);
+            } else if (strcmp(av[i], "-KeepPlots") == 0) {
+                Infos.KeepPlots = (uint32_t)atoi(av[i + 1]);
+            } else if (strcmp(av[i], "-VramBudget") == 0) {
+                Infos.VramBudget = (size_t)atoll(av[i + 1]) * 1024 * 1024;
+            } else if (strcmp(av[i], "-StagingSize") == 0) {
+                Infos.StagingSize = (size_t)atoll(av[i + 1]) * 1024 * 1024;
+            } else if (strcmp(av[i], "-CompactionThreshold") == 0) {
+                Infos.CompactionThreshold = (float)atof(av[i + 1]) / 100.f;
+            } else if (strcmp(av[i], "-TimeSteps") == 0) {
+                Infos.TimeSteps = (uint32_t)std::max(atoi(av[i + 1]), 1);
+            } else if (strcmp(av[i], "-TimeBudget") == 0) {
+                Infos.TimeBudget = (size_t)atoll(av[i + 1]) * 1024 * 1024;
             }
         }
     }
@@ -27,10 +81,25 @@ ffGraph::ffAppCreateInfos ffGraph::ffGetAppCreateInfos(int ac, char** av) {
 
 namespace ffGraph {
 
-bool ffAppInitialize(ffAppCreateInfos pCreateInfos, std::shared_ptr<std::deque<std::string>>& SharedQueue, ffApp& App) {
+bool ffAppInitialize(ffAppCreateInfos pCreateInfos, std::shared_ptr<JSON::PayloadQueue>& SharedQueue, ffApp& App) {
     App.SharedQueue = SharedQueue;
+    App.SharedQueue->Settings = pCreateInfos.Spill;
+    JSON::GImportSettings.OptimizeMeshes = pCreateInfos.OptimizeMesh;
+    JSON::GImportSettings.ClipPercentile = pCreateInfos.ClipPercentile;
+    JSON::GHostResidency = pCreateInfos.Residency;
+    MemoryManagement::GetChunkPool( ).SetBackend(pCreateInfos.Arena);
+    MemoryManagement::GetChunkPool( ).StartPrefault(pCreateInfos.Prefault);
+    if (!pCreateInfos.MemoryDump.empty( ))
+        MemoryManagement::GetMemoryTracker( ).SetDumpPath(pCreateInfos.MemoryDump);
     App.vkInstance.load("FreeFem", pCreateInfos.width, pCreateInfos.height);
-    return true;
+    App.vkInstance.RenderGraph.KeepPlots = pCreateInfos.KeepPlots;
+    App.vkInstance.RenderGraph.Residency.Budget = pCreateInfos.VramBudget;
+    App.vkInstance.RenderGraph.Uploads.Ring.Capacity = pCreateInfos.StagingSize;
+    App.vkInstance.RenderGraph.Compaction.Threshold = pCreateInfos.CompactionThreshold;
+    App.vkInstance.RenderGraph.Series.Steps = pCreateInfos.TimeSteps;
+    App.vkInstance.RenderGraph.Series.Budget = pCreateInfos.TimeBudget;
+    pCreateInfos.Soak.Source = pCreateInfos.File;
+    return App.vkInstance.Soak.Load(pCreateInfos.Soak);
 }
 
 void ffAppRun(ffApp& App) { App.vkInstance.run(App.SharedQueue, App.GeometryQueue); }
@@ -38,20 +107,55 @@ void ffAppRun(ffApp& App) { App.vkInstance.run(App.SharedQueue, App.GeometryQueu
 }    // namespace ffGraph
 
 int main(int ac, char** av) {
-    ffGraph::MemoryManagement::LinearAllocator Allocator(500000000);
+    ffGraph::MemoryManagement::LinearAllocator Allocator;
     ffGraph::MemoryManagement::GAlloc = &Allocator;
     ffGraph::ffAppCreateInfos AppCreateInfos = ffGraph::ffGetAppCreateInfos(ac, av);
     ffGraph::ffApp App;
-    std::shared_ptr<std::deque<std::string>> SharedQueue = std::make_shared<std::deque<std::string>>( );
-    ffGraph::ffAppInitialize(AppCreateInfos, SharedQueue, App);
+    std::shared_ptr<ffGraph::JSON::PayloadQueue> SharedQueue = std::make_shared<ffGraph::JSON::PayloadQueue>( );
+    if (!ffGraph::ffAppInitialize(AppCreateInfos, SharedQueue, App)) {
+        App.vkInstance.destroy( );
+        return 1;
+    }
+    // A soak test through the mock server has the client connect to it, like it would to FreeFEM.
+    std::unique_ptr<ffGraph::MockServer> Server;
+    if (App.vkInstance.Soak.Enabled( ) && App.vkInstance.Soak.UsesMockServer( )) {
+        Server.reset(new ffGraph::MockServer(AppCreateInfos.Port));
+        if (!Server->Start( )) {
+            ffGraph::LogWarning("main", "The soak test mock server couldn't listen on port %s.", AppCreateInfos.Port.c_str( ));
+            App.vkInstance.destroy( );
+            return 1;
+        }
+        AppCreateInfos.Host = "127.0.0.1";
+        ffGraph::MockServer *Mock = Server.get( );
+        App.vkInstance.Soak.SetTransport([Mock](std::vector<uint8_t> Message) { Mock->Send(std::move(Message)); });
+    }
     ffGraph::ffClient Client(AppCreateInfos.Host, AppCreateInfos.Port, App.SharedQueue);
 
     App.ClientThread = std::thread([&Client]( ) { Client.Start( ); });
+    // A soak test replays the file itself.
+    const std::string& File = AppCreateInfos.File;
+    if (!File.empty( ) && !App.vkInstance.Soak.Enabled( )) {
+        if (File.size( ) > 5 && File.compare(File.size( ) - 5, 5, ".cbor") == 0) {
+            App.SharedQueue->Push(ffGraph::JSON::Payload::FromFile(File));
+        } else {
+            App.LoaderThread = std::thread([&App, &AppCreateInfos]( ) {
+                ffGraph::JSON::LoadMeditFile(AppCreateInfos.File, App.GeometryQueue, App.GeometryInternID);
+            });
+        }
+    }
     ffGraph::ffAppRun(App);
+    if (!AppCreateInfos.MemoryDump.empty( ) && !ffGraph::MemoryManagement::GetMemoryTracker( ).DumpJSON(AppCreateInfos.MemoryDump))
+        ffGraph::LogWarning("main", "Failed to write the memory dump %s.", AppCreateInfos.MemoryDump.c_str( ));
 
     Client.Stop( );
+    if (Server)
+        Server->Stop( );
     App.vkInstance.destroy( );
     App.ClientThread.join( );
+    if (App.LoaderThread.joinable( ))
+        App.LoaderThread.join( );
+    if (App.vkInstance.Soak.Enabled( ))
+        return (App.vkInstance.Soak.Finished( ) && App.vkInstance.Soak.Passed( )) ? 0 : 1;
     return 0;
 }
 
@@ -0,0 +1,116 @@
+#include "MockServer.h"
+#include <asio/write.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "Logger.h"
+
+namespace ffGraph {
+
+MockServer::MockServer(std::string pPort, size_t pPacketSize)
+    : Port(pPort), PacketSize(std::max(pPacketSize, (size_t)1)), Acceptor(IoContext), Socket(IoContext) {}
+
+MockServer::~MockServer( ) { Stop( ); }
+
+bool MockServer::Start( ) {
+    std::error_code Error;
+    tcp::endpoint EndPoint(tcp::v4( ), (unsigned short)atoi(Port.c_str( )));
+    Acceptor.open(EndPoint.protocol( ), Error);
+    if (!Error) Acceptor.set_option(tcp::acceptor::reuse_address(true), Error);
+    if (!Error) Acceptor.bind(EndPoint, Error);
+    if (!Error) Acceptor.listen(1, Error);
+    if (!Error) ListenPort = Acceptor.local_endpoint(Error).port( );
+    if (Error) {
+        LogWarning("MockServer", "Failed to listen on port %s : %s.", Port.c_str( ), Error.message( ).c_str( ));
+        return false;
+    }
+    Thread = std::thread(&MockServer::Run, this);
+    return true;
+}
+
+void MockServer::Send(std::vector<uint8_t> Message) {
+    std::lock_guard<std::mutex> Guard(Lock);
+    if (Stopped) return;
+    Messages.push_back(std::move(Message));
+    Ready.notify_one( );
+}
+
+void MockServer::Stop( ) {
+    bool WakeAccept;
+    {
+        std::lock_guard<std::mutex> Guard(Lock);
+        if (Stopped && !Thread.joinable( )) return;
+        Stopped = true;
+        Messages.clear( );
+        WakeAccept = !Connected;
+        Ready.notify_one( );
+    }
+    // A blocking accept isn't woken by closing the acceptor from another thread, a connection is.
+    if (WakeAccept && Thread.joinable( )) {
+        asio::io_context Context;
+        tcp::socket Waker(Context);
+        std::error_code Ignored;
+        Waker.connect(tcp::endpoint(asio::ip::address_v4::loopback( ), ListenPort), Ignored);
+    }
+    if (Thread.joinable( )) Thread.join( );
+    std::error_code Ignored;
+    Socket.close(Ignored);
+    Acceptor.close(Ignored);
+}
+
+void MockServer::Run( ) {
+    std::error_code Error;
+    Acceptor.accept(Socket, Error);
+    {
+        std::lock_guard<std::mutex> Guard(Lock);
+        if (Error || Stopped) {
+            if (Error) LogWarning("MockServer", "Failed to accept the client : %s.", Error.message( ).c_str( ));
+            return;
+        }
+        Connected = true;
+    }
+    // The client's heartbeats are never read, a byte every few seconds doesn't fill the socket buffer.
+    while (true) {
+        std::vector<uint8_t> Message;
+        {
+            std::unique_lock<std::mutex> Guard(Lock);
+            Ready.wait(Guard, [this]( ) { return Stopped || !Messages.empty( ); });
+            if (Stopped) return;
+            Message = std::move(Messages.front( ));
+            Messages.pop_front( );
+        }
+        if (!SendMessage(Message)) return;
+    }
+}
+
+bool MockServer::SendMessage(const std::vector<uint8_t>& Message) {
+    size_t Packets = std::max((Message.size( ) + PacketSize - 1) / PacketSize, (size_t)1);
+    uint32_t ID = MessageID++;
+
+    for (size_t i = 0; i < Packets; ++i) {
+        size_t Offset = i * PacketSize;
+        size_t Size = std::min(PacketSize, Message.size( ) - Offset);
+        // The client parses the first 63 bytes of the header as JSON, the padding is whitespace.
+        char Header[64];
+        memset(Header, ' ', sizeof(Header));
+        int Length = snprintf(Header, sizeof(Header), "{\"Size\":%zu,\"MaxPacket\":%zu,\"IDs\":[%u,%zu]}", Size,
+                              Packets - 1, ID, i);
+        if (Length < 0 || Length >= 63) {
+            LogWarning("MockServer", "Message %u doesn't fit the packet header.", ID);
+            return false;
+        }
+        Header[Length] = ' ';
+
+        std::error_code Error;
+        asio::write(Socket, asio::buffer(Header, sizeof(Header)), Error);
+        if (!Error && Size != 0) asio::write(Socket, asio::buffer(Message.data( ) + Offset, Size), Error);
+        if (Error) {
+            LogWarning("MockServer", "Failed to send message %u : %s.", ID, Error.message( ).c_str( ));
+            return false;
+        }
+    }
+    return true;
+}
+
+}    // namespace ffGraph
@@ -0,0 +1,81 @@
+/**
+ * @file MockServer.h
+ * @brief Local stand-in for the FreeFEM server, sending messages to the ffGraph::ffClient the way FreeFEM does.
+ */
+#ifndef MOCK_SERVER_H_
+#define MOCK_SERVER_H_
+
+#include <asio/io_context.hpp>
+#include <asio/ip/tcp.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ffGraph {
+
+using asio::ip::tcp;
+
+/**
+ * @brief Listens on a local port, accepts a single client and sends it every message given to Send, cut in
+ * packets behind the 64 bytes header read by ffGraph::ffClient::HandleRead.
+ */
+class MockServer {
+   public:
+    static constexpr size_t DefaultPacketSize = 1 << 20;
+
+    /**
+     * @brief Constructor
+     *
+     * @param Port [in] - Local port listened on, the client must connect to it.
+     * @param PacketSize [in] - Largest packet a message is cut in.
+     */
+    explicit MockServer(std::string Port, size_t PacketSize = DefaultPacketSize);
+    ~MockServer( );
+
+    MockServer(const MockServer&) = delete;
+    MockServer& operator=(const MockServer&) = delete;
+
+    /**
+     * @brief Bind the port and wait for the client on a thread of its own.
+     *
+     * @return bool - false if the port couldn't be listened on.
+     */
+    bool Start( );
+
+    /**
+     * @brief Queue a message, it is sent once the client is connected and every earlier message was sent.
+     */
+    void Send(std::vector<uint8_t> Message);
+
+    /**
+     * @brief Stop sending and close the connection, queued messages are dropped.
+     */
+    void Stop( );
+
+   private:
+    void Run( );
+    bool SendMessage(const std::vector<uint8_t>& Message);
+
+    std::string Port;
+    size_t PacketSize;
+    unsigned short ListenPort = 0;
+    asio::io_context IoContext;
+    tcp::acceptor Acceptor;
+    tcp::socket Socket;
+    std::thread Thread;
+
+    std::mutex Lock;
+    std::condition_variable Ready;
+    std::deque<std::vector<uint8_t>> Messages;
+    bool Stopped = false;
+    bool Connected = false;
+    uint32_t MessageID = 0;
+};
+
+}    // namespace ffGraph
+
+#endif    // MOCK_SERVER_H_
@@ -3,8 +3,9 @@
 
 namespace ffGraph {
 
-ffClient::ffClient(std::string Host, std::string Port, std::shared_ptr<std::deque<std::string>>& SharedQueue)
-    : Resolver(IoContext), Socket(IoContext), Deadline(IoContext), HeartBeat(IoContext), SharedDataQueue(SharedQueue) {
+ffClient::ffClient(std::string Host, std::string Port, std::shared_ptr<JSON::PayloadQueue>& SharedQueue)
+    : Resolver(IoContext), Socket(IoContext), SharedDataQueue(SharedQueue), OutputBuffer(*SharedQueue),
+      Deadline(IoContext), HeartBeat(IoContext) {
     Endpoints = Resolver.resolve(Host, Port);
 }
 
@@ -64,21 +65,15 @@ void ffClient::HandleRead(const std::error_code& Error, std::size_t n) {
         auto j = json::parse(line);
         size_t ReadSize = j["Size"];
 
+        // The packet is read straight at the end of the message, it is never copied on the client side.
         std::error_code err;
-        asio::read(Socket, asio::dynamic_buffer(InputBuffer, ReadSize), asio::transfer_exactly(ReadSize), err);
+        char *Destination = OutputBuffer.Reserve(ReadSize);
+        size_t Received = asio::read(Socket, asio::buffer(Destination, ReadSize), asio::transfer_exactly(ReadSize), err);
+        OutputBuffer.Commit((err) ? 0 : Received);
         if (err)
             StartRead( );
-        else {
-            if (j["MaxPacket"].get<uint32_t>() != j["IDs"][1].get<uint32_t>()) {
-                OutputBuffer.append(InputBuffer.substr(0, ReadSize));
-                InputBuffer.erase(0, ReadSize);
-            } else {
-                OutputBuffer.append(InputBuffer.substr(0, ReadSize));
-                InputBuffer.erase(0, ReadSize);
-                SharedDataQueue->push_back(OutputBuffer);
-                OutputBuffer.clear();
-            }
-        }
+        else if (j["MaxPacket"].get<uint32_t>() == j["IDs"][1].get<uint32_t>())
+            OutputBuffer.Submit();
     }
     StartRead( );
 }
@@ -16,6 +16,7 @@
 #include <iostream>
 #include <string>
 #include <deque>
+#include "Payload.h"
 
 namespace ffGraph {
 
@@ -33,9 +34,9 @@ class ffClient {
      * @param Hosts [in] - Server's address.
      * @param Port [in] - Server's port.
      * @param SharedQueue [in] - Thread safe queue, used by the ffGraph::ffClient to post data for the
-     * ffGraph::ResourceManager.
+     * ffGraph::ResourceManager. Large messages are spilled to disk following its settings.
      */
-    ffClient(std::string Host, std::string Port, std::shared_ptr<std::deque<std::string>>& SharedQueue);
+    ffClient(std::string Host, std::string Port, std::shared_ptr<JSON::PayloadQueue>& SharedQueue);
 
     /**
      * @brief Start the ffGraph::ffClient.
@@ -118,10 +119,10 @@ class ffClient {
     tcp::resolver::results_type Endpoints;
     tcp::socket Socket;
     std::string InputBuffer;
-    std::string OutputBuffer;
+    std::shared_ptr<JSON::PayloadQueue> SharedDataQueue;
+    JSON::PayloadBuilder OutputBuffer;
     steady_timer Deadline;
     steady_timer HeartBeat;
-    std::shared_ptr<std::deque<std::string>> SharedDataQueue;
 };
 
 }    // namespace ffGraph
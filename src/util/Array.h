@@ -5,12 +5,19 @@
 #ifndef ARRAY_H_
 #define ARRAY_H_
 
+#include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include "LinearAlloc.h"
+#include "Parallel.h"
 
 namespace ffGraph {
 
+/**
+ * @brief Alignment of every ffGraph::Array allocation, one cache line (large enough for AVX-512 loads).
+ */
+constexpr size_t ArrayAlignment = 64;
+
 /**
  * @brief Simple array struct.
  */
@@ -38,10 +45,16 @@ inline bool isArrayReady(Array a) { return (a.Data) ? true : false; }
  * @param ElementCount [in] - Number of elements in the Array.
  * @param ElementSize [in] - Size of one element (eg. sizeof(int)).
  *
- * @return ffGraph::Array - Allocate a new ffGraph::Array (use ffGraph::isArrayReady to check return value).
+ * @return ffGraph::Array - Allocate a new ffGraph::Array from the arena of the calling thread (see
+ * ffGraph::MemoryManagement::ArenaScope), accounted to its current tag (see
+ * ffGraph::MemoryManagement::MemoryTagScope), use ffGraph::isArrayReady to check return value.
  */
 inline Array ffNewArray(size_t ElementCount, size_t ElementSize) {
-    return {ElementCount, ElementSize, MemoryManagement::GAlloc->Allocate(ElementCount * ElementSize)};
+    MemoryManagement::LinearAllocator *Arena = MemoryManagement::GetCurrentAllocator();
+    void *Data = Arena->Allocate(ElementCount * ElementSize, ArrayAlignment);
+    if (Data)
+        Arena->Track(MemoryManagement::CurrentMemoryTagSlot(), ElementCount * ElementSize);
+    return {ElementCount, ElementSize, Data};
 };
 
 /**
@@ -78,17 +91,137 @@ inline void ffMemcpyArray(Array dst, Array src, size_t size) { memcpy(dst.Data,
  */
 inline void ffMemcpyArray(Array dst, Array src) { memcpy(dst.Data, src.Data, dst.ElementCount * dst.ElementSize); }
 
+/**
+ * @brief Non owning typed view over contiguous memory. Accesses are bounds-checked in debug builds.
+ */
+template <typename T>
+struct ArrayView {
+    // @brief First element.
+    T *Data = nullptr;
+    // @brief Number of elements in the view.
+    size_t Count = 0;
+
+    ArrayView( ) {}
+    ArrayView(T *pData, size_t pCount) : Data(pData), Count(pCount) {}
+
+    inline T& operator[](size_t idx) const {
+#ifdef _DEBUG
+        assert(idx < Count);
+#endif
+        return Data[idx];
+    }
+
+    inline size_t size( ) const { return Count; }
+    inline T *begin( ) const { return Data; }
+    inline T *end( ) const { return Data + Count; }
+
+    /**
+     * @brief Sub-view [Begin, Begin + n).
+     */
+    inline ArrayView<T> Slice(size_t Begin, size_t n) const {
+#ifdef _DEBUG
+        assert(Begin + n <= Count);
+#endif
+        return ArrayView<T>(Data + Begin, n);
+    }
+};
+
+/**
+ * @brief Typed ffGraph::Array, allocated from the global allocator on a ffGraph::ArrayAlignment boundary.
+ */
+template <typename T>
+struct TypedArray {
+    // @brief Number of elements in the Array.
+    size_t ElementCount = 0;
+    // @brief Actual array, aligned on ffGraph::ArrayAlignment.
+    T *Data = nullptr;
+
+    inline T& operator[](size_t idx) const {
+#ifdef _DEBUG
+        assert(idx < ElementCount);
+#endif
+        return Data[idx];
+    }
+
+    inline size_t size( ) const { return ElementCount; }
+    inline ArrayView<T> View( ) const { return ArrayView<T>(Data, ElementCount); }
+
+    /**
+     * @brief Get back the untyped ffGraph::Array, as stored in ffGraph::Geometry.
+     */
+    inline Array Untyped( ) const { return {ElementCount, sizeof(T), (void *)Data}; }
+};
+
+/**
+ * @brief Create a new ffGraph::TypedArray.
+ *
+ * @param ElementCount [in] - Number of elements in the Array.
+ *
+ * @return ffGraph::TypedArray<T> - Data is nullptr if the allocation failed.
+ */
+template <typename T>
+inline TypedArray<T> ffNewTypedArray(size_t ElementCount) {
+    TypedArray<T> n;
+    n.Data = (T *)ffNewArray(ElementCount, sizeof(T)).Data;
+    n.ElementCount = (n.Data) ? ElementCount : 0;
+    return n;
+}
+
+/**
+ * @brief Reinterpret a ffGraph::Array as a typed view.
+ *
+ * @param a [in] - ffGraph::Array, its ElementSize must be sizeof(T).
+ *
+ * @return ffGraph::ArrayView<T>
+ */
+template <typename T>
+inline ArrayView<T> ffArrayView(Array a) {
+#ifdef _DEBUG
+    assert(a.Data == nullptr || a.ElementSize == sizeof(T));
+#endif
+    return ArrayView<T>((T *)a.Data, a.ElementCount);
+}
+
+/**
+ * @brief Apply "func(size_t idx)" to every index in [0, Count), inlined at the call site.
+ */
+template <typename Func>
+inline void ForEach(size_t Count, Func&& func) {
+    for (size_t idx = 0; idx < Count; ++idx) func(idx);
+}
+
+/**
+ * @brief Apply "func(T& element, size_t idx)" to each element of the view, inlined at the call site.
+ */
+template <typename T, typename Func>
+inline void ForEach(ArrayView<T> a, Func&& func) {
+    T *Data = a.Data;
+    for (size_t idx = 0; idx < a.Count; ++idx) func(Data[idx], idx);
+}
+
+/**
+ * @brief Parallel version of ffGraph::ForEach, see ffGraph::ParallelFor for the range splitting.
+ */
+template <typename T, typename Func>
+inline void ParallelForEach(ArrayView<T> a, Func&& func, size_t Grain = ParallelForDefaultGrain) {
+    T *Data = a.Data;
+    ParallelFor(
+        a.Count,
+        [Data, &func](size_t Begin, size_t End) {
+            for (size_t idx = Begin; idx < End; ++idx) func(Data[idx], idx);
+        },
+        Grain);
+}
+
 /**
  * @brief Apply function "void (* FUNCTION)(void *, size_t)" to each array element.
- * Function throws a warning at compilation, "pointer of type ‘void *’ used in arithmetic".
  *
  * @param a [in] - ffGraph::Array which the function will run on.
  * @param func [in] - Function pointer
  */
 inline void ffArrayForEach(Array a, void (*func)(void *array, size_t idx)) {
-    for (size_t idx = 0; idx < a.ElementCount; ++idx) {
-        func((char *)a.Data + (idx * a.ElementSize), idx);
-    }
+    char *Base = (char *)a.Data;
+    ForEach(a.ElementCount, [Base, &a, func](size_t idx) { func(Base + (idx * a.ElementSize), idx); });
 }
 
 }    // namespace ffGraph
@@ -0,0 +1,330 @@
+/**
+ * @file ChunkPool.h
+ * @brief Source of the large memory chunks the arenas (ffGraph::MemoryManagement::LinearAllocator) carve from.
+ */
+#ifndef CHUNK_POOL_H_
+#define CHUNK_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Logger.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace ffGraph {
+namespace MemoryManagement {
+
+/**
+ * @brief Size of a standard chunk, bigger requests get a dedicated chunk.
+ */
+constexpr size_t DefaultChunkSize = 64 * 1024 * 1024;
+
+/**
+ * @brief Number of released standard chunks kept for reuse instead of being given back to the system.
+ */
+constexpr size_t DefaultCachedChunkCount = 4;
+
+/**
+ * @brief Size of a huge page on x86-64 and aarch64 (4 KB granule), mmap backed chunks are rounded up to it.
+ */
+constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+/**
+ * @brief Where the chunks come from.
+ */
+enum ChunkBackend : uint8_t {
+    CHUNK_BACKEND_MALLOC,
+    // @brief Anonymous mmap, 4 KB pages.
+    CHUNK_BACKEND_MMAP,
+    // @brief Anonymous mmap aligned on ffGraph::MemoryManagement::HugePageSize with madvise(MADV_HUGEPAGE).
+    CHUNK_BACKEND_THP,
+    // @brief mmap(MAP_HUGETLB), needs huge pages reserved in /proc/sys/vm/nr_hugepages. Falls back to THP.
+    CHUNK_BACKEND_HUGETLB,
+    CHUNK_BACKEND_COUNT
+};
+
+inline const char *GetChunkBackendName(ChunkBackend Backend) {
+    static const char *Names[CHUNK_BACKEND_COUNT] = {"malloc", "mmap", "thp", "hugetlb"};
+    return (Backend < CHUNK_BACKEND_COUNT) ? Names[Backend] : "unknown";
+}
+
+/**
+ * @brief Parse the value of -Arena, one of the names of ffGraph::MemoryManagement::GetChunkBackendName.
+ *
+ * @return bool - false if Name isn't a backend, Backend is left untouched.
+ */
+inline bool ParseChunkBackend(const char *Name, ChunkBackend& Backend) {
+    for (uint8_t b = 0; b < CHUNK_BACKEND_COUNT; ++b) {
+        if (strcmp(Name, GetChunkBackendName((ChunkBackend)b)) == 0) {
+            Backend = (ChunkBackend)b;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct MemoryChunk {
+    void *Memory = nullptr;
+    size_t Size = 0;
+    // @brief Backend which allocated the chunk, it also frees it.
+    ChunkBackend Backend = CHUNK_BACKEND_MALLOC;
+};
+
+/**
+ * @brief Snapshot of the memory held by a ffGraph::MemoryManagement::ChunkPool and its arenas.
+ */
+struct ChunkPoolStats {
+    // @brief Bytes obtained from the system, cached chunks included.
+    size_t Reserved = 0;
+    size_t PeakReserved = 0;
+    // @brief Bytes of released chunks waiting to be reused.
+    size_t Cached = 0;
+    // @brief Bytes handed out by the arenas, alignment padding included.
+    size_t Live = 0;
+    size_t PeakLive = 0;
+    size_t ChunkCount = 0;
+    // @brief Bytes touched ahead of time by ffGraph::MemoryManagement::ChunkPool::StartPrefault.
+    size_t Prefaulted = 0;
+    ChunkBackend Backend = CHUNK_BACKEND_MALLOC;
+
+    /**
+     * @brief Part of the reserved memory (cache excluded) which isn't handed out : chunk tails the arenas
+     * couldn't use.
+     */
+    float Fragmentation( ) const {
+        size_t InUse = Reserved - Cached;
+        return (InUse == 0) ? 0.f : 1.f - (float)Live / (float)InUse;
+    }
+};
+
+/**
+ * @brief Thread safe chunk provider. Chunks are allocated on demand and standard size chunks are recycled.
+ */
+class ChunkPool {
+   public:
+    explicit ChunkPool(size_t pChunkSize = DefaultChunkSize, size_t pMaxCachedChunks = DefaultCachedChunkCount)
+        : ChunkSize(pChunkSize), MaxCachedChunks(pMaxCachedChunks) {}
+
+    ~ChunkPool( ) {
+        StopPrefault = true;
+        if (PrefaultThread.joinable( ))
+            PrefaultThread.join( );
+        for (auto& c : Cache) FreeChunkMemory(c);
+    }
+
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    /**
+     * @brief Select the backend of the next chunks, chunks already allocated keep theirs.
+     */
+    void SetBackend(ChunkBackend pBackend) {
+#ifndef __linux__
+        if (pBackend != CHUNK_BACKEND_MALLOC) {
+            LogWarning("ChunkPool", "Arena backend %s is only available on Linux, using malloc.", GetChunkBackendName(pBackend));
+            pBackend = CHUNK_BACKEND_MALLOC;
+        }
+#endif
+        Backend.store(pBackend);
+    }
+
+    ChunkBackend GetBackend( ) const { return Backend.load( ); }
+
+    /**
+     * @brief Allocate and touch standard chunks worth Bytes in a background thread, so the first imports
+     * don't page fault. The chunks are put in the cache, which grows to hold them.
+     */
+    void StartPrefault(size_t Bytes) {
+        size_t Count = (Bytes + ChunkSize - 1) / ChunkSize;
+        if (Count == 0 || PrefaultThread.joinable( ))
+            return;
+        {
+            std::lock_guard<std::mutex> Guard(Lock);
+            MaxCachedChunks = std::max(MaxCachedChunks, Count);
+        }
+        PrefaultThread = std::thread([this, Count]( ) {
+            for (size_t i = 0; i < Count && !StopPrefault; ++i) {
+                MemoryChunk c = AllocateChunkMemory(ChunkSize);
+                if (c.Memory == nullptr)
+                    break;
+                TouchPages(c);
+                std::lock_guard<std::mutex> Guard(Lock);
+                Cache.push_back(c);
+                Cached += c.Size;
+                Prefaulted += c.Size;
+            }
+        });
+    }
+
+    /**
+     * @brief Get a chunk of at least MinimumSize bytes.
+     *
+     * @return ffGraph::MemoryManagement::MemoryChunk - Memory is nullptr if the system is out of memory.
+     */
+    MemoryChunk Acquire(size_t MinimumSize) {
+        {
+            std::lock_guard<std::mutex> Guard(Lock);
+            if (MinimumSize <= ChunkSize && !Cache.empty( )) {
+                MemoryChunk c = Cache.back( );
+                Cache.pop_back( );
+                Cached -= c.Size;
+                return c;
+            }
+        }
+        // The system call is done outside of the lock, mmap of a huge chunk can take a while.
+        return AllocateChunkMemory(std::max(MinimumSize, ChunkSize));
+    }
+
+    /**
+     * @brief Give a chunk back, it is cached if it has the standard size and the cache isn't full.
+     */
+    void Recycle(MemoryChunk c) {
+        if (c.Memory == nullptr) return;
+        std::lock_guard<std::mutex> Guard(Lock);
+
+        if (c.Size == RoundChunkSize(ChunkSize, c.Backend) && Cache.size( ) < MaxCachedChunks) {
+            Cache.push_back(c);
+            Cached += c.Size;
+            return;
+        }
+        FreeChunkMemory(c);
+    }
+
+    /**
+     * @brief Called by the arenas to keep the live byte count up to date.
+     */
+    void AddLive(size_t Bytes) {
+        size_t Now = Live.fetch_add(Bytes) + Bytes;
+        size_t Peak = PeakLive.load( );
+        while (Now > Peak && !PeakLive.compare_exchange_weak(Peak, Now)) {
+        }
+    }
+    void RemoveLive(size_t Bytes) { Live.fetch_sub(Bytes); }
+
+    ChunkPoolStats GetStats( ) {
+        std::lock_guard<std::mutex> Guard(Lock);
+        ChunkPoolStats s;
+        s.Reserved = Reserved;
+        s.PeakReserved = PeakReserved;
+        s.Cached = Cached;
+        s.Live = Live.load( );
+        s.PeakLive = PeakLive.load( );
+        s.ChunkCount = ChunkCount;
+        s.Prefaulted = Prefaulted;
+        s.Backend = Backend.load( );
+        return s;
+    }
+
+    size_t GetChunkSize( ) const { return ChunkSize; }
+
+   private:
+    static size_t RoundChunkSize(size_t Size, ChunkBackend b) {
+        return (b == CHUNK_BACKEND_MALLOC) ? Size : (Size + HugePageSize - 1) / HugePageSize * HugePageSize;
+    }
+
+    MemoryChunk AllocateChunkMemory(size_t Size) {
+        MemoryChunk c;
+        c.Backend = Backend.load( );
+        c.Size = RoundChunkSize(Size, c.Backend);
+        c.Memory = MapChunk(c);
+        if (c.Memory == nullptr && c.Backend == CHUNK_BACKEND_HUGETLB) {
+            LogWarning("ChunkPool", "No huge page available for a %lu bytes chunk, falling back to thp.", (unsigned long)c.Size);
+            Backend.store(CHUNK_BACKEND_THP);
+            c.Backend = CHUNK_BACKEND_THP;
+            c.Memory = MapChunk(c);
+        }
+        if (c.Memory == nullptr) return MemoryChunk( );
+
+        std::lock_guard<std::mutex> Guard(Lock);
+        Reserved += c.Size;
+        PeakReserved = std::max(PeakReserved, Reserved);
+        ChunkCount += 1;
+        return c;
+    }
+
+    static void *MapChunk(const MemoryChunk& c) {
+#ifdef __linux__
+        if (c.Backend == CHUNK_BACKEND_MMAP || c.Backend == CHUNK_BACKEND_HUGETLB) {
+            int Flags = MAP_PRIVATE | MAP_ANONYMOUS | ((c.Backend == CHUNK_BACKEND_HUGETLB) ? MAP_HUGETLB : 0);
+            void *p = mmap(nullptr, c.Size, PROT_READ | PROT_WRITE, Flags, -1, 0);
+            return (p == MAP_FAILED) ? nullptr : p;
+        }
+        if (c.Backend == CHUNK_BACKEND_THP) {
+            // Over-reserve then trim so the chunk starts on a huge page boundary, otherwise its first and last
+            // huge pages can't be backed by huge pages.
+            size_t Reservation = c.Size + HugePageSize;
+            void *p = mmap(nullptr, Reservation, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+                return nullptr;
+            uintptr_t Base = (uintptr_t)p;
+            uintptr_t Aligned = (Base + HugePageSize - 1) / HugePageSize * HugePageSize;
+            if (Aligned != Base)
+                munmap(p, Aligned - Base);
+            if (Base + Reservation != Aligned + c.Size)
+                munmap((void *)(Aligned + c.Size), Base + Reservation - (Aligned + c.Size));
+#ifdef MADV_HUGEPAGE
+            madvise((void *)Aligned, c.Size, MADV_HUGEPAGE);
+#endif
+            return (void *)Aligned;
+        }
+#endif
+        return malloc(c.Size);
+    }
+
+    /**
+     * @brief Write one byte per page, the kernel backs the whole chunk now instead of during the imports.
+     */
+    static void TouchPages(const MemoryChunk& c) {
+        volatile char *p = (volatile char *)c.Memory;
+        for (size_t Offset = 0; Offset < c.Size; Offset += 4096) p[Offset] = 0;
+    }
+
+    void FreeChunkMemory(MemoryChunk c) {
+#ifdef __linux__
+        if (c.Backend != CHUNK_BACKEND_MALLOC)
+            munmap(c.Memory, c.Size);
+        else
+            free(c.Memory);
+#else
+        free(c.Memory);
+#endif
+        Reserved -= c.Size;
+        ChunkCount -= 1;
+    }
+
+    const size_t ChunkSize;
+    size_t MaxCachedChunks;
+    std::atomic<ChunkBackend> Backend{CHUNK_BACKEND_MALLOC};
+    std::mutex Lock;
+    std::vector<MemoryChunk> Cache;
+    size_t Reserved = 0;
+    size_t PeakReserved = 0;
+    size_t Cached = 0;
+    size_t ChunkCount = 0;
+    size_t Prefaulted = 0;
+    std::atomic<size_t> Live{0};
+    std::atomic<size_t> PeakLive{0};
+    std::thread PrefaultThread;
+    std::atomic<bool> StopPrefault{false};
+};
+
+/**
+ * @brief Pool shared by every arena of the application.
+ */
+inline ChunkPool& GetChunkPool( ) {
+    static ChunkPool Pool;
+    return Pool;
+}
+
+}    // namespace MemoryManagement
+}    // namespace ffGraph
+
+#endif    // CHUNK_POOL_H_
@@ -0,0 +1,201 @@
+/**
+ * @file Compress.h
+ * @brief Fast lossless codec for the host copies of the geometries : byte shuffle followed by a LZ77 pass.
+ */
+#ifndef COMPRESS_H_
+#define COMPRESS_H_
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ffGraph {
+namespace Compression {
+
+// Format of a compressed stream (same layout as LZ4 blocks) : sequences of
+// [token][extra literal length][literals][offset (2 bytes)][extra match length].
+// The token holds the literal length in its upper 4 bits and the match length minus MinMatch in the lower
+// ones, 15 meaning the length continues in the following bytes (255 means continue again).
+// The last sequence only has literals.
+constexpr size_t MinMatch = 4;
+constexpr size_t MaxOffset = 65535;
+constexpr size_t HashBits = 14;
+// @brief The last bytes of the input are always stored as literals.
+constexpr size_t TailLiterals = 8;
+
+/**
+ * @brief Largest size a compressed stream of Size bytes can take.
+ */
+inline size_t CompressBound(size_t Size) { return Size + Size / 255 + 16; }
+
+inline uint32_t Read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(uint32_t));
+    return v;
+}
+
+inline size_t WriteLength(uint8_t *Out, size_t Length) {
+    size_t n = 0;
+    while (Length >= 255) {
+        Out[n++] = 255;
+        Length -= 255;
+    }
+    Out[n++] = (uint8_t)Length;
+    return n;
+}
+
+/**
+ * @brief Compress Size bytes of In to Out, which must hold ffGraph::Compression::CompressBound(Size) bytes.
+ *
+ * @return size_t - Number of bytes written to Out.
+ */
+inline size_t LZCompress(const uint8_t *In, size_t Size, uint8_t *Out) {
+    std::vector<uint32_t> Table((size_t)1 << HashBits, 0);
+    size_t Anchor = 0, ip = 0, op = 0;
+
+    if (Size > MinMatch + TailLiterals) {
+        const size_t Limit = Size - TailLiterals;
+
+        while (ip < Limit) {
+            uint32_t Sequence = Read32(In + ip);
+            uint32_t Hash = (Sequence * 2654435761u) >> (32 - HashBits);
+            size_t Ref = Table[Hash];
+            Table[Hash] = (uint32_t)ip;
+
+            if (Ref >= ip || ip - Ref > MaxOffset || Read32(In + Ref) != Sequence) {
+                ++ip;
+                continue;
+            }
+            size_t MatchLength = MinMatch;
+            while (ip + MatchLength < Limit && In[Ref + MatchLength] == In[ip + MatchLength]) ++MatchLength;
+
+            size_t LiteralLength = ip - Anchor;
+            size_t ExtraMatch = MatchLength - MinMatch;
+            uint8_t& Token = Out[op++];
+            Token = (uint8_t)(((LiteralLength < 15) ? LiteralLength : 15) << 4);
+            Token |= (uint8_t)((ExtraMatch < 15) ? ExtraMatch : 15);
+            if (LiteralLength >= 15)
+                op += WriteLength(Out + op, LiteralLength - 15);
+            memcpy(Out + op, In + Anchor, LiteralLength);
+            op += LiteralLength;
+            Out[op++] = (uint8_t)((ip - Ref) & 0xff);
+            Out[op++] = (uint8_t)((ip - Ref) >> 8);
+            if (ExtraMatch >= 15)
+                op += WriteLength(Out + op, ExtraMatch - 15);
+
+            ip += MatchLength;
+            Anchor = ip;
+        }
+    }
+    size_t LiteralLength = Size - Anchor;
+    Out[op++] = (uint8_t)(((LiteralLength < 15) ? LiteralLength : 15) << 4);
+    if (LiteralLength >= 15)
+        op += WriteLength(Out + op, LiteralLength - 15);
+    memcpy(Out + op, In + Anchor, LiteralLength);
+    return op + LiteralLength;
+}
+
+inline bool ReadLength(const uint8_t *In, size_t Size, size_t& ip, size_t& Length) {
+    uint8_t b;
+    do {
+        if (ip >= Size)
+            return false;
+        b = In[ip++];
+        Length += b;
+    } while (b == 255);
+    return true;
+}
+
+/**
+ * @brief Decompress a stream produced by ffGraph::Compression::LZCompress.
+ *
+ * @return bool - false if the stream is malformed or doesn't decode to exactly OutSize bytes.
+ */
+inline bool LZDecompress(const uint8_t *In, size_t Size, uint8_t *Out, size_t OutSize) {
+    size_t ip = 0, op = 0;
+
+    while (ip < Size) {
+        uint8_t Token = In[ip++];
+        size_t LiteralLength = Token >> 4;
+        if (LiteralLength == 15 && !ReadLength(In, Size, ip, LiteralLength))
+            return false;
+        if (ip + LiteralLength > Size || op + LiteralLength > OutSize)
+            return false;
+        memcpy(Out + op, In + ip, LiteralLength);
+        ip += LiteralLength;
+        op += LiteralLength;
+        if (ip == Size)
+            break;
+
+        if (ip + 2 > Size)
+            return false;
+        size_t Offset = (size_t)In[ip] | ((size_t)In[ip + 1] << 8);
+        ip += 2;
+        size_t MatchLength = Token & 15;
+        if (MatchLength == 15 && !ReadLength(In, Size, ip, MatchLength))
+            return false;
+        MatchLength += MinMatch;
+        if (Offset == 0 || Offset > op || op + MatchLength > OutSize)
+            return false;
+        // Matches can overlap the bytes they produce, copy forward byte by byte.
+        const uint8_t *Match = Out + op - Offset;
+        for (size_t i = 0; i < MatchLength; ++i) Out[op + i] = Match[i];
+        op += MatchLength;
+    }
+    return op == OutSize;
+}
+
+/**
+ * @brief Group the k-th byte of every Stride bytes element together. Floats of a mesh share their exponent
+ * and upper mantissa bytes, which then form long runs the LZ pass can match.
+ */
+inline void ShuffleBytes(const uint8_t *In, size_t Size, size_t Stride, uint8_t *Out) {
+    size_t Count = Size / Stride;
+    for (size_t i = 0; i < Count; ++i)
+        for (size_t k = 0; k < Stride; ++k) Out[k * Count + i] = In[i * Stride + k];
+    memcpy(Out + Count * Stride, In + Count * Stride, Size - Count * Stride);
+}
+
+inline void UnshuffleBytes(const uint8_t *In, size_t Size, size_t Stride, uint8_t *Out) {
+    size_t Count = Size / Stride;
+    for (size_t k = 0; k < Stride; ++k)
+        for (size_t i = 0; i < Count; ++i) Out[i * Stride + k] = In[k * Count + i];
+    memcpy(Out + Count * Stride, In + Count * Stride, Size - Count * Stride);
+}
+
+/**
+ * @brief Shuffle then compress an array of Stride bytes elements.
+ *
+ * @param Src [in] - Data to compress.
+ * @param Size [in] - Number of bytes.
+ * @param Stride [in] - Size of one element.
+ * @param Out [out] - Compressed stream, resized to its final size.
+ */
+inline void CompressShuffled(const void *Src, size_t Size, size_t Stride, std::vector<uint8_t>& Out) {
+    std::vector<uint8_t> Shuffled(Size);
+    ShuffleBytes((const uint8_t *)Src, Size, (Stride) ? Stride : 1, Shuffled.data( ));
+    Out.resize(CompressBound(Size));
+    Out.resize(LZCompress(Shuffled.data( ), Size, Out.data( )));
+    Out.shrink_to_fit( );
+}
+
+/**
+ * @brief Reverse of ffGraph::Compression::CompressShuffled.
+ *
+ * @param Src [in] - Compressed stream.
+ * @param Dst [out] - Destination of the Size decompressed bytes.
+ *
+ * @return bool - false if the stream is malformed.
+ */
+inline bool DecompressShuffled(const std::vector<uint8_t>& Src, void *Dst, size_t Size, size_t Stride) {
+    std::vector<uint8_t> Shuffled(Size);
+    if (!LZDecompress(Src.data( ), Src.size( ), Shuffled.data( ), Size))
+        return false;
+    UnshuffleBytes(Shuffled.data( ), Size, (Stride) ? Stride : 1, (uint8_t *)Dst);
+    return true;
+}
+
+}    // namespace Compression
+}    // namespace ffGraph
+
+#endif    // COMPRESS_H_
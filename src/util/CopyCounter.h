@@ -0,0 +1,93 @@
+/**
+ * @file CopyCounter.h
+ * @brief Debug builds count the bytes of plot data copied between the socket and the upload, per stage and
+ * across every thread (import workers included), release builds compile the counters out. A ffGraph::CopyTally
+ * also counts the copies of a single thread, the import checks each plot against its copy budget with it.
+ */
+#ifndef COPY_COUNTER_H_
+#define COPY_COUNTER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ffGraph {
+
+enum CopyStage : uint8_t {
+    // @brief Packets appended to a payload, in memory or to its spill file.
+    COPY_STAGE_PAYLOAD,
+    // @brief CBOR payload decoded to a json document.
+    COPY_STAGE_DECODE,
+    // @brief Arrays extracted from the json document.
+    COPY_STAGE_EXTRACT,
+    // @brief Copies made by the import kernels besides the geometries they construct.
+    COPY_STAGE_IMPORT,
+    // @brief Host copies read for an upload, and streams gathered to the staging memory.
+    COPY_STAGE_UPLOAD,
+    COPY_STAGE_COUNT
+};
+
+#ifdef _DEBUG
+
+inline std::atomic<uint64_t> *CopiedBytesSlots( ) {
+    static std::atomic<uint64_t> Bytes[COPY_STAGE_COUNT];
+    return Bytes;
+}
+
+/**
+ * @brief Bytes copied per stage by a single thread, to check the copies made for one plot.
+ */
+struct CopyTally {
+    uint64_t Bytes[COPY_STAGE_COUNT] = {};
+};
+
+inline CopyTally *&CurrentCopyTally( ) {
+    static thread_local CopyTally *Tally = nullptr;
+    return Tally;
+}
+
+/**
+ * @brief The copies counted by the calling thread are also added to Tally while the scope lives.
+ */
+class CopyTallyScope {
+   public:
+    explicit CopyTallyScope(CopyTally& Tally) : Previous(CurrentCopyTally( )) { CurrentCopyTally( ) = &Tally; }
+    ~CopyTallyScope( ) { CurrentCopyTally( ) = Previous; }
+
+    CopyTallyScope(const CopyTallyScope&) = delete;
+    CopyTallyScope& operator=(const CopyTallyScope&) = delete;
+
+   private:
+    CopyTally *Previous;
+};
+
+#endif
+
+/**
+ * @brief Record Bytes of plot data copied by the calling thread during Stage.
+ */
+inline void CountCopy(uint8_t Stage, size_t Bytes) {
+#ifdef _DEBUG
+    CopiedBytesSlots( )[Stage].fetch_add(Bytes, std::memory_order_relaxed);
+    if (CurrentCopyTally( ) != nullptr) CurrentCopyTally( )->Bytes[Stage] += Bytes;
+#else
+    (void)Stage;
+    (void)Bytes;
+#endif
+}
+
+/**
+ * @brief Bytes recorded by every thread during Stage since startup, always 0 in release.
+ */
+inline uint64_t GetCopiedBytes(uint8_t Stage) {
+#ifdef _DEBUG
+    return CopiedBytesSlots( )[Stage].load(std::memory_order_relaxed);
+#else
+    (void)Stage;
+    return 0;
+#endif
+}
+
+}    // namespace ffGraph
+
+#endif    // COPY_COUNTER_H_
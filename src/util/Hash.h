@@ -0,0 +1,145 @@
+/**
+ * @file Hash.h
+ * @brief Fast non-cryptographic 128 bits hash of the arrays a geometry is built from, see
+ * ffGraph::JSON::ContentCache.
+ */
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ffGraph {
+
+struct Hash128 {
+    uint64_t Low = 0;
+    uint64_t High = 0;
+
+    // @brief The null hash stands for content which wasn't hashed.
+    inline bool Empty( ) const { return Low == 0 && High == 0; }
+    inline bool operator==(const Hash128& o) const { return Low == o.Low && High == o.High; }
+    inline bool operator!=(const Hash128& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief Incremental hash over 16 bytes blocks, two 64 bits lanes mixed like MurmurHash3 x64 128. Every Add
+ * is padded and tagged with its size, so splitting the same bytes differently gives another hash.
+ */
+class ContentHasher {
+   public:
+    explicit ContentHasher(uint64_t Seed = 0) : h1(Seed ^ 0x9E3779B97F4A7C15ull), h2(Seed ^ 0xC2B2AE3D27D4EB4Full) {}
+
+    void Add(const void *Data, size_t Size) {
+        const uint8_t *p = (const uint8_t *)Data;
+        size_t Blocks = Size / 16;
+        for (size_t i = 0; i < Blocks; ++i) {
+            uint64_t k1, k2;
+            memcpy(&k1, p + i * 16, sizeof(uint64_t));
+            memcpy(&k2, p + i * 16 + 8, sizeof(uint64_t));
+            Round(k1, k2);
+        }
+        uint64_t Tail[2] = {0, 0};
+        // An empty array may have no storage at all, memcpy must not be given its null pointer.
+        if (Size != Blocks * 16)
+            memcpy(Tail, p + Blocks * 16, Size - Blocks * 16);
+        Round(Tail[0], Tail[1] ^ (uint64_t)Size);
+        Length += Size;
+    }
+
+    /**
+     * @brief Add Size bytes out of every Stride bytes of Count elements, gathered by chunks of whole elements.
+     */
+    void AddStrided(const void *Data, size_t Count, size_t Size, size_t Stride) {
+        const uint8_t *p = (const uint8_t *)Data;
+        uint8_t Chunk[4096];
+        size_t PerChunk = (Size == 0 || Size > sizeof(Chunk)) ? 0 : sizeof(Chunk) / Size;
+        if (PerChunk == 0) {
+            for (size_t i = 0; i < Count; ++i) Add(p + i * Stride, Size);
+            return;
+        }
+        for (size_t First = 0; First < Count; First += PerChunk) {
+            size_t n = (Count - First < PerChunk) ? Count - First : PerChunk;
+            for (size_t i = 0; i < n; ++i) memcpy(Chunk + i * Size, p + (First + i) * Stride, Size);
+            Add(Chunk, n * Size);
+        }
+    }
+
+    template <typename T>
+    void Add(const std::vector<T>& v) { Add(v.data( ), v.size( ) * sizeof(T)); }
+    void Add(const std::string& s) { Add(s.data( ), s.size( )); }
+    void Add(const Hash128& h) { Add(&h, sizeof(Hash128)); }
+
+    template <typename T>
+    void AddValue(const T& v) { Add(&v, sizeof(T)); }
+
+    Hash128 Finish( ) const {
+        uint64_t a = h1 ^ Length, b = h2 ^ Length;
+        a += b;
+        b += a;
+        a = Mix(a);
+        b = Mix(b);
+        a += b;
+        b += a;
+        Hash128 h;
+        h.Low = a;
+        h.High = b;
+        // Keep the null hash for unhashed content.
+        if (h.Empty( ))
+            h.Low = 1;
+        return h;
+    }
+
+   private:
+    static inline uint64_t Rotate(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static inline uint64_t Mix(uint64_t k) {
+        k ^= k >> 33;
+        k *= 0xFF51AFD7ED558CCDull;
+        k ^= k >> 33;
+        k *= 0xC4CEB9FE1A85EC53ull;
+        k ^= k >> 33;
+        return k;
+    }
+
+    inline void Round(uint64_t k1, uint64_t k2) {
+        const uint64_t c1 = 0x87C37B91114253D5ull;
+        const uint64_t c2 = 0x4CF5AD432745937Full;
+
+        k1 *= c1;
+        k1 = Rotate(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = Rotate(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52DCE729;
+
+        k2 *= c2;
+        k2 = Rotate(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = Rotate(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495AB5;
+    }
+
+    uint64_t h1;
+    uint64_t h2;
+    uint64_t Length = 0;
+};
+
+/**
+ * @brief Hash of a single array.
+ */
+template <typename T>
+inline Hash128 HashContent(const std::vector<T>& v) {
+    ContentHasher h;
+    h.Add(v);
+    return h.Finish( );
+}
+
+}    // namespace ffGraph
+
+#endif    // HASH_H_
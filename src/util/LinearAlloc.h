@@ -11,71 +11,295 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <mutex>
+#include <new>
+#include <vector>
+#include "ChunkPool.h"
+#include "MemoryTracker.h"
 
 namespace ffGraph {
 namespace MemoryManagement {
 
+/**
+ * @brief Size of the blocks each thread carves from the shared chunk and then bump allocates from.
+ */
+constexpr size_t ThreadBlockSize = 256 * 1024;
+
+/**
+ * @brief Number of arenas a thread keeps a block of at the same time.
+ */
+constexpr size_t ThreadBlockCacheSize = 4;
+
+/**
+ * @brief Arena : bump allocator over chunks taken from a ffGraph::MemoryManagement::ChunkPool. Allocations
+ * are never freed one by one, the whole arena is released at once (when the plot or message owning it goes
+ * away) and its chunks are recycled by the pool.
+ *
+ * Threads don't share a lock : each one bump allocates from its own ffGraph::MemoryManagement::ThreadBlockSize
+ * block, refilled from the current chunk with an atomic add. The mutex is only taken to install a new chunk.
+ */
 class LinearAllocator {
     public:
-        LinearAllocator(const size_t Size) { MemoryStart = malloc(Size); assert(MemoryStart != 0); TotalSize = Size; }
+        explicit LinearAllocator(ChunkPool& pPool = GetChunkPool( )) : Pool(pPool), ID(NextID()) {}
 
         ~LinearAllocator() {
-
-            free(MemoryStart);
 #ifdef _DEBUG
-            LogInfo("LinearAllocator", "Total memory allocated %lu, total amount of memory used %lu.", TotalSize, Peak);
+            LogInfo("LinearAllocator", "Total memory reserved %lu, peak memory used %lu.", Reserved, Peak.load());
 #endif
-            TotalSize = 0;
+            Release();
         }
 
-        void *Allocate(const size_t size) {
-            Lock.lock();
-            size_t padding = 0;
-            size_t paddedAddress = 0;
+        LinearAllocator(const LinearAllocator&) = delete;
+        LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+        void *Allocate(const size_t size) { return Allocate(size, Alignment); }
 
-            const size_t currentAddress = (std::size_t)MemoryStart + Offset;
+        void *Allocate(const size_t size, const size_t alignment) {
+            const uint64_t CurrentGeneration = Generation.load(std::memory_order_acquire);
+            ThreadBlock& Block = GetThreadBlock(CurrentGeneration);
 
-            if (Offset % Alignment != 0) {
-                padding = ComputePadding(currentAddress, Alignment);
+            if (Block.Current != 0) {
+                size_t Address = AlignUp(Block.Current, alignment);
+                if (Address + size <= Block.End) {
+                    Block.Current = Address + size;
+                    return (void *)Address;
+                }
             }
-            if (Offset + padding + size > TotalSize)
+            // Big allocations don't go through the thread block, they would waste most of it.
+            if (size + alignment > ThreadBlockSize / 4)
+                return AllocateShared(size, alignment);
+
+            void *NewBlock = AllocateShared(ThreadBlockSize, BlockAlignment);
+            if (NewBlock == nullptr)
                 return nullptr;
-            Offset += padding;
-            size_t nAdress = currentAddress + padding;
-            Offset += size;
+            Block.Current = AlignUp((size_t)NewBlock, alignment) + size;
+            Block.End = (size_t)NewBlock + ThreadBlockSize;
+            return (void *)(Block.Current - size);
+        }
 
-#ifdef _DEBUG
-            LogInfo("LinearAllocator", "Performing an allocation of %lu bytes, Offset is %lu. Adress : %x\n", size, Offset, nAdress);
-#endif
+        /**
+         * @brief Account Bytes allocated from this arena to a subsystem, until the arena is released.
+         */
+        void Track(MemoryTag Tag, size_t Bytes) {
+            TagBytes[Tag].fetch_add(Bytes);
+            TagCounts[Tag].fetch_add(1);
+            GetMemoryTracker( ).Add(Tag, Bytes);
+        }
 
-            Used = Offset;
-            Peak = std::max(Peak, Used);
+        /**
+         * @brief Give every chunk back to the pool. Every pointer returned by this arena becomes invalid, and
+         * no thread may allocate from it during the call.
+         */
+        void Release() {
+            std::lock_guard<std::mutex> Guard(Lock);
+            for (auto& c : Chunks) Pool.Recycle(c);
+            Pool.RemoveLive(Used.load());
+            Chunks.clear();
+            Current.store(nullptr, std::memory_order_release);
+            Used.store(0);
+            Reserved = 0;
+            // Blocks the threads still hold point into the released chunks.
+            Generation.fetch_add(1, std::memory_order_release);
+            for (uint8_t t = 0; t < MEMORY_TAG_COUNT; ++t) {
+                uint64_t Count = TagCounts[t].exchange(0);
+                if (Count != 0)
+                    GetMemoryTracker( ).Remove((MemoryTag)t, TagBytes[t].exchange(0), Count);
+            }
+        }
 
-            Lock.unlock();
-            return (void *)nAdress;
+        // @brief Bytes carved from the chunks (thread blocks count as a whole).
+        size_t GetUsed() const { return Used.load(); }
+        // @brief Bytes of the chunks held by the arena.
+        size_t GetReserved() const { return Reserved; }
+        // @brief High-water mark of GetUsed since the arena creation.
+        size_t GetPeak() const { return Peak.load(); }
+        // @brief Part of the reserved bytes which can't be handed out anymore (tails of the previous chunks).
+        float GetFragmentation() {
+            std::lock_guard<std::mutex> Guard(Lock);
+            if (Reserved == 0) return 0.f;
+            ChunkHeader *h = Current.load();
+            size_t Remaining = (h && h->Offset.load() < h->Capacity) ? h->Capacity - h->Offset.load() : 0;
+            return 1.f - (float)(Used.load() + Remaining) / (float)Reserved;
         }
 
     private:
-        void *MemoryStart = NULL;
-        size_t Offset = 0;
-        size_t TotalSize = 0;
-        size_t Used = 0;
-        size_t Peak = 0;
-        std::mutex Lock;
-        const size_t Alignment = sizeof(float);
+        static constexpr size_t BlockAlignment = 64;
+
+        /**
+         * @brief Stored at the beginning of every chunk, the data starts BlockAlignment bytes after it.
+         */
+        struct ChunkHeader {
+            std::atomic<size_t> Offset;
+            size_t Capacity;
+        };
+
+        // @brief Thread local, zero initialized. ArenaID 0 is never given to an arena.
+        struct ThreadBlock {
+            uint64_t ArenaID;
+            uint64_t Generation;
+            size_t Current;
+            size_t End;
+        };
+
+        static uint64_t NextID() {
+            static std::atomic<uint64_t> Counter{1};
+            return Counter.fetch_add(1);
+        }
+
+        static size_t AlignUp(size_t Address, size_t alignment) {
+            return (Address % alignment == 0) ? Address : Address + ComputePadding(Address, alignment);
+        }
+
+        /**
+         * @brief Block of the calling thread for this arena. Arena IDs are never reused so a block can't be
+         * mistaken for the one of a destroyed arena.
+         */
+        ThreadBlock& GetThreadBlock(uint64_t CurrentGeneration) {
+            static thread_local ThreadBlock Blocks[ThreadBlockCacheSize];
+            static thread_local size_t NextVictim = 0;
+
+            for (size_t i = 0; i < ThreadBlockCacheSize; ++i) {
+                if (Blocks[i].ArenaID == ID) {
+                    if (Blocks[i].Generation != CurrentGeneration)
+                        Blocks[i] = {ID, CurrentGeneration, 0, 0};
+                    return Blocks[i];
+                }
+            }
+            ThreadBlock& Victim = Blocks[NextVictim];
+            NextVictim = (NextVictim + 1) % ThreadBlockCacheSize;
+            Victim = {ID, CurrentGeneration, 0, 0};
+            return Victim;
+        }
+
+        /**
+         * @brief Carve size bytes from the current chunk with an atomic add, installing a new chunk when it is full.
+         */
+        void *AllocateShared(const size_t size, const size_t alignment) {
+            const size_t Reservation = size + ((alignment > BlockAlignment) ? alignment : 0);
+            const size_t Rounded = AlignUp(Reservation, BlockAlignment);
+
+            // Requests bigger than half a chunk get their own chunk, the current one stays in use.
+            if (Rounded > Pool.GetChunkSize() / 2)
+                return AllocateDedicated(Rounded, alignment);
 
-        size_t ComputePadding(const size_t BaseAddress, const size_t Alignment) {
+            while (true) {
+                ChunkHeader *h = Current.load(std::memory_order_acquire);
+                if (h != nullptr) {
+                    size_t Offset = h->Offset.fetch_add(Rounded, std::memory_order_relaxed);
+                    if (Offset + Rounded <= h->Capacity) {
+                        AddUsed(Rounded);
+                        return (void *)AlignUp(ChunkData(h) + Offset, alignment);
+                    }
+                }
+                if (!InstallChunk(h))
+                    return nullptr;
+            }
+        }
+
+        bool InstallChunk(ChunkHeader *Expected) {
+            std::lock_guard<std::mutex> Guard(Lock);
+            if (Current.load() != Expected)
+                return true;
+            MemoryChunk c = Pool.Acquire(Pool.GetChunkSize());
+            if (c.Memory == nullptr)
+                return false;
+            Chunks.push_back(c);
+            Reserved += c.Size;
+            Current.store(CreateHeader(c), std::memory_order_release);
+            return true;
+        }
+
+        void *AllocateDedicated(const size_t Rounded, const size_t alignment) {
+            std::lock_guard<std::mutex> Guard(Lock);
+            MemoryChunk c = Pool.Acquire(Rounded + 2 * BlockAlignment);
+            if (c.Memory == nullptr)
+                return nullptr;
+            Chunks.push_back(c);
+            Reserved += c.Size;
+            ChunkHeader *h = CreateHeader(c);
+            h->Offset.store(h->Capacity);
+            AddUsed(Rounded);
+            return (void *)AlignUp(ChunkData(h), alignment);
+        }
+
+        static ChunkHeader *CreateHeader(MemoryChunk c) {
+            size_t Base = AlignUp((size_t)c.Memory, BlockAlignment);
+            ChunkHeader *h = new ((void *)Base) ChunkHeader;
+            h->Offset.store(0);
+            h->Capacity = c.Size - (Base - (size_t)c.Memory) - BlockAlignment;
+            return h;
+        }
+
+        static size_t ChunkData(ChunkHeader *h) { return (size_t)h + BlockAlignment; }
+
+        void AddUsed(size_t Bytes) {
+            size_t Now = Used.fetch_add(Bytes) + Bytes;
+            size_t Previous = Peak.load();
+            while (Now > Previous && !Peak.compare_exchange_weak(Previous, Now)) {
+            }
+            Pool.AddLive(Bytes);
+        }
+
+        static size_t ComputePadding(const size_t BaseAddress, const size_t Alignment) {
             const size_t mult = (BaseAddress / Alignment) + 1;
             const size_t AlignedAddress = mult * Alignment;
             const size_t Padding = AlignedAddress - BaseAddress;
             return Padding;
         }
+
+        ChunkPool& Pool;
+        const uint64_t ID;
+        std::atomic<uint64_t> Generation{0};
+        std::atomic<ChunkHeader *> Current{nullptr};
+        std::vector<MemoryChunk> Chunks;
+        std::atomic<size_t> Used{0};
+        std::atomic<size_t> Peak{0};
+        size_t Reserved = 0;
+        std::mutex Lock;
+        std::atomic<size_t> TagBytes[MEMORY_TAG_COUNT] = { };
+        std::atomic<uint64_t> TagCounts[MEMORY_TAG_COUNT] = { };
+        const size_t Alignment = sizeof(float);
 };
 
+/**
+ * @brief Application wide arena, used when no ffGraph::MemoryManagement::ArenaScope is active.
+ */
 extern LinearAllocator *GAlloc;
 
+/**
+ * @brief Arena selected for the calling thread by ffGraph::MemoryManagement::ArenaScope.
+ */
+inline LinearAllocator *& CurrentArenaSlot() {
+    static thread_local LinearAllocator *Current = nullptr;
+    return Current;
+}
+
+/**
+ * @brief Arena the allocations of the calling thread go to.
+ */
+inline LinearAllocator *GetCurrentAllocator() {
+    LinearAllocator *Current = CurrentArenaSlot();
+    return (Current) ? Current : GAlloc;
+}
+
+/**
+ * @brief Route the allocations of the calling thread to an arena until the end of the scope.
+ */
+class ArenaScope {
+    public:
+        explicit ArenaScope(LinearAllocator *Arena) : Previous(CurrentArenaSlot()) { CurrentArenaSlot() = Arena; }
+        ~ArenaScope() { CurrentArenaSlot() = Previous; }
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+
+    private:
+        LinearAllocator *Previous;
+};
+
 } // namespace ffGraph
 } // namespace MemoryManagement
 
-#endif // #define LINEAR_ALLOC_H_
\ No newline at end of file
+#endif // #define LINEAR_ALLOC_H_
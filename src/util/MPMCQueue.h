@@ -0,0 +1,165 @@
+/**
+ * @file MPMCQueue.h
+ * @brief Bounded lock-free multi producers / multi consumers ring (D. Vyukov's design) for move-only items.
+ */
+#ifndef MPMC_QUEUE_H_
+#define MPMC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ffGraph {
+
+/**
+ * @brief Every cell carries a sequence number : a cell at position Pos is free for the producer of Pos when its
+ * sequence equals Pos, and holds the item for the consumer of Pos when it equals Pos + 1. Producers and consumers
+ * claim positions with a CAS on their counter, so neither side ever takes a lock.
+ */
+template <typename T>
+class MPMCQueue {
+   public:
+    /**
+     * @param Capacity [in] - Number of items the ring holds, rounded up to a power of two.
+     */
+    explicit MPMCQueue(size_t Capacity) {
+        size_t n = 2;
+        while (n < Capacity) n <<= 1;
+        Mask = n - 1;
+        Cells = new Cell[n];
+        for (size_t i = 0; i < n; ++i) Cells[i].Sequence.store(i, std::memory_order_relaxed);
+        EnqueuePos.store(0, std::memory_order_relaxed);
+        DequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    ~MPMCQueue( ) {
+        size_t Head = EnqueuePos.load(std::memory_order_relaxed);
+        for (size_t Pos = DequeuePos.load(std::memory_order_relaxed); Pos != Head; ++Pos)
+            reinterpret_cast<T *>(&Cells[Pos & Mask].Storage)->~T( );
+        delete[] Cells;
+    }
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    /**
+     * @brief Move Item into the ring. Item is left untouched when the ring is full.
+     *
+     * @return bool - false if the ring is full.
+     */
+    bool try_push(T&& Item) { return try_push_bulk(&Item, 1) == 1; }
+
+    /**
+     * @brief Move the longest prefix of Items[0, Count) the ring has room for, in order.
+     *
+     * @return size_t - Number of items moved.
+     */
+    size_t try_push_bulk(T *Items, size_t Count) {
+        size_t Pos = EnqueuePos.load(std::memory_order_relaxed);
+        size_t n;
+        for (;;) {
+            n = CountCells(Pos, Count, 0);
+            if (n == 0) {
+                // The first cell being ahead of Pos means another producer claimed it first, retry from its position.
+                if (IsStale(Pos, 0, EnqueuePos))
+                    continue;
+                return 0;
+            }
+            if (EnqueuePos.compare_exchange_weak(Pos, Pos + n, std::memory_order_relaxed))
+                break;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            Cell& c = Cells[(Pos + i) & Mask];
+            new (&c.Storage) T(std::move(Items[i]));
+            c.Sequence.store(Pos + i + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+    /**
+     * @return bool - false if the ring is empty.
+     */
+    bool try_pop(T& Item) { return try_pop_bulk(&Item, 1) == 1; }
+
+    /**
+     * @brief Move up to Max ready items, oldest first, to Out[0, Max).
+     *
+     * @return size_t - Number of items moved.
+     */
+    size_t try_pop_bulk(T *Out, size_t Max) {
+        size_t Pos = DequeuePos.load(std::memory_order_relaxed);
+        size_t n;
+        for (;;) {
+            n = CountCells(Pos, Max, 1);
+            if (n == 0) {
+                if (IsStale(Pos, 1, DequeuePos))
+                    continue;
+                return 0;
+            }
+            if (DequeuePos.compare_exchange_weak(Pos, Pos + n, std::memory_order_relaxed))
+                break;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            Cell& c = Cells[(Pos + i) & Mask];
+            T *Item = reinterpret_cast<T *>(&c.Storage);
+            Out[i] = std::move(*Item);
+            Item->~T( );
+            c.Sequence.store(Pos + i + Mask + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+    /**
+     * @brief Number of claimed positions, exact when no push or pop is in flight.
+     */
+    size_t size( ) const {
+        size_t Tail = DequeuePos.load(std::memory_order_relaxed);
+        size_t Head = EnqueuePos.load(std::memory_order_relaxed);
+        return (Head > Tail) ? Head - Tail : 0;
+    }
+
+    bool empty( ) const { return size( ) == 0; }
+    size_t capacity( ) const { return Mask + 1; }
+
+   private:
+    struct Cell {
+        std::atomic<size_t> Sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+    };
+
+    /**
+     * @brief Number of consecutive cells from Pos whose sequence is Pos + i + Shift (free for producers with
+     * Shift 0, ready for consumers with Shift 1). Those cells can't change state until their position is claimed.
+     */
+    size_t CountCells(size_t Pos, size_t Max, size_t Shift) const {
+        size_t n = 0;
+        while (n < Max && n <= Mask &&
+               Cells[(Pos + n) & Mask].Sequence.load(std::memory_order_acquire) == Pos + n + Shift)
+            ++n;
+        return n;
+    }
+
+    /**
+     * @brief When the sequence of the first cell is ahead of what Pos expects, another thread claimed the cell
+     * after Pos was read : reload it and tell the caller to retry. Otherwise the ring is really full (or empty).
+     */
+    bool IsStale(size_t& Pos, size_t Shift, const std::atomic<size_t>& Counter) const {
+        size_t Sequence = Cells[Pos & Mask].Sequence.load(std::memory_order_acquire);
+        if ((ptrdiff_t)(Sequence - (Pos + Shift)) > 0) {
+            Pos = Counter.load(std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    Cell *Cells = nullptr;
+    size_t Mask = 0;
+    alignas(64) std::atomic<size_t> EnqueuePos;
+    alignas(64) std::atomic<size_t> DequeuePos;
+};
+
+}    // namespace ffGraph
+
+#endif    // MPMC_QUEUE_H_
@@ -0,0 +1,163 @@
+/**
+ * @file MemoryTracker.h
+ * @brief Per subsystem accounting of the memory held by the application.
+ */
+#ifndef MEMORY_TRACKER_H_
+#define MEMORY_TRACKER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "ChunkPool.h"
+
+namespace ffGraph {
+namespace MemoryManagement {
+
+enum MemoryTag : uint8_t {
+    // @brief Messages received from FreeFEM and kept in memory until they are imported.
+    MEMORY_TAG_NETWORK,
+    // @brief Decoded CBOR documents (estimated from the JSON tree).
+    MEMORY_TAG_CBOR,
+    // @brief Meshes and borders arrays.
+    MEMORY_TAG_GEOMETRY,
+    // @brief Iso values, iso lines and vector fields arrays.
+    MEMORY_TAG_ISO,
+    MEMORY_TAG_VMA_BUFFER,
+    MEMORY_TAG_VMA_IMAGE,
+    MEMORY_TAG_IMGUI,
+    MEMORY_TAG_COUNT
+};
+
+inline const char *GetMemoryTagName(MemoryTag Tag) {
+    static const char *Names[MEMORY_TAG_COUNT] = {"Network", "CBOR", "Geometry", "Iso", "VmaBuffer", "VmaImage", "ImGui"};
+    return (Tag < MEMORY_TAG_COUNT) ? Names[Tag] : "Unknown";
+}
+
+struct MemoryTagStats {
+    size_t Live = 0;
+    size_t Peak = 0;
+    uint64_t Allocations = 0;
+    uint64_t Frees = 0;
+};
+
+/**
+ * @brief Thread safe counters, one set per ffGraph::MemoryManagement::MemoryTag.
+ */
+class MemoryTracker {
+   public:
+    MemoryTracker( ) {}
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+    void Add(MemoryTag Tag, size_t Bytes, uint64_t Count = 1) {
+        Counters& c = Tags[Tag];
+        size_t Now = c.Live.fetch_add(Bytes) + Bytes;
+        size_t Peak = c.Peak.load( );
+        while (Now > Peak && !c.Peak.compare_exchange_weak(Peak, Now)) {
+        }
+        c.Allocations.fetch_add(Count);
+    }
+
+    void Remove(MemoryTag Tag, size_t Bytes, uint64_t Count = 1) {
+        Tags[Tag].Live.fetch_sub(Bytes);
+        Tags[Tag].Frees.fetch_add(Count);
+    }
+
+    MemoryTagStats GetStats(MemoryTag Tag) const {
+        MemoryTagStats s;
+        s.Live = Tags[Tag].Live.load( );
+        s.Peak = Tags[Tag].Peak.load( );
+        s.Allocations = Tags[Tag].Allocations.load( );
+        s.Frees = Tags[Tag].Frees.load( );
+        return s;
+    }
+
+    /**
+     * @brief Counters of every tag and the state of the chunk pool, as a JSON object.
+     */
+    std::string DumpJSON( ) const {
+        std::string Out("{\n  \"Tags\": {\n");
+        char Line[256];
+        for (uint8_t t = 0; t < MEMORY_TAG_COUNT; ++t) {
+            MemoryTagStats s = GetStats((MemoryTag)t);
+            snprintf(Line, sizeof(Line), "    \"%s\": {\"Live\": %zu, \"Peak\": %zu, \"Allocations\": %llu, \"Frees\": %llu}%s\n",
+                     GetMemoryTagName((MemoryTag)t), s.Live, s.Peak, (unsigned long long)s.Allocations,
+                     (unsigned long long)s.Frees, (t + 1 < MEMORY_TAG_COUNT) ? "," : "");
+            Out.append(Line);
+        }
+        ChunkPoolStats p = GetChunkPool( ).GetStats( );
+        snprintf(Line, sizeof(Line),
+                 "  },\n  \"ChunkPool\": {\"Backend\": \"%s\", \"Reserved\": %zu, \"PeakReserved\": %zu, \"Cached\": %zu, "
+                 "\"Live\": %zu, \"PeakLive\": %zu, \"Chunks\": %zu}\n}\n",
+                 GetChunkBackendName(p.Backend), p.Reserved, p.PeakReserved, p.Cached, p.Live, p.PeakLive, p.ChunkCount);
+        Out.append(Line);
+        return Out;
+    }
+
+    /**
+     * @brief Write ffGraph::MemoryManagement::MemoryTracker::DumpJSON to a file.
+     *
+     * @return bool - false if the file couldn't be written.
+     */
+    bool DumpJSON(const std::string& Path) const {
+        std::string Content = DumpJSON( );
+        FILE *f = fopen(Path.c_str( ), "w");
+        if (f == nullptr) return false;
+        bool Written = fwrite(Content.data( ), 1, Content.size( ), f) == Content.size( );
+        return (fclose(f) == 0) && Written;
+    }
+
+    /**
+     * @brief File written by the diagnostics window and, when given with -MemoryDump, at exit.
+     */
+    void SetDumpPath(const std::string& Path) { DumpPath = Path; }
+    const std::string& GetDumpPath( ) const { return DumpPath; }
+
+   private:
+    struct Counters {
+        std::atomic<size_t> Live{0};
+        std::atomic<size_t> Peak{0};
+        std::atomic<uint64_t> Allocations{0};
+        std::atomic<uint64_t> Frees{0};
+    };
+
+    Counters Tags[MEMORY_TAG_COUNT];
+    std::string DumpPath = "ffGraph_memory.json";
+};
+
+/**
+ * @brief Tracker shared by the whole application.
+ */
+inline MemoryTracker& GetMemoryTracker( ) {
+    static MemoryTracker Tracker;
+    return Tracker;
+}
+
+/**
+ * @brief Tag given to the ffGraph::Array allocations of the calling thread.
+ */
+inline MemoryTag& CurrentMemoryTagSlot( ) {
+    static thread_local MemoryTag Current = MEMORY_TAG_GEOMETRY;
+    return Current;
+}
+
+/**
+ * @brief Tag the ffGraph::Array allocations of the calling thread until the end of the scope.
+ */
+class MemoryTagScope {
+   public:
+    explicit MemoryTagScope(MemoryTag Tag) : Previous(CurrentMemoryTagSlot( )) { CurrentMemoryTagSlot( ) = Tag; }
+    ~MemoryTagScope( ) { CurrentMemoryTagSlot( ) = Previous; }
+
+    MemoryTagScope(const MemoryTagScope&) = delete;
+    MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+   private:
+    MemoryTag Previous;
+};
+
+}    // namespace MemoryManagement
+}    // namespace ffGraph
+
+#endif    // MEMORY_TRACKER_H_
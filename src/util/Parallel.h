@@ -0,0 +1,169 @@
+/**
+ * @file Parallel.h
+ * @brief Minimal fork/join helpers used by the import kernels, run on a pool of threads created once.
+ */
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ffGraph {
+
+/**
+ * @brief Default number of elements under which ffGraph::ParallelFor stays on the calling thread.
+ */
+constexpr size_t ParallelForDefaultGrain = 16384;
+
+/**
+ * @brief Number of worker threads ffGraph::ParallelFor is allowed to use.
+ *
+ * @return size_t - std::thread::hardware_concurrency(), or 1 when it is unknown.
+ */
+inline size_t GetParallelWorkerCount( ) {
+    unsigned int n = std::thread::hardware_concurrency( );
+    return (n == 0) ? 1 : (size_t)n;
+}
+
+/**
+ * @brief Threads running the ranges of ffGraph::ParallelFor. They are started once and wait for work, instead
+ * of being created and joined by every call.
+ */
+class WorkerPool {
+   public:
+    explicit WorkerPool(size_t WorkerCount) {
+        for (size_t i = 0; i < WorkerCount; ++i)
+            Workers.emplace_back([this]( ) { Work( ); });
+    }
+
+    ~WorkerPool( ) {
+        {
+            std::lock_guard<std::mutex> Guard(Lock);
+            Stopping = true;
+        }
+        Wake.notify_all( );
+        for (auto& Worker : Workers) Worker.join( );
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void Push(std::function<void( )> Task) {
+        {
+            std::lock_guard<std::mutex> Guard(Lock);
+            Tasks.push_back(std::move(Task));
+        }
+        Wake.notify_one( );
+    }
+
+    /**
+     * @brief Run one queued task on the calling thread.
+     *
+     * @return bool - false if none was queued.
+     */
+    bool RunOne( ) {
+        std::function<void( )> Task;
+        {
+            std::lock_guard<std::mutex> Guard(Lock);
+            if (Tasks.empty( )) return false;
+            Task = std::move(Tasks.front( ));
+            Tasks.pop_front( );
+        }
+        Task( );
+        return true;
+    }
+
+   private:
+    void Work( ) {
+        for (;;) {
+            std::function<void( )> Task;
+            {
+                std::unique_lock<std::mutex> Guard(Lock);
+                Wake.wait(Guard, [this]( ) { return Stopping || !Tasks.empty( ); });
+                if (Tasks.empty( )) return;
+                Task = std::move(Tasks.front( ));
+                Tasks.pop_front( );
+            }
+            Task( );
+        }
+    }
+
+    std::vector<std::thread> Workers;
+    std::mutex Lock;
+    std::condition_variable Wake;
+    std::deque<std::function<void( )>> Tasks;
+    bool Stopping = false;
+};
+
+/**
+ * @brief Pool shared by every ffGraph::ParallelFor, the calling thread being the last worker.
+ */
+inline WorkerPool& GetWorkerPool( ) {
+    static WorkerPool Pool(GetParallelWorkerCount( ) - 1);
+    return Pool;
+}
+
+/**
+ * @brief Split [0, Count) in contiguous ranges and run "func(Begin, End)" on each of them in parallel.
+ * The calling thread takes the first range, then runs queued ranges until its own are done, so a
+ * ParallelFor nested in another one can't wait on busy workers. The function is handed whole ranges so that
+ * the inner loop stays visible to the compiler and can be vectorized.
+ *
+ * @param Count [in] - Number of elements to process.
+ * @param func [in] - Callable with the signature void(size_t Begin, size_t End).
+ * @param Grain [in] - Minimum number of elements per range.
+ */
+template <typename Func>
+inline void ParallelFor(size_t Count, Func&& func, size_t Grain = ParallelForDefaultGrain) {
+    if (Count == 0) return;
+    Grain = std::max(Grain, (size_t)1);
+    size_t RangeCount = std::min(GetParallelWorkerCount( ), (Count + Grain - 1) / Grain);
+
+    if (RangeCount <= 1) {
+        func((size_t)0, Count);
+        return;
+    }
+    size_t RangeSize = (Count + RangeCount - 1) / RangeCount;
+    WorkerPool& Pool = GetWorkerPool( );
+    std::mutex DoneLock;
+    std::condition_variable Done;
+    size_t Pending = 0;
+
+    for (size_t r = 1; r < RangeCount; ++r) {
+        size_t Begin = r * RangeSize;
+        size_t End = std::min(Count, Begin + RangeSize);
+        if (Begin >= End) break;
+        {
+            std::lock_guard<std::mutex> Guard(DoneLock);
+            Pending++;
+        }
+        Pool.Push([&func, &DoneLock, &Done, &Pending, Begin, End]( ) {
+            func(Begin, End);
+            // Nothing of the caller is touched once the lock is released, it may be gone.
+            std::lock_guard<std::mutex> Guard(DoneLock);
+            if (--Pending == 0) Done.notify_all( );
+        });
+    }
+    func((size_t)0, std::min(Count, RangeSize));
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> Guard(DoneLock);
+            if (Pending == 0) break;
+        }
+        if (!Pool.RunOne( )) {
+            std::unique_lock<std::mutex> Guard(DoneLock);
+            Done.wait_for(Guard, std::chrono::milliseconds(1), [&Pending]( ) { return Pending == 0; });
+        }
+    }
+}
+
+}    // namespace ffGraph
+
+#endif    // PARALLEL_H_
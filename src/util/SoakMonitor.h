@@ -0,0 +1,166 @@
+/**
+ * @file SoakMonitor.h
+ * @brief Samples taken during a soak test and detection of the metrics growing with the number of plots.
+ */
+#ifndef SOAK_MONITOR_H_
+#define SOAK_MONITOR_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace ffGraph {
+
+enum SoakMetric : uint8_t {
+    // @brief Resident set size of the process.
+    SOAK_METRIC_RSS,
+    // @brief Bytes handed out by the arenas of the chunk pool.
+    SOAK_METRIC_ARENA,
+    // @brief Bytes used by VMA allocations.
+    SOAK_METRIC_VMA,
+    SOAK_METRIC_VMA_ALLOCATIONS,
+    SOAK_METRIC_GEOMETRY_QUEUE,
+    SOAK_METRIC_PAYLOAD_QUEUE,
+    // @brief Mean frame time since the previous sample, in milliseconds.
+    SOAK_METRIC_FRAME_TIME,
+    SOAK_METRIC_COUNT
+};
+
+struct SoakMetricInfos {
+    const char *Name;
+    // @brief Growth over the test below which a metric never fails, so that noise on small values is ignored.
+    double NoiseFloor;
+};
+
+inline const SoakMetricInfos& GetSoakMetricInfos(SoakMetric Metric) {
+    static const SoakMetricInfos Infos[SOAK_METRIC_COUNT] = {
+        {"RSS", 4. * 1024. * 1024.},   {"ArenaLive", 1024. * 1024.}, {"VmaUsed", 1024. * 1024.}, {"VmaAllocations", 4.},
+        {"GeometryQueue", 4.},         {"PayloadQueue", 2.},         {"FrameTimeMs", 2.}};
+    return Infos[Metric];
+}
+
+struct SoakSample {
+    double Values[SOAK_METRIC_COUNT] = { };
+};
+
+/**
+ * @brief Resident set size of the process, read from /proc/self/statm. 0 where it isn't available.
+ */
+inline size_t ReadResidentBytes( ) {
+#if defined(__linux__)
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f == nullptr) return 0;
+    unsigned long Size = 0, Resident = 0;
+    int Read = fscanf(f, "%lu %lu", &Size, &Resident);
+    fclose(f);
+    return (Read == 2) ? (size_t)Resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Keeps one ffGraph::SoakSample per plot replacement and fits a line through every metric once the
+ * warm-up is over. A metric whose fitted growth over the test goes beyond a fraction of its initial value is
+ * reported as unbounded.
+ */
+class SoakMonitor {
+   public:
+    void AddSample(const SoakSample& Sample) { Samples.push_back(Sample); }
+    size_t SampleCount( ) const { return Samples.size( ); }
+
+    /**
+     * @brief Fit every metric and write a human readable report.
+     *
+     * @param Threshold [in] - Largest accepted growth, relative to the value at the end of the warm-up.
+     * @param Report [out] - One line per metric.
+     *
+     * @return bool - false if one of the metrics grows beyond Threshold, or if there are too few samples to
+     * tell.
+     */
+    bool Analyze(double Threshold, std::string& Report) const {
+        // The first tenth of the samples is the warm-up : caches, pools and pipelines being filled.
+        size_t First = Samples.size( ) / 10;
+        size_t n = Samples.size( ) - First;
+        char Line[256];
+
+        Report.clear( );
+        if (n < 8) {
+            snprintf(Line, sizeof(Line), "Soak : inconclusive, %zu samples, at least 8 are needed after the warm-up.\n",
+                     n);
+            Report.append(Line);
+            return false;
+        }
+        bool Passed = true;
+        snprintf(Line, sizeof(Line), "Soak : %zu samples (%zu of warm-up), threshold %.1f %%\n", Samples.size( ), First,
+                 Threshold * 100.);
+        Report.append(Line);
+        for (uint8_t m = 0; m < SOAK_METRIC_COUNT; ++m) {
+            const SoakMetricInfos& Infos = GetSoakMetricInfos((SoakMetric)m);
+            double Slope = FitSlope(m, First);
+            double Growth = Slope * (double)(n - 1);
+            double Baseline = Mean(m, First, First + n / 4 + 1);
+            bool Grows = Growth > Infos.NoiseFloor && Growth > Threshold * Baseline;
+
+            snprintf(Line, sizeof(Line), "  %-15s start %14.2f end %14.2f slope %12.4f/plot growth %+8.2f %% %s\n",
+                     Infos.Name, Baseline, Samples.back( ).Values[m], Slope,
+                     (Baseline > 0.) ? Growth / Baseline * 100. : 0., (Grows) ? "UNBOUNDED" : "ok");
+            Report.append(Line);
+            Passed = Passed && !Grows;
+        }
+        return Passed;
+    }
+
+    /**
+     * @brief Write every sample as CSV, one line per plot replacement.
+     *
+     * @return bool - false if the file couldn't be written.
+     */
+    bool WriteSamples(const std::string& Path) const {
+        FILE *f = fopen(Path.c_str( ), "w");
+        if (f == nullptr) return false;
+        fprintf(f, "Plot");
+        for (uint8_t m = 0; m < SOAK_METRIC_COUNT; ++m) fprintf(f, ",%s", GetSoakMetricInfos((SoakMetric)m).Name);
+        fprintf(f, "\n");
+        for (size_t i = 0; i < Samples.size( ); ++i) {
+            fprintf(f, "%zu", i);
+            for (uint8_t m = 0; m < SOAK_METRIC_COUNT; ++m) fprintf(f, ",%.3f", Samples[i].Values[m]);
+            fprintf(f, "\n");
+        }
+        return fclose(f) == 0;
+    }
+
+   private:
+    double Mean(uint8_t Metric, size_t Begin, size_t End) const {
+        double Sum = 0.;
+        if (End > Samples.size( )) End = Samples.size( );
+        for (size_t i = Begin; i < End; ++i) Sum += Samples[i].Values[Metric];
+        return (End > Begin) ? Sum / (double)(End - Begin) : 0.;
+    }
+
+    /**
+     * @brief Least squares slope of a metric against the sample index, from sample First to the last one.
+     */
+    double FitSlope(uint8_t Metric, size_t First) const {
+        double n = (double)(Samples.size( ) - First);
+        double MeanX = (n - 1.) / 2.;
+        double MeanY = Mean(Metric, First, Samples.size( ));
+        double Covariance = 0., Variance = 0.;
+        for (size_t i = First; i < Samples.size( ); ++i) {
+            double dx = (double)(i - First) - MeanX;
+            Covariance += dx * (Samples[i].Values[Metric] - MeanY);
+            Variance += dx * dx;
+        }
+        return (Variance > 0.) ? Covariance / Variance : 0.;
+    }
+
+    std::vector<SoakSample> Samples;
+};
+
+}    // namespace ffGraph
+
+#endif    // SOAK_MONITOR_H_